@@ -1,5 +1,7 @@
 #include <iostream>             // cout, cerr
 #include <cstdlib>              // EXIT_FAILURE
+#include <string>               // window title
+#include <algorithm>            // max
 #include <GL/glew.h>            // GLEW library
 #include <GLFW/glfw3.h>         // GLFW library
 
@@ -13,6 +15,8 @@
 
 // objects and light shader
 #include "shader.h"
+#include "frameUniformBuffer.h"
+#include "glStateCache.h"
 
 // shapes
 #include "plane.h"
@@ -21,6 +25,21 @@
 #include "cylinder.h"
 #include "torus.h"
 #include "sphere.h"
+#include "meshRegistry.h"
+#include "instanceBuffer.h"
+#include "geometryArena.h"
+#include "lodChain.h"
+#include "frustumCulling.h"
+#include "sceneGraph.h"
+#include "gpuCulling.h"
+#include "depthPyramid.h"
+#include "meshOptimizer.h"
+#include "bakedMesh.h"
+#include "renderQueue.h"
+#include "materialLibrary.h"
+#include "textureBaker.h"
+#include "layoutBenchmark.h"
+#include "threadPool.h"
 
 // image processing (for textures)
 #define STB_IMAGE_IMPLEMENTATION
@@ -42,49 +61,88 @@ namespace
 	const int WINDOW_WIDTH = 800;
 	const int WINDOW_HEIGHT = 600;
 
-	// VAOs and VBOs for objects
-	struct GLMesh
+	// Static meshes used by the scene, built once at startup
+	// (parametric ones have all levels of detail, from the finest one)
+	struct SceneMeshes
 	{
-		GLuint vaoTable;
-		GLuint vboTable;
-		GLuint nVertices; // for table (2D plane)
-		GLuint vaoCupcakeFrosting;
-		GLuint vboCupcakeFrosting;
-		GLuint vaoCupcakeCake;
-		GLuint vboCupcakeCake;
-		GLuint vaoDonut;
-		GLuint vboDonut;
-		GLuint vaoIceCreamBar;
-		GLuint vboIceCreamBar;
-		GLuint vaoIceCreamStick;
-		GLuint vboIceCreamStick;
-		GLuint vaoCottonCandyCart;
-		GLuint vboCottonCandyCart;
-		GLuint vaoCottonCandyBall;
-		GLuint vboCottonCandyBall;
-		GLuint vaoCottonCandyTire;
-		GLuint vboCottonCandyTire;
-		GLuint vaoCottonCandyTop;
-		GLuint vboCottonCandyTop;
+		std::vector<const static_meshes_3D::StaticMesh3D*> cupcakeFrosting;
+		std::vector<const static_meshes_3D::StaticMesh3D*> cupcakeCake;
+		std::vector<const static_meshes_3D::StaticMesh3D*> donut;
+		const static_meshes_3D::Cube* cube = nullptr; // ice cream bar, ice cream stick and cotton candy cart
+		std::vector<const static_meshes_3D::StaticMesh3D*> cottonCandyTire;
+		std::vector<const static_meshes_3D::StaticMesh3D*> cottonCandyBall;
+		std::vector<const static_meshes_3D::StaticMesh3D*> cottonCandyTop;
+	};
+
+	// Object of the scene - which mesh is drawn, with which material and where (relative to its scene graph parent)
+	struct SceneObject
+	{
+		int lodChain; // index of the LOD chain (meshes in the geometry arena) in scene LOD chains
+		int material; // material of the object (layer of material texture array)
+		glm::mat4 model; // model matrix of the object
 	};
 
 	// Main GLFW window
 	GLFWwindow* window = nullptr;
-	// object mesh data
-	GLMesh mesh;
+	// static meshes generated for the arena (freed once they are added to it)
+	static_meshes_3D::MeshRegistry meshRegistry;
+	SceneMeshes sceneMeshes;
+	// all scene geometry in one vertex/index buffer, drawn with multi-draw-indirect
+	static_meshes_3D::GeometryArena sceneArena;
+	// draw packets of a frame, sorted by state before drawing
+	static_meshes_3D::RenderQueue renderQueue(sceneArena);
+	std::vector<static_meshes_3D::LodChain> sceneLodChains;
+	// all placed objects, with their world space boxes in a bounding volume hierarchy (for culling, picking and proximity)
+	static_meshes_3D::SceneGraph sceneGraph;
+	std::vector<int> visibleNodes;
+	// objects culled and drawn by compute shader instead (toggled with G, or from start with --gpu-culling)
+	static_meshes_3D::GpuCulling gpuCulling(sceneArena);
+	const char* const GPU_CULLING_OPTION = "--gpu-culling";
+	bool isGpuCulling = false;
+	// objects hidden behind large occluders are culled on the GPU too (toggled with O), occluders are drawn
+	// depth-only first and reduced to a depth pyramid the culling shader tests against
+	static_meshes_3D::DepthPyramid occluderDepth;
+	static_meshes_3D::RenderQueue occluderQueue(sceneArena);
+	std::vector<int> occluderNodes;
+	const float OCCLUDER_MIN_RADIUS = 1.0f; // half diagonal of world space box of the smallest occluder
+	bool isOcclusionCulling = false;
+	// depth-only prepass before shading, so that every pixel is shaded once (toggled with Z, or from start with --depth-prepass)
+	static_meshes_3D::RenderQueue prepassQueue(sceneArena);
+	const char* const DEPTH_PREPASS_OPTION = "--depth-prepass";
+	bool isDepthPrepass = false;
+	// benchmark of shading with and without the prepass, run instead of the application (--benchmark-prepass)
+	const char* const PREPASS_BENCHMARK_OPTION = "--benchmark-prepass";
+	const int NUM_BENCHMARK_FRAMES = 100;
+	bool isPrepassBenchmark = false;
+	// query counting fragment shader invocations of the shading pass (0 for none)
+	GLuint shadingInvocationsQuery = 0;
+	// vertex cache efficiency of scene meshes before / after optimizing them
+	static_meshes_3D::mesh_optimizer::VertexCacheStatistics vertexCacheBefore;
+	static_meshes_3D::mesh_optimizer::VertexCacheStatistics vertexCacheAfter;
+	// triangles and objects drawn by the last frame (with levels of detail and culling applied)
+	GLuint numTrianglesDrawn = 0;
+	int numObjectsDrawn = 0;
+	// optional model file (--model <path.obj>) placed in the middle of the table, loaded through its baked mesh
+	const char* const MODEL_OPTION = "--model";
+	std::string modelPath;
+	// lamp is drawn using the table mesh
+	int lampMeshHandle = static_meshes_3D::GeometryArena::INVALID_MESH_HANDLE;
 	// Shader program
 	GLuint programId;
-	// textures
-	GLuint tableTexture;
-	GLuint cupcakeFrostingTexture;
-	GLuint cupcakeCakeTexture;
-	GLuint donutTexture;
-	GLuint iceCreamBarTexture;
-	GLuint iceCreamStickTexture;
-	GLuint cottonCandyCartTexture;
-	GLuint cottonCandyBallTexture;
-	GLuint cottonCandyTireTexture;
-	GLuint cottonCandyTopTexture;
+	// worker threads for loading
+	static_meshes_3D::ThreadPool threadPool;
+	// materials of all objects, packed in one texture array (decoded on the thread pool)
+	static_meshes_3D::MaterialLibrary materials(threadPool);
+	int tableMaterial;
+	int cupcakeFrostingMaterial;
+	int cupcakeCakeMaterial;
+	int donutMaterial;
+	int iceCreamBarMaterial;
+	int iceCreamStickMaterial;
+	int cottonCandyCartMaterial;
+	int cottonCandyBallMaterial;
+	int cottonCandyTireMaterial;
+	int cottonCandyTopMaterial;
 	//glm::vec2 UVScale(5.0f, 5.0f);
 	// 
 	// light properties
@@ -93,6 +151,9 @@ namespace
 	glm::vec3 lightPosition(0.0f, 7.0f, 0.0f);
 	glm::vec3 lightScale(0.5f);
 
+	// view, projection and light shared by object and lamp programs (uploaded once per frame)
+	FrameUniformBuffer frameUniforms;
+
 	// camera
 	Camera camera(glm::vec3(0.0f, 0.0f, 0.0f));
 	float lastX = WINDOW_WIDTH / 2.0f;
@@ -114,76 +175,136 @@ void processInput(GLFWwindow* window);
 void mousePositionCallback(GLFWwindow* window, double xPos, double yPos);
 void mouseScrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
-void createMesh(GLMesh& mesh);
-void createAndBindBuffers(GLuint vao, GLuint vbo);
-void destroyMesh(GLMesh& mesh);
-bool createTexture(const char* filepath, GLuint& textureId);
-void destroyTexture(GLuint textureId);
-void render(Shader objectShader, Shader lampShader);
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+bool createSceneMeshes(SceneMeshes& meshes);
+glm::mat4 createModelMatrix(const glm::vec3& translation, float angle, const glm::vec3& axis, const glm::vec3& scale);
+int addOptimizedMesh(const static_meshes_3D::StaticMesh3D& mesh);
+int addLodChain(const std::vector<const static_meshes_3D::StaticMesh3D*>& levels, int numSegments);
+int addLodChain(int meshHandle, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+int addSceneObject(int parent, const SceneObject& object);
+void addModel(const std::string& filepath, int material);
+void createScene();
+void uploadGpuScene();
+bool loadMaterial(const char* filepath, int& material);
+void updateFrameUniforms(const glm::mat4& view, const glm::mat4& projection);
+void showFrameStatistics(GLFWwindow* window, float currentTime);
+void renderOccluders(const Shader& depthShader, const Shader& pyramidShader, const glm::mat4& view);
+void render(const Shader& objectShader, const Shader& lampShader, const Shader& cullShader, const Shader& depthShader, const Shader& pyramidShader);
+void runPrepassBenchmark(const Shader& objectShader, const Shader& lampShader, const Shader& cullShader, const Shader& depthShader, const Shader& pyramidShader);
 bool createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId);
 void destroyShaderProgram(GLuint programId);
 
 
 // the only and only main method
-int main() {
+int main(int argc, char* argv[]) {
+
+	// offline texture baking runs without any window
+	if (argc > 1 && string(argv[1]) == texture_baker::BAKE_OPTION)
+		return texture_baker::run(argc - 2, argv + 2);
 
 	if (!initOpenGL(&window))
 		return EXIT_FAILURE;
 
-	// create the mesh of objects
-	createMesh(mesh);
+	// vertex layout benchmark needs OpenGL context, but no scene
+	if (argc > 1 && string(argv[1]) == layout_benchmark::BENCHMARK_OPTION)
+	{
+		const auto exitCode = layout_benchmark::run();
+		glfwTerminate();
+		return exitCode;
+	}
 
-	// initialize shader programs
-	Shader objectShader("shaderfiles/object.vs", "shaderfiles/object.fs");
-	Shader lampShader("shaderfiles/lamp.vs", "shaderfiles/lamp.fs");
+	// model to show on the table
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (string(argv[i]) == MODEL_OPTION)
+			modelPath = argv[i + 1];
+	}
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == GPU_CULLING_OPTION)
+			isGpuCulling = true;
+		if (string(argv[i]) == DEPTH_PREPASS_OPTION)
+			isDepthPrepass = true;
+		if (string(argv[i]) == PREPASS_BENCHMARK_OPTION)
+			isPrepassBenchmark = true;
+	}
 
-	// load textures
+	// start decoding textures of materials, meshes are created meanwhile
 	const char* tablePath = "images/table.jpg";
-	if (!createTexture(tablePath, tableTexture))
+	if (!loadMaterial(tablePath, tableMaterial))
 		return EXIT_FAILURE;
 	const char* cupcakeFrostingPath = "images/cupcake_frosting.jpg";
-	if (!createTexture(cupcakeFrostingPath, cupcakeFrostingTexture))
+	if (!loadMaterial(cupcakeFrostingPath, cupcakeFrostingMaterial))
 		return EXIT_FAILURE;
 	const char* cupcakeCakePath = "images/cupcake_cake.jpg";
-	if (!createTexture(cupcakeCakePath, cupcakeCakeTexture))
+	if (!loadMaterial(cupcakeCakePath, cupcakeCakeMaterial))
 		return EXIT_FAILURE;
 	const char* donutPath = "images/donut.jpg";
-	if (!createTexture(donutPath, donutTexture))
+	if (!loadMaterial(donutPath, donutMaterial))
 		return EXIT_FAILURE;
 	const char* iceCreamBarPath = "images/ice_cream_bar.jpg";
-	if (!createTexture(iceCreamBarPath, iceCreamBarTexture))
+	if (!loadMaterial(iceCreamBarPath, iceCreamBarMaterial))
 		return EXIT_FAILURE;
 	const char* iceCreamStickPath = "images/ice_cream_stick.jpg";
-	if (!createTexture(iceCreamStickPath, iceCreamStickTexture))
+	if (!loadMaterial(iceCreamStickPath, iceCreamStickMaterial))
 		return EXIT_FAILURE;
 	const char* cottonCandyCartPath = "images/cotton_candy_cart.jpg";
-	if (!createTexture(cottonCandyCartPath, cottonCandyCartTexture))
+	if (!loadMaterial(cottonCandyCartPath, cottonCandyCartMaterial))
 		return EXIT_FAILURE;
 	const char* cottonCandyBallPath = "images/cotton_candy_ball.jpg";
-	if (!createTexture(cottonCandyBallPath, cottonCandyBallTexture))
+	if (!loadMaterial(cottonCandyBallPath, cottonCandyBallMaterial))
 		return EXIT_FAILURE;
 	const char* cottonCandyTirePath = "images/cotton_candy_tire.jpg";
-	if (!createTexture(cottonCandyTirePath, cottonCandyTireTexture))
+	if (!loadMaterial(cottonCandyTirePath, cottonCandyTireMaterial))
 		return EXIT_FAILURE;
 	const char* cottonCandyTopPath = "images/cotton_candy_top.jpg";
-	if (!createTexture(cottonCandyTopPath, cottonCandyTopTexture))
+	if (!loadMaterial(cottonCandyTopPath, cottonCandyTopMaterial))
 		return EXIT_FAILURE;
 
-	// set textures
+	// create the meshes of objects
+	if (!createSceneMeshes(sceneMeshes))
+		return EXIT_FAILURE;
+
+	// initialize shader programs
+	// (model matrices come from the scene instance buffer)
+	Shader objectShader("shaderfiles/object_instanced.vs", "shaderfiles/object.fs");
+	Shader lampShader("shaderfiles/lamp_instanced.vs", "shaderfiles/lamp.fs");
+	Shader cullShader("shaderfiles/cull_instances.cs");
+	Shader depthShader("shaderfiles/depth_instanced.vs", "shaderfiles/depth.fs");
+	Shader pyramidShader("shaderfiles/depth_pyramid.cs");
+	frameUniforms.createBuffer();
+	objectShader.bindUniformBlock(FrameUniformBuffer::BLOCK_NAME, FrameUniformBuffer::BINDING_POINT);
+	lampShader.bindUniformBlock(FrameUniformBuffer::BLOCK_NAME, FrameUniformBuffer::BINDING_POINT);
+	depthShader.bindUniformBlock(FrameUniformBuffer::BLOCK_NAME, FrameUniformBuffer::BINDING_POINT);
+
+	// occluder depth has the size of the window (recreated by resizeWindow)
+	if (!occluderDepth.createPyramid(WINDOW_WIDTH, WINDOW_HEIGHT))
+		return EXIT_FAILURE;
+
+	// materials show placeholder until their images are decoded
+	if (!materials.createTextureArray())
+		return EXIT_FAILURE;
+
+	// place objects now that both meshes and materials exist
+	createScene();
+	uploadGpuScene();
+
+	// scene meshes live in the arena now, their generated data aren't needed anymore
+	sceneMeshes = SceneMeshes();
+	meshRegistry.clear();
+
+	// material texture array is always bound to texture unit 0
 	objectShader.use();
-	objectShader.setInt("tableTexture", 0);
-	objectShader.setInt("cupcakeFrostingTexture", 1);
-	objectShader.setInt("cupcakeCakeTexture", 2);
-	objectShader.setInt("donutTexture", 3);
-	objectShader.setInt("iceCreamBarTexture", 4);
-	objectShader.setInt("iceCreamStickTexture", 5);
-	objectShader.setInt("cottonCandyCartTexture", 6);
-	objectShader.setInt("cottonCandyBallTexture", 7);
-	objectShader.setInt("cottonCandyTireTexture", 8);
-	objectShader.setInt("cottonCandyTopTexture", 9);
+	objectShader.setInt("uTextures", 0);
 
 	// Sets the background color of the window to black
-	glClearColor(0.529f, 0.808f, 0.922f, 1.0f);
+	GLStateCache::getInstance().clearColor(0.529f, 0.808f, 0.922f, 1.0f);
+
+	// prepass benchmark renders the scene, but skips the render loop
+	if (isPrepassBenchmark) {
+		runPrepassBenchmark(objectShader, lampShader, cullShader, depthShader, pyramidShader);
+		glfwSetWindowShouldClose(window, true);
+	}
 
 	// render loop - one frame per iteration
 	while (!glfwWindowShouldClose(window)) {
@@ -196,26 +317,27 @@ int main() {
 		// keyboard/mouse inputs
 		processInput(window);
 
+		// upload textures decoded since last frame
+		materials.update();
+
 		// render this frame
-		render(objectShader, lampShader);
+		render(objectShader, lampShader, cullShader, depthShader, pyramidShader);
+		showFrameStatistics(window, currentTime);
 
 		glfwPollEvents();
 	}
 
-	// de-allocate textures
-	destroyTexture(tableTexture);
-	destroyTexture(cupcakeFrostingTexture);
-	destroyTexture(cupcakeCakeTexture);
-	destroyTexture(donutTexture);
-	destroyTexture(iceCreamBarTexture);
-	destroyTexture(iceCreamStickTexture);
-	destroyTexture(cottonCandyCartTexture);
-	destroyTexture(cottonCandyBallTexture);
-	destroyTexture(cottonCandyTireTexture);
-	destroyTexture(cottonCandyTopTexture);
+	// de-allocate materials
+	materials.deleteLibrary();
 
 	// de-allocate mesh data
-	destroyMesh(mesh); //
+	renderQueue.deleteQueue();
+	occluderQueue.deleteQueue();
+	prepassQueue.deleteQueue();
+	occluderDepth.deletePyramid();
+	gpuCulling.deleteCulling();
+	sceneArena.deleteArena();
+	frameUniforms.deleteBuffer();
 
 	exit(EXIT_SUCCESS);
 }
@@ -248,6 +370,7 @@ bool initOpenGL(GLFWwindow** window)
 	glfwSetCursorPosCallback(*window, mousePositionCallback);
 	glfwSetScrollCallback(*window, mouseScrollCallback);
 	glfwSetMouseButtonCallback(*window, mouseButtonCallback);
+	glfwSetKeyCallback(*window, keyCallback);
 
 	// capture mouse
 	glfwSetInputMode(*window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -272,6 +395,13 @@ bool initOpenGL(GLFWwindow** window)
 void resizeWindow(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
+
+	// occluder depth follows the framebuffer, minimized window (zero size) keeps the old one
+	if (width > 0 && height > 0 && occluderDepth.getWidth() > 0 && !occluderDepth.createPyramid(width, height))
+	{
+		isOcclusionCulling = false;
+		cout << "INFO: Occlusion culling off (occluder depth couldn't be resized)" << endl;
+	}
 }
 
 // process all input - check glfw for keypresses this frame for camera movement
@@ -335,162 +465,314 @@ void mouseScrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 // glfw: callback for mouse button events
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-	// no functional requirements for mouse button events at this time
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS)
+		return;
+
+	// cursor is captured, so the object in the middle of the view is picked (along the camera direction in both projections)
+	float distance = 0.0f;
+	const int node = sceneGraph.pick(camera.Position, camera.Front, distance);
+	if (node == static_meshes_3D::SceneGraph::NO_NODE)
+		return;
+
+	// objects close to the picked one
+	const static_meshes_3D::BoundingVolumeHierarchy& hierarchy = sceneGraph.getHierarchy();
+	const int proxy = sceneGraph.getNode(node).proxy;
+	const glm::vec3 center = (hierarchy.getBoundsMin(proxy) + hierarchy.getBoundsMax(proxy)) * 0.5f;
+	std::vector<int> neighbours;
+	sceneGraph.queryNeighbours(center, 1.0f, neighbours);
+	cout << "INFO: Picked object " << node << " at distance " << distance << ", "
+		<< neighbours.size() - 1 << " other objects within 1 unit" << endl;
 }
 
-// create the mesh of triangles
-void createMesh(GLMesh& mesh)
+// glfw: callback for keys toggling render modes (once per press, unlike movement keys polled every frame)
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-	// Vertex data for table
-	GLfloat tableVertices[] = {
-		// Vertex Positions    // texture	// normals
-		-1.0f,  0.0f, -1.0f,   0.0f, 0.0f,	0.0f, 1.0f, 0.0f,
-		 1.0f,  0.0f, -1.0f,   1.0f, 0.0f,	0.0f, 1.0f, 0.0f,
-		 1.0f,  0.0f,  1.0f,   1.0f, 1.0f,	0.0f, 1.0f, 0.0f,
-		 1.0f,  0.0f,  1.0f,   1.0f, 1.0f,	0.0f, 1.0f, 0.0f,
-		-1.0f,  0.0f,  1.0f,   0.0f, 1.0f,	0.0f, 1.0f, 0.0f,
-		-1.0f,  0.0f, -1.0f,   0.0f, 0.0f,	0.0f, 1.0f, 0.0f
-	};
+	if (action != GLFW_PRESS)
+		return;
+
+	// switches between culling on the CPU (scene graph) and in compute shader
+	if (key == GLFW_KEY_G) {
+		isGpuCulling = !isGpuCulling;
+		cout << "INFO: Culling on " << (isGpuCulling ? "GPU" : "CPU") << endl;
+	}
 
-	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerTex = 2;
-
-	// create table mesh
-	mesh.nVertices = sizeof(tableVertices) / (sizeof(tableVertices[0]) * (floatsPerVertex + floatsPerNormal + floatsPerTex));
-	glGenVertexArrays(1, &mesh.vaoTable);
-	glGenBuffers(1, &mesh.vboTable);
-	glBindVertexArray(mesh.vaoTable);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vboTable);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(tableVertices), tableVertices, GL_STATIC_DRAW);
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerTex);
-
-	// Create Vertex Attribute Pointers for vertices and textures
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerTex)));
-	glEnableVertexAttribArray(2);
-
-	createAndBindBuffers(mesh.vaoCupcakeFrosting, mesh.vboCupcakeFrosting);
-	createAndBindBuffers(mesh.vaoCupcakeCake, mesh.vboCupcakeCake);
-	createAndBindBuffers(mesh.vaoDonut, mesh.vboDonut);
-	createAndBindBuffers(mesh.vaoCottonCandyBall, mesh.vboCottonCandyBall);
-	createAndBindBuffers(mesh.vaoCottonCandyCart, mesh.vboCottonCandyCart);
-	createAndBindBuffers(mesh.vaoCottonCandyTire, mesh.vboCottonCandyTire);
-	createAndBindBuffers(mesh.vaoCottonCandyTop, mesh.vboCottonCandyTop);
-	createAndBindBuffers(mesh.vaoIceCreamBar, mesh.vboIceCreamBar);
-	createAndBindBuffers(mesh.vaoIceCreamStick, mesh.vboIceCreamStick);
+	// switches occlusion culling (done by the compute shader only, so it turns GPU culling on)
+	if (key == GLFW_KEY_O) {
+		isOcclusionCulling = !isOcclusionCulling;
+		if (isOcclusionCulling)
+			isGpuCulling = true;
+		cout << "INFO: Occlusion culling " << (isOcclusionCulling ? "on (culling on GPU)" : "off") << endl;
+	}
+
+	// switches depth prepass, which leaves shading only to the nearest fragment of every pixel
+	if (key == GLFW_KEY_Z) {
+		isDepthPrepass = !isDepthPrepass;
+		cout << "INFO: Depth prepass " << (isDepthPrepass ? "on" : "off") << endl;
+	}
 }
 
-void createAndBindBuffers(GLuint vao, GLuint vbo)
+// generate every static mesh of the scene once, createScene adds them to the arena
+bool createSceneMeshes(SceneMeshes& meshes)
 {
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	// meshes are generated in parallel on the worker threads, nothing is uploaded - only the arena gets drawn
+	// every level halves the segments of the previous one
+	meshRegistry.beginBatch(threadPool);
+	for (int level = 0; level < static_meshes_3D::LodChain::DEFAULT_NUM_LEVELS; level++)
+	{
+		const int segments = static_meshes_3D::LodChain::getLevelSegments(50, level);
+		const int ballSegments = static_meshes_3D::LodChain::getLevelSegments(25, level);
+		meshes.cupcakeFrosting.push_back(&meshRegistry.getCone(1.25, segments, 1.25, true, true, true));
+		meshes.cupcakeCake.push_back(&meshRegistry.getCylinder(1.25, segments, 1.25, true, true, true));
+		meshes.donut.push_back(&meshRegistry.getTorus(segments, segments, 1, 0.5, true, true, true));
+		meshes.cottonCandyTire.push_back(&meshRegistry.getCylinder(2, segments, 0.5, true, true, true));
+		meshes.cottonCandyBall.push_back(&meshRegistry.getSphere(1.25, ballSegments, ballSegments, true, true, true));
+		meshes.cottonCandyTop.push_back(&meshRegistry.getCylinder(1, segments, 1, true, true, true));
+	}
+	meshes.cube = &meshRegistry.getCube({ 1.0f, 1.0f, 1.0f, 1.0f }, true, true, true);
+	return meshRegistry.endBatch();
 }
 
-// de-allocate the mesh data
-void destroyMesh(GLMesh& mesh)
+// model matrix from translation, rotation and scale
+glm::mat4 createModelMatrix(const glm::vec3& translation, float angle, const glm::vec3& axis, const glm::vec3& scale)
 {
-	glDeleteVertexArrays(1, &mesh.vaoTable);
-	glDeleteBuffers(1, &mesh.vboTable);
-	glDeleteVertexArrays(1, &mesh.vaoCupcakeFrosting);
-	glDeleteBuffers(1, &mesh.vboCupcakeFrosting);
-	glDeleteVertexArrays(1, &mesh.vaoCupcakeCake);
-	glDeleteBuffers(1, &mesh.vboCupcakeCake);
-	glDeleteVertexArrays(1, &mesh.vaoDonut);
-	glDeleteBuffers(1, &mesh.vboDonut);
-	glDeleteVertexArrays(1, &mesh.vaoCottonCandyBall);
-	glDeleteBuffers(1, &mesh.vboCottonCandyBall);
-	glDeleteVertexArrays(1, &mesh.vaoCottonCandyCart);
-	glDeleteBuffers(1, &mesh.vboCottonCandyCart);
-	glDeleteVertexArrays(1, &mesh.vaoCottonCandyTire);
-	glDeleteBuffers(1, &mesh.vboCottonCandyTire);
-	glDeleteVertexArrays(1, &mesh.vaoCottonCandyTop);
-	glDeleteBuffers(1, &mesh.vboCottonCandyTop);
-	glDeleteVertexArrays(1, &mesh.vaoIceCreamBar);
-	glDeleteBuffers(1, &mesh.vboIceCreamBar);
-	glDeleteVertexArrays(1, &mesh.vaoIceCreamStick);
-	glDeleteBuffers(1, &mesh.vboIceCreamStick);
+	return glm::translate(translation) * glm::rotate(angle, axis) * glm::scale(scale);
 }
 
-bool createTexture(const char* filepath, GLuint& textureId)
+// reorder triangles and vertices of the mesh for the vertex cache and add it to the arena
+int addOptimizedMesh(const static_meshes_3D::StaticMesh3D& mesh)
 {
-	int width, height, channels;
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* image = stbi_load(filepath, &width, &height, &channels, 0);
-
-	if (image) {
-
-		// generate texture and bind for use
-		glGenTextures(1, &textureId);
-		glBindTexture(GL_TEXTURE_2D, textureId);
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		if (channels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		else if (channels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			cout << "Not implemented to handle image with " << channels << " channels" << endl;
-			return false;
-		}
+	static_meshes_3D::MeshData meshData;
+	mesh.getTriangleList(meshData);
+
+	static_meshes_3D::mesh_optimizer::VertexCacheStatistics before, after;
+	static_meshes_3D::mesh_optimizer::optimizeMesh(meshData, &before, &after);
+	vertexCacheBefore += before;
+	vertexCacheAfter += after;
+	return sceneArena.addMesh(meshData);
+}
 
-		glGenerateMipmap(GL_TEXTURE_2D);
+// upload all levels of detail of a mesh to the arena (levels clamped to the same mesh are added once)
+int addLodChain(const std::vector<const static_meshes_3D::StaticMesh3D*>& levels, int numSegments)
+{
+	static_meshes_3D::LodChain lodChain(static_meshes_3D::LodChain::getScreenRadiusForSegments(numSegments));
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		if (level > 0 && levels[level] == levels[level - 1])
+			break;
+		lodChain.addLevel(addOptimizedMesh(*levels[level]), levels[level]->getBoundsMin(), levels[level]->getBoundsMax(), levels[level]->getBoundingSphereRadius());
+	}
 
-		// release image and texture from use
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0);
+	sceneLodChains.push_back(lodChain);
+	return static_cast<int>(sceneLodChains.size()) - 1;
+}
 
-		// image loaded successfully
-		return true;
-	}
-	else {
-		std::cout << "Failed to load texture" << std::endl;
+// add mesh already in the arena as LOD chain with only one level
+int addLodChain(int meshHandle, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	static_meshes_3D::LodChain lodChain;
+	lodChain.addLevel(meshHandle, boundsMin, boundsMax);
+	sceneLodChains.push_back(lodChain);
+	return static_cast<int>(sceneLodChains.size()) - 1;
+}
+
+// upload model from its baked mesh (baked first, if needed) and stand it in the middle of the table
+void addModel(const std::string& filepath, int material)
+{
+	static_meshes_3D::BakedMesh bakedMesh;
+	if (!bakedMesh.openOrBake(filepath, &threadPool))
+		return;
+
+	// vertices and indices go from the mapped file straight to the arena buffers
+	const int meshHandle = sceneArena.addMesh(bakedMesh.getVertices(), bakedMesh.getNumVertices(), bakedMesh.getIndices(), bakedMesh.getNumIndices());
+	const glm::vec3 boundsMin = bakedMesh.getBoundsMin();
+	const glm::vec3 boundsMax = bakedMesh.getBoundsMax();
+	const int modelLod = addLodChain(meshHandle, boundsMin, boundsMax);
+
+	// largest side of the model becomes 2 units long, bottom of the model touches the table
+	const glm::vec3 size = boundsMax - boundsMin;
+	const float scale = 2.0f / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+	const glm::vec3 bottomCenter((boundsMin.x + boundsMax.x) * 0.5f, boundsMin.y, (boundsMin.z + boundsMax.z) * 0.5f);
+	const glm::mat4 model = glm::translate(glm::vec3(0.0f, -1.0f, 0.0f)) * glm::scale(glm::vec3(scale)) * glm::translate(-bottomCenter);
+	addSceneObject(static_meshes_3D::SceneGraph::NO_NODE, { modelLod, material, model });
+}
+
+// add object to the scene graph, with bounds of its LOD chain
+int addSceneObject(int parent, const SceneObject& object)
+{
+	const static_meshes_3D::LodChain& lodChain = sceneLodChains[object.lodChain];
+	return sceneGraph.addObject(parent, object.model, object.lodChain, object.material, lodChain.getBoundsMin(), lodChain.getBoundsMax(), lodChain.getBoundingSphereRadius());
+}
+
+// upload scene geometry to the arena, place every object and record its draw command
+void createScene()
+{
+	// TABLE (2D plane)
+	static_meshes_3D::MeshData tableData;
+	tableData.vertices = {
+		// Vertex Positions					// texture				// normals
+		{ glm::vec3(-1.0f, 0.0f, -1.0f),	glm::vec2(0.0f, 0.0f),	glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3( 1.0f, 0.0f, -1.0f),	glm::vec2(1.0f, 0.0f),	glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3( 1.0f, 0.0f,  1.0f),	glm::vec2(1.0f, 1.0f),	glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f,  1.0f),	glm::vec2(0.0f, 1.0f),	glm::vec3(0.0f, 1.0f, 0.0f) }
+	};
+	tableData.indices = { 0, 1, 2, 2, 3, 0 };
+
+	// every distinct mesh is uploaded to the arena only once, table and cube have just one level of detail
+	sceneLodChains.clear();
+	const int tableMeshHandle = sceneArena.addMesh(tableData);
+	const int tableLod = addLodChain(tableMeshHandle, glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 1.0f));
+	const int cubeLod = addLodChain(addOptimizedMesh(*sceneMeshes.cube), sceneMeshes.cube->getBoundsMin(), sceneMeshes.cube->getBoundsMax());
+	const int cupcakeFrostingLod = addLodChain(sceneMeshes.cupcakeFrosting, 50);
+	const int cupcakeCakeLod = addLodChain(sceneMeshes.cupcakeCake, 50);
+	const int donutLod = addLodChain(sceneMeshes.donut, 50);
+	const int cottonCandyTireLod = addLodChain(sceneMeshes.cottonCandyTire, 50);
+	const int cottonCandyBallLod = addLodChain(sceneMeshes.cottonCandyBall, 25);
+	const int cottonCandyTopLod = addLodChain(sceneMeshes.cottonCandyTop, 50);
+	lampMeshHandle = tableMeshHandle;
+
+	const SceneObject objects[] = {
+		// TABLE (2D plane)
+		{ tableLod, tableMaterial, createModelMatrix(glm::vec3(0.0f, -1.0f, 0.0f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(7.0f, 1.0f, 7.0f)) },
+		// CUPCAKE - FROSTING (Cone)
+		{ cupcakeFrostingLod, cupcakeFrostingMaterial, createModelMatrix(glm::vec3(0.0f, 0.9f, 3.5f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f)) },
+		// CUPCAKE - CAKE (Cylinder)
+		{ cupcakeCakeLod, cupcakeCakeMaterial, createModelMatrix(glm::vec3(0.0f, -0.35f, 3.5f), 0.0f, glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f)) },
+		// DONUT (Torus)
+		{ donutLod, donutMaterial, createModelMatrix(glm::vec3(0.0f, -0.5f, -3.5f), 1.5708f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f)) },
+		// ICE CREAM BAR (Cube)
+		{ cubeLod, iceCreamBarMaterial, createModelMatrix(glm::vec3(3.5f, -0.495f, 0.0f), 0.7854f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(2.0f, 1.0f, 3.0f)) },
+		// ICE CREAM STICK (Cube), a third the size of the ice cream bar
+		{ cubeLod, iceCreamStickMaterial, createModelMatrix(glm::vec3(4.85f, -0.495f, 1.35f), 0.7854f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(2.0f / 3.0f, 1.0f / 3.0f, 3.0f / 3.0f)) }
+	};
+
+	// parts of the cotton candy cart are grouped, so that the whole cart moves together
+	const SceneObject cottonCandyCartParts[] = {
+		// COTTON CANDY CART (Cube)
+		{ cubeLod, cottonCandyCartMaterial, createModelMatrix(glm::vec3(-3.5f, -0.120f, 0.0f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.75f, 1.75f, 1.75f)) },
+		// COTTON CANDY TIRE - FRONT (Cylinder)
+		{ cottonCandyTireLod, cottonCandyTireMaterial, createModelMatrix(glm::vec3(-2.56f, -0.5f, 0.75f), 1.5708f, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.25f, 0.25f, 0.25f)) },
+		// COTTON CANDY TIRE - BACK (Cylinder)
+		{ cottonCandyTireLod, cottonCandyTireMaterial, createModelMatrix(glm::vec3(-4.44f, -0.5f, 0.75f), 1.5708f, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.25f, 0.25f, 0.25f)) },
+		// COTTON CANDY BALL (Sphere)
+		{ cottonCandyBallLod, cottonCandyBallMaterial, createModelMatrix(glm::vec3(-3.5f, 1.7f, 0.0f), 3.14159f, glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f)) },
+		// COTTON CANDY TOP (Cylinder)
+		{ cottonCandyTopLod, cottonCandyTopMaterial, createModelMatrix(glm::vec3(-3.5f, 3.0f, 0.0f), 0.0f, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.25f, 0.25f, 0.25f)) }
+	};
+
+	sceneGraph.clear();
+	for (const SceneObject& object : objects)
+		addSceneObject(static_meshes_3D::SceneGraph::NO_NODE, object);
+	const int cottonCandyCart = sceneGraph.addGroup(static_meshes_3D::SceneGraph::NO_NODE, glm::mat4(1.0f));
+	for (const SceneObject& part : cottonCandyCartParts)
+		addSceneObject(cottonCandyCart, part);
+
+	if (!modelPath.empty())
+		addModel(modelPath, cottonCandyCartMaterial);
+
+	cout << "INFO: Geometry arena: " << sceneArena.getNumVerticesUsed() << " vertices, "
+		<< sceneArena.getNumIndicesUsed() << " indices, " << sceneGraph.getNumObjects() << " objects" << endl;
+	cout << "INFO: Vertex cache (FIFO " << static_meshes_3D::mesh_optimizer::DEFAULT_CACHE_SIZE << "): ACMR "
+		<< vertexCacheBefore.getACMR() << " -> " << vertexCacheAfter.getACMR() << ", ATVR "
+		<< vertexCacheBefore.getATVR() << " -> " << vertexCacheAfter.getATVR() << endl;
+}
+
+// upload all objects of the scene graph for culling in compute shader (objects don't move, so it's done once)
+void uploadGpuScene()
+{
+	sceneGraph.update();
+	std::vector<static_meshes_3D::GpuCulling::Object> objects;
+	occluderNodes.clear();
+	for (int i = 0; i < sceneGraph.getNumNodes(); i++) {
+		const static_meshes_3D::SceneNode& node = sceneGraph.getNode(i);
+		if (node.lodChain == static_meshes_3D::SceneGraph::NO_NODE)
+			continue;
+		objects.push_back({ node.worldTransform, node.lodChain, node.material });
+
+		// only large objects hide enough to be worth drawing twice
+		glm::vec3 worldMin, worldMax;
+		static_meshes_3D::BoundingVolumeHierarchy::transformBox(node.boundsMin, node.boundsMax, node.worldTransform, worldMin, worldMax);
+		if (glm::length(worldMax - worldMin) * 0.5f >= OCCLUDER_MIN_RADIUS)
+			occluderNodes.push_back(i);
 	}
+	gpuCulling.setScene(sceneLodChains, objects);
+	cout << "INFO: GPU culling: " << objects.size() << " objects, " << gpuCulling.getNumCommands() << " indirect commands, "
+		<< occluderNodes.size() << " occluders" << endl;
+}
+
+// load image of a material (one layer of the material texture array)
+bool loadMaterial(const char* filepath, int& material)
+{
+	material = materials.addMaterial(filepath);
+	return material != static_meshes_3D::MaterialLibrary::INVALID_MATERIAL;
+}
+
+// upload per-frame data shared by object and lamp programs
+void updateFrameUniforms(const glm::mat4& view, const glm::mat4& projection)
+{
+	FrameUniformData frameData;
+	frameData.view = view;
+	frameData.projection = projection;
+	frameData.objectColor = objectColor;
+	frameData.lightColor = lightColor;
+	frameData.lightPos = lightPosition;
+	frameData.viewPosition = camera.Position;
+	frameUniforms.update(frameData);
+}
 
-	// error loading image
-	return false;
+// show state changes issued / elided by the state cache in window title (once per second)
+void showFrameStatistics(GLFWwindow* window, float currentTime)
+{
+	static float lastUpdateTime = 0.0f;
+	if (currentTime - lastUpdateTime < 1.0f)
+		return;
+	lastUpdateTime = currentTime;
+
+	// counts of culling on the GPU are read back a few frames late
+	const GLStateCache& stateCache = GLStateCache::getInstance();
+	const static_meshes_3D::GpuCulling::Statistics& gpuStatistics = gpuCulling.getStatistics();
+	const std::string drawn = isGpuCulling
+		? std::to_string(gpuStatistics.numDrawn) + "/" + std::to_string(sceneGraph.getNumObjects()) + " objects culled on GPU ("
+			+ std::to_string(gpuStatistics.numOutsideFrustum) + " outside frustum, " + std::to_string(gpuStatistics.numOccluded) + " occluded)"
+		: std::to_string(numTrianglesDrawn) + " triangles, "
+			+ std::to_string(numObjectsDrawn) + "/" + std::to_string(sceneGraph.getNumObjects()) + " objects";
+	const std::string title = std::string(WINDOW_TITLE) + " - state changes per frame: "
+		+ std::to_string(stateCache.getNumIssuedChanges()) + " issued, "
+		+ std::to_string(stateCache.getNumElidedChanges()) + " elided, " + drawn;
+	glfwSetWindowTitle(window, title.c_str());
 }
 
-void destroyTexture(GLuint textureId)
+// draw occluders depth-only and reduce their depth to the pyramid, the culling shader tests objects against
+void renderOccluders(const Shader& depthShader, const Shader& pyramidShader, const glm::mat4& view)
 {
-	glGenTextures(1, &textureId);
+	// finest level is drawn, coarser levels of concave meshes (torus hole, loaded models) can cover pixels the object doesn't,
+	// so they would hide objects that are visible
+	occluderQueue.clear();
+	for (const int node : occluderNodes) {
+		const static_meshes_3D::SceneNode& object = sceneGraph.getNode(node);
+		const static_meshes_3D::LodChain& lodChain = sceneLodChains[object.lodChain];
+		occluderQueue.submit({ lodChain.getMeshHandle(0), 0, 0, &depthShader, object.worldTransform });
+	}
+
+	occluderDepth.beginOccluders();
+	occluderQueue.flush(view);
+	occluderDepth.endOccluders();
+	occluderDepth.build(pyramidShader);
 }
 
 // render a single frame
-void render(Shader objectShader, Shader lampShader)
+void render(const Shader& objectShader, const Shader& lampShader, const Shader& cullShader, const Shader& depthShader, const Shader& pyramidShader)
 {
+	// start counting state changes of this frame
+	GLStateCache& stateCache = GLStateCache::getInstance();
+	stateCache.beginFrame();
+
 	// Enable z-depth
-	glEnable(GL_DEPTH_TEST);
+	stateCache.enable(GL_DEPTH_TEST);
 
 	// clear the frame and z buffers
-	glClearColor(0.529f, 0.808f, 0.922f, 1.0f);
+	stateCache.clearColor(0.529f, 0.808f, 0.922f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// scale the object
-	glm::mat4 scale;
-	// rotate the object
-	glm::mat4 rotation;
-	// translate the object
-	glm::mat4 translation;
-	// model matrix
-	glm::mat4 model;
-
-	// shader for all objects
-	objectShader.use();
-
 	// camera/view transformation
 	glm::mat4 view = camera.GetViewMatrix();
 
@@ -503,206 +785,143 @@ void render(Shader objectShader, Shader lampShader)
 		projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
 	}
 
-	// set shader program variables
-	objectShader.setMat4("view", view);
-	objectShader.setMat4("projection", projection);
-	objectShader.setVec3("objectColor", objectColor.r, objectColor.g, objectColor.b);
-	objectShader.setVec3("lightColor", lightColor.r, lightColor.g, lightColor.b);
-	objectShader.setVec3("lightPos", lightPosition.x, lightPosition.y, lightPosition.z);
-	const glm::vec3 cameraPosition = camera.Position;
-	objectShader.setVec3("viewPosition", cameraPosition.x, cameraPosition.y, cameraPosition.z);
+	// set per-frame data of all shader programs
+	updateFrameUniforms(view, projection);
 	//shader.setVec2("uvScale", UVScale);
 
 
-	// TABLE (2D plane)
-	glBindVertexArray(mesh.vaoTable);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, tableTexture);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(7.0f, 1.0f, 7.0f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.0f, -1.0f, 0.0f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create plane and render
-	glDrawArrays(GL_TRIANGLES, 0, mesh.nVertices);
-
-
-	// CUPCAKE - FROSTING (Cone)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cupcakeFrostingTexture);
-	glBindVertexArray(mesh.vaoCupcakeFrosting);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.0f, 0.9f, 3.5f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cone and render
-	static_meshes_3D::Cone cupcakeFrosting(1.25, 50, 1.25, true, true, true);
-	cupcakeFrosting.render();
-
-
-	// CUPCAKE - CAKE (Cylinder)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cupcakeCakeTexture);
-	glBindVertexArray(mesh.vaoCupcakeCake);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-	rotation = glm::rotate(0.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-	translation = glm::translate(glm::vec3(0.0f, -0.35f, 3.5f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cylinder and render
-	static_meshes_3D::Cylinder cupcakeCake(1.25, 50, 1.25, true, true, true);
-	cupcakeCake.render();
-
-
-	// DONUT (Torus) 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, donutTexture);
-	glBindVertexArray(mesh.vaoDonut);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-	rotation = glm::rotate(1.5708f, glm::vec3(1.0f, 0.0f, 0.0f));
-	translation = glm::translate(glm::vec3(0.0f, -0.5f, -3.5f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create torus and render
-	static_meshes_3D::Torus donut(50, 50, 1, 0.5, true, true, true);
-	donut.render();
-
-
-	// ICE CREAM BAR (Cube) 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, iceCreamBarTexture);
-	glBindVertexArray(mesh.vaoIceCreamBar);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(2.0f, 1.0f, 3.0f));
-	rotation = glm::rotate(0.7854f, glm::vec3(0.0f, 1.0f, 0.0f));
-	translation = glm::translate(glm::vec3(3.5f, -0.495f, 0.0f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cube and render
-	static_meshes_3D::Cube iceCreamBar({ 1.0f, 1.0f, 1.0f, 1.0f }, true, true, true);
-	iceCreamBar.render();
-
-
-	// ICE CREAM STICK (Cube) 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, iceCreamStickTexture);
-	glBindVertexArray(mesh.vaoIceCreamStick);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(2.0f / 3.0f, 1.0f / 3.0f, 3.0f / 3.0f)); // a third the size of the ice cream bar
-	rotation = glm::rotate(0.7854f, glm::vec3(0.0f, 1.0f, 0.0f));
-	translation = glm::translate(glm::vec3(4.85f, -0.495f, 1.35f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cube and render
-	static_meshes_3D::Cube iceCreamStick({ 1.0f, 1.0f, 1.0f, 1.0f }, true, true, true);
-	iceCreamStick.render();
-
-
-	// COTTON CANDY CART (Cube)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cottonCandyCartTexture);
-	glBindVertexArray(mesh.vaoCottonCandyCart);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(1.75f, 1.75f, 1.75f));
-	rotation = glm::rotate(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-	translation = glm::translate(glm::vec3(-3.5f, -0.120f, 0.0f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cube and render
-	static_meshes_3D::Cube cottonCandyCart({ 1.0f, 1.0f, 1.0f, 1.0f }, true, true, true);
-	cottonCandyCart.render();
-
-
-	// COTTON CANDY TIRE - FRONT (Cylinder)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cottonCandyTireTexture);
-	glBindVertexArray(mesh.vaoCottonCandyTire);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(0.25f, 0.25f, 0.25f));
-	rotation = glm::rotate(1.5708f, glm::vec3(0.0f, 0.0f, 1.0f));
-	translation = glm::translate(glm::vec3(-2.56f, -0.5f, 0.75f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cylinder and render
-	static_meshes_3D::Cylinder cottonCandyCaryTireFront(2, 50, 0.5, true, true, true);
-	cottonCandyCaryTireFront.render();
-
-	// COTTON CANDY TIRE - BACK (Cylinder)
-	// (using the same VAO, texture, scale, and rotation as the front tire
-	translation = glm::translate(glm::vec3(-4.44f, -0.5f, 0.75f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cylinder and render
-	static_meshes_3D::Cylinder cottonCandyCaryTireBack(2, 50, 0.5, true, true, true);
-	cottonCandyCaryTireBack.render();
-
-
-	// COTTON CANDY BALL (Sphere)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cottonCandyBallTexture);
-	glBindVertexArray(mesh.vaoCottonCandyBall);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(1.0f, 1.0f, 1.0f));
-	rotation = glm::rotate(3.14159f, glm::vec3(0.0f, 1.0f, 0.0f));
-	translation = glm::translate(glm::vec3(-3.5f, 1.7f, 0.0f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create sphere and render
-	static_meshes_3D::Sphere cottonCandyBall(1.25, 25, 25, true, true, true);
-	cottonCandyBall.render();
-
-
-	// COTTON CANDY TOP (Cylinder)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, cottonCandyTopTexture);
-	glBindVertexArray(mesh.vaoCottonCandyTop);
-	//		scale/rotate/translate object
-	scale = glm::scale(glm::vec3(0.25f, 0.25f, 0.25f));
-	rotation = glm::rotate(0.0f, glm::vec3(0.0f, 0.0f, 1.0f));
-	translation = glm::translate(glm::vec3(-3.5f, 3.0f, 0.0f));
-	model = translation * rotation * scale;
-	//		set the model matrix
-	objectShader.setMat4("model", model);
-	//		create cylinder and render
-	static_meshes_3D::Cylinder cottonCandyTop(1, 50, 1, true, true, true);
-	cottonCandyTop.render();
-
-
-	// LAMP (light source) 
-	lampShader.use();
-	glBindVertexArray(mesh.vaoTable);
-
-	// transform and scale light to above all objects
-	model = glm::translate(lightPosition) * glm::scale(lightScale);
-	lampShader.setMat4("view", view);
-	lampShader.setMat4("projection", projection);
-	lampShader.setMat4("model", model);
-	
-	// draw the lamp (using the table object)
-	glDrawArrays(GL_TRIANGLES, 0, mesh.nVertices);
+	// ALL OBJECTS, each at level of detail matching its size on the screen
+	const static_meshes_3D::LodView lodView = isPerspective
+		? static_meshes_3D::LodView::perspective(camera.Position, glm::radians(camera.Zoom), (float)WINDOW_HEIGHT)
+		: static_meshes_3D::LodView::orthographic(5.0f, (float)WINDOW_HEIGHT);
+	// only objects in the view frustum are visited (hierarchy skips whole subtrees outside of it)
+	const static_meshes_3D::Frustum frustum = static_meshes_3D::Frustum::fromMatrix(projection * view);
+	renderQueue.clear();
+	prepassQueue.clear();
+	if (isGpuCulling) {
+		// compute shader culls objects and selects their levels of detail, writing indirect commands drawn below
+		if (isOcclusionCulling)
+			renderOccluders(depthShader, pyramidShader, view);
+		gpuCulling.cull(cullShader, frustum, lodView, projection * view, isOcclusionCulling ? &occluderDepth : nullptr);
+		visibleNodes.clear();
+	}
+	else {
+		sceneGraph.update();
+		visibleNodes.clear();
+		sceneGraph.queryFrustum(frustum, visibleNodes);
+		numObjectsDrawn = static_cast<int>(visibleNodes.size());
+	}
+	numTrianglesDrawn = 0;
+	for (const int node : visibleNodes) {
+		static_meshes_3D::SceneNode& object = sceneGraph.getNode(node);
+		const static_meshes_3D::LodChain& lodChain = sceneLodChains[object.lodChain];
+		object.lodLevel = lodChain.selectLevel(lodView, object.worldTransform, object.lodLevel);
+		const int meshHandle = lodChain.getMeshHandle(object.lodLevel);
+		numTrianglesDrawn += sceneArena.getNumIndices(meshHandle) / 3;
+		renderQueue.submit({ meshHandle, materials.getTextureID(), object.material, &objectShader, object.worldTransform });
+		if (isDepthPrepass)
+			prepassQueue.submit({ meshHandle, 0, 0, &depthShader, object.worldTransform });
+	}
+
+	// LAMP (light source), transformed and scaled to above all objects (using the table object)
+	const glm::mat4 lampTransform = glm::translate(lightPosition) * glm::scale(lightScale);
+	renderQueue.submit({ lampMeshHandle, 0, 0, &lampShader, lampTransform });
+
+	// DEPTH PREPASS of everything drawn below, shading then passes only where its depth equals the nearest one
+	if (isDepthPrepass) {
+		prepassQueue.submit({ lampMeshHandle, 0, 0, &depthShader, lampTransform });
+		stateCache.colorMask(GL_FALSE);
+		prepassQueue.flush(view);
+		if (isGpuCulling) {
+			depthShader.use();
+			gpuCulling.draw();
+		}
+		stateCache.colorMask(GL_TRUE);
+		stateCache.depthFunc(GL_EQUAL);
+		stateCache.depthMask(GL_FALSE);
+	}
+
+	if (shadingInvocationsQuery != 0)
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, shadingInvocationsQuery);
+
+	// sort packets by state and draw them (one multi-draw call per program and texture)
+	renderQueue.flush(view);
+
+	// objects culled on the GPU, all levels of all meshes with one multi-draw call
+	if (isGpuCulling) {
+		objectShader.use();
+		stateCache.activeTexture(GL_TEXTURE0);
+		stateCache.bindTexture(GL_TEXTURE_2D_ARRAY, materials.getTextureID());
+		gpuCulling.draw();
+	}
+
+	if (shadingInvocationsQuery != 0)
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+
+	// depth is written (and cleared) again next frame
+	if (isDepthPrepass) {
+		stateCache.depthFunc(GL_LESS);
+		stateCache.depthMask(GL_TRUE);
+	}
 
 	// Deactivate the Vertex Array Object
-	glBindVertexArray(0);
+	stateCache.bindVertexArray(0);
 
 	// glfw: swap buffers and poll IO events
 	glfwSwapBuffers(window);
 }
 
+// render the scene with and without depth prepass, printing fragment shader invocations of shading and GPU time per frame
+void runPrepassBenchmark(const Shader& objectShader, const Shader& lampShader, const Shader& cullShader, const Shader& depthShader, const Shader& pyramidShader)
+{
+	// invocations can be counted only with pipeline statistics, GPU time is measured always
+	const bool isCountingInvocations = GLEW_ARB_pipeline_statistics_query == GL_TRUE;
+	if (!isCountingInvocations)
+		cout << "INFO: GL_ARB_pipeline_statistics_query not supported, fragment shader invocations are not counted" << endl;
+
+	// all materials are uploaded before measuring
+	while (!materials.update())
+		render(objectShader, lampShader, cullShader, depthShader, pyramidShader);
+
+	GLuint invocationsQuery;
+	GLuint timeQuery;
+	glGenQueries(1, &invocationsQuery);
+	glGenQueries(1, &timeQuery);
+	const bool wasDepthPrepass = isDepthPrepass;
+	cout << NUM_BENCHMARK_FRAMES << " frames, culling on " << (isGpuCulling ? "GPU" : "CPU") << endl;
+	for (const bool prepass : { false, true }) {
+		isDepthPrepass = prepass;
+		render(objectShader, lampShader, cullShader, depthShader, pyramidShader);
+
+		GLuint64 invocations = 0;
+		GLuint64 elapsedNanoseconds = 0;
+		for (int i = 0; i < NUM_BENCHMARK_FRAMES; i++) {
+			shadingInvocationsQuery = isCountingInvocations ? invocationsQuery : 0;
+			glBeginQuery(GL_TIME_ELAPSED, timeQuery);
+			render(objectShader, lampShader, cullShader, depthShader, pyramidShader);
+			glEndQuery(GL_TIME_ELAPSED);
+			shadingInvocationsQuery = 0;
+
+			GLuint64 result = 0;
+			if (isCountingInvocations) {
+				glGetQueryObjectui64v(invocationsQuery, GL_QUERY_RESULT, &result);
+				invocations += result;
+			}
+			glGetQueryObjectui64v(timeQuery, GL_QUERY_RESULT, &result);
+			elapsedNanoseconds += result;
+		}
+
+		cout << "Depth prepass " << (prepass ? "on: " : "off: ");
+		if (isCountingInvocations)
+			cout << invocations / NUM_BENCHMARK_FRAMES << " shaded fragments per frame ("
+				<< static_cast<double>(invocations) / NUM_BENCHMARK_FRAMES / (WINDOW_WIDTH * WINDOW_HEIGHT) << " per pixel), ";
+		cout << elapsedNanoseconds / 1e6 / NUM_BENCHMARK_FRAMES << " ms per frame" << endl;
+	}
+	isDepthPrepass = wasDepthPrepass;
+	glDeleteQueries(1, &invocationsQuery);
+	glDeleteQueries(1, &timeQuery);
+}
+
 // create the color shading function between vertices
 bool createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId)
 {
@@ -759,7 +978,7 @@ bool createShaderProgram(const char* vertexShaderSource, const char* fragmentSha
 		return false;
 	}
 
-	glUseProgram(programId);    // Uses the shader program
+	GLStateCache::getInstance().useProgram(programId);    // Uses the shader program
 
 	return true;
 }
@@ -768,4 +987,5 @@ bool createShaderProgram(const char* vertexShaderSource, const char* fragmentSha
 void destroyShaderProgram(GLuint programId)
 {
 	glDeleteProgram(programId);
+	GLStateCache::getInstance().onProgramDeleted(programId);
 }
\ No newline at end of file
@@ -0,0 +1,291 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+// Project
+#include "bakedMesh.h"
+#include "meshOptimizer.h"
+#include "objMeshLoader.h"
+
+namespace static_meshes_3D {
+
+    const char BakedMesh::FILE_EXTENSION[] = ".cmesh";
+    const char BakedMesh::MAGIC[4] = { 'C', 'M', 'S', 'H' };
+    const uint32_t BakedMesh::VERSION = 2;
+
+    namespace {
+
+        // Every block starts at multiple of this, so that mapped vertices and indices are aligned
+        const uint64_t BLOCK_ALIGNMENT = 16;
+
+        uint64_t alignOffset(uint64_t offset)
+        {
+            return (offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+        }
+
+    } // unnamed namespace
+
+    std::string BakedMesh::getBakedPath(const std::string& sourcePath)
+    {
+        return sourcePath + FILE_EXTENSION;
+    }
+
+    bool BakedMesh::getSourceStamp(const std::string& sourcePath, SourceStamp& stamp)
+    {
+#ifdef _WIN32
+        struct _stat64 fileStatus;
+        if (_stat64(sourcePath.c_str(), &fileStatus) != 0) {
+            return false;
+        }
+#else
+        struct stat fileStatus;
+        if (stat(sourcePath.c_str(), &fileStatus) != 0) {
+            return false;
+        }
+#endif
+
+        stamp.size = static_cast<uint64_t>(fileStatus.st_size);
+        stamp.modificationTime = static_cast<int64_t>(fileStatus.st_mtime);
+        stamp.hash = 0;
+        return true;
+    }
+
+    uint64_t BakedMesh::hashFile(const std::string& filepath)
+    {
+        MappedFile file;
+        if (!file.open(filepath)) {
+            return 0;
+        }
+
+        // FNV-1a over 8-byte words, remaining bytes one by one
+        const uint64_t FNV_PRIME = 1099511628211ULL;
+        const auto data = file.getData();
+        const auto size = file.getSize();
+        auto hash = 14695981039346656037ULL ^ size;
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+        for (; i < size; i++) {
+            hash = (hash ^ data[i]) * FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    std::vector<unsigned char> BakedMesh::createFileImage(const MeshData& meshData, const SourceStamp& source)
+    {
+        FileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.flags = 0;
+        header.vertexStride = sizeof(MeshVertex);
+        header.numVertices = static_cast<uint32_t>(meshData.vertices.size());
+        header.numIndices = static_cast<uint32_t>(meshData.indices.size());
+        header.source = source;
+
+        auto boundsMin = meshData.vertices.empty() ? glm::vec3(0.0f) : meshData.vertices[0].position;
+        auto boundsMax = boundsMin;
+        for (const auto& vertex : meshData.vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+        for (auto i = 0; i < 3; i++)
+        {
+            header.boundsMin[i] = boundsMin[i];
+            header.boundsMax[i] = boundsMax[i];
+        }
+
+        const auto vertexBlockSize = sizeof(MeshVertex) * meshData.vertices.size();
+        const auto indexBlockSize = sizeof(GLuint) * meshData.indices.size();
+        header.vertexOffset = alignOffset(sizeof(FileHeader));
+        header.indexOffset = alignOffset(header.vertexOffset + vertexBlockSize);
+        const auto fileSize = header.indexOffset + indexBlockSize;
+
+        // Padding between blocks stays zeroed
+        std::vector<unsigned char> image(static_cast<size_t>(fileSize), 0);
+        memcpy(image.data(), &header, sizeof(header));
+        if (vertexBlockSize > 0) {
+            memcpy(image.data() + header.vertexOffset, meshData.vertices.data(), vertexBlockSize);
+        }
+        if (indexBlockSize > 0) {
+            memcpy(image.data() + header.indexOffset, meshData.indices.data(), indexBlockSize);
+        }
+
+        return image;
+    }
+
+    bool BakedMesh::write(const std::string& filepath, const MeshData& meshData, const SourceStamp& source)
+    {
+        const auto image = createFileImage(meshData, source);
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(image.data()), image.size());
+        return static_cast<bool>(file);
+    }
+
+    bool BakedMesh::openOrBake(const std::string& sourcePath, ThreadPool* threadPool)
+    {
+        close();
+
+        SourceStamp source;
+        if (!getSourceStamp(sourcePath, source))
+        {
+            std::cout << "Failed to open model file " << sourcePath << std::endl;
+            return false;
+        }
+
+        // Matching size and time avoid reading the source at all, otherwise contents decide
+        const auto bakedPath = getBakedPath(sourcePath);
+        auto isHashed = false;
+        if (open(bakedPath))
+        {
+            const auto bakedSource = getSource();
+            if (bakedSource.size == source.size && bakedSource.modificationTime == source.modificationTime) {
+                return true;
+            }
+
+            close();
+            if (bakedSource.size == source.size)
+            {
+                source.hash = hashFile(sourcePath);
+                isHashed = true;
+            }
+
+            if (isHashed && source.hash == bakedSource.hash)
+            {
+                // Only the time has changed (file copied or checked out again), stored time is refreshed.
+                // Cache stays usable if that fails, source is just hashed again next time
+                std::fstream file(bakedPath, std::ios::binary | std::ios::in | std::ios::out);
+                file.seekp(offsetof(FileHeader, source) + offsetof(SourceStamp, modificationTime));
+                file.write(reinterpret_cast<const char*>(&source.modificationTime), sizeof(source.modificationTime));
+                file.close();
+                if (!file) {
+                    std::cout << "Failed to refresh modification time of baked mesh " << bakedPath << std::endl;
+                }
+
+                return open(bakedPath);
+            }
+        }
+
+        if (!isHashed) {
+            source.hash = hashFile(sourcePath);
+        }
+
+        MeshData meshData;
+        if (!obj_loader::load(sourcePath, meshData, threadPool)) {
+            return false;
+        }
+
+        mesh_optimizer::optimizeMesh(meshData);
+        std::cout << "INFO: Baked " << sourcePath << " (" << meshData.vertices.size() << " vertices, " << meshData.indices.size() / 3 << " triangles)" << std::endl;
+        if (write(bakedPath, meshData, source) && open(bakedPath)) {
+            return true;
+        }
+
+        // Cache can't be stored (read-only directory for example), same file contents are used from memory
+        std::cout << "Failed to write baked mesh " << bakedPath << std::endl;
+        _fileImage = createFileImage(meshData, source);
+        return validate(_fileImage.data(), _fileImage.size());
+    }
+
+    bool BakedMesh::open(const std::string& filepath)
+    {
+        close();
+        if (!_file.open(filepath)) {
+            return false;
+        }
+
+        if (!validate(_file.getData(), _file.getSize()))
+        {
+            _file.close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool BakedMesh::validate(const unsigned char* data, size_t size)
+    {
+        // Validate everything up front, so that getters never read past the data
+        const auto header = reinterpret_cast<const FileHeader*>(data);
+        if (size < sizeof(FileHeader) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+            || header->version != VERSION || header->vertexStride != sizeof(MeshVertex) || header->numIndices % 3 != 0) {
+            return false;
+        }
+
+        const auto isBlockValid = [size](uint64_t offset, uint64_t blockSize) {
+            return offset % BLOCK_ALIGNMENT == 0 && offset <= size && blockSize <= size - offset;
+        };
+
+        if (header->flags != 0 || !isBlockValid(header->vertexOffset, static_cast<uint64_t>(sizeof(MeshVertex)) * header->numVertices)
+            || !isBlockValid(header->indexOffset, static_cast<uint64_t>(sizeof(GLuint)) * header->numIndices)) {
+            return false;
+        }
+
+        // Index out of range would make the GPU read past the mesh, such file is baked again
+        const auto indices = reinterpret_cast<const GLuint*>(data + header->indexOffset);
+        const auto numVertices = header->numVertices;
+        if (std::any_of(indices, indices + header->numIndices, [numVertices](GLuint index) { return index >= numVertices; })) {
+            return false;
+        }
+
+        _header = header;
+        return true;
+    }
+
+    const BakedMesh::SourceStamp& BakedMesh::getSource() const
+    {
+        return _header->source;
+    }
+
+    GLuint BakedMesh::getNumVertices() const
+    {
+        return _header->numVertices;
+    }
+
+    GLuint BakedMesh::getNumIndices() const
+    {
+        return _header->numIndices;
+    }
+
+    glm::vec3 BakedMesh::getBoundsMin() const
+    {
+        return glm::vec3(_header->boundsMin[0], _header->boundsMin[1], _header->boundsMin[2]);
+    }
+
+    glm::vec3 BakedMesh::getBoundsMax() const
+    {
+        return glm::vec3(_header->boundsMax[0], _header->boundsMax[1], _header->boundsMax[2]);
+    }
+
+    const MeshVertex* BakedMesh::getVertices() const
+    {
+        return reinterpret_cast<const MeshVertex*>(reinterpret_cast<const unsigned char*>(_header) + _header->vertexOffset);
+    }
+
+    const GLuint* BakedMesh::getIndices() const
+    {
+        return reinterpret_cast<const GLuint*>(reinterpret_cast<const unsigned char*>(_header) + _header->indexOffset);
+    }
+
+    void BakedMesh::close()
+    {
+        _file.close();
+        std::vector<unsigned char>().swap(_fileImage);
+        _header = nullptr;
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,133 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "mappedFile.h"
+#include "meshData.h"
+#include "threadPool.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Mesh baked from a model file into binary cache (.cmesh file next to the source). File starts
+     * with a header, followed by interleaved vertices and indices, exactly as they are uploaded. Whole file is memory-mapped, so buffers are filled straight from the mapping.
+     * Cache belongs to the source with the same size and modification time, or the same content hash.
+     */
+    class BakedMesh
+    {
+    public:
+        static const char FILE_EXTENSION[]; // Extension appended to model path of baked mesh (".cmesh")
+
+        /**
+         * Identification of the source file, which the cache has been baked from.
+         */
+        struct SourceStamp
+        {
+            uint64_t size; // Size of the source file in bytes
+            int64_t modificationTime; // Last modification time of the source file (seconds since epoch)
+            uint64_t hash; // Hash of the source file contents
+        };
+
+        /**
+         * Header at the beginning of the file.
+         */
+        struct FileHeader
+        {
+            char magic[4]; // Always "CMSH"
+            uint32_t version; // Version of the file format
+            uint32_t flags; // Reserved for optional blocks (always 0)
+            uint32_t vertexStride; // Size of one vertex in bytes (sizeof(MeshVertex) when baked)
+            uint32_t numVertices; // Number of interleaved vertices
+            uint32_t numIndices; // Number of triangle list indices
+            float boundsMin[3]; // Minimal corner of bounding box of all positions
+            float boundsMax[3]; // Maximal corner of bounding box of all positions
+            SourceStamp source; // Source file, which the mesh has been baked from
+            uint64_t vertexOffset; // Offset of vertex block from beginning of the file
+            uint64_t indexOffset; // Offset of index block from beginning of the file
+        };
+
+        BakedMesh() = default;
+        BakedMesh(const BakedMesh&) = delete;
+        BakedMesh& operator=(const BakedMesh&) = delete;
+
+        /**
+         * Gets path of baked mesh belonging to given model file.
+         */
+        static std::string getBakedPath(const std::string& sourcePath);
+
+        /**
+         * Gets size and modification time of given file (hash is left zero).
+         *
+         * @return True, if file exists.
+         */
+        static bool getSourceStamp(const std::string& sourcePath, SourceStamp& stamp);
+
+        /**
+         * Hashes contents of given file.
+         */
+        static uint64_t hashFile(const std::string& filepath);
+
+        /**
+         * Writes baked mesh file.
+         *
+         * @param filepath  Path of the .cmesh file
+         * @param meshData  Indexed triangle list to be stored
+         * @param source    Source file, which the mesh has been baked from
+         */
+        static bool write(const std::string& filepath, const MeshData& meshData, const SourceStamp& source);
+
+        /**
+         * Maps baked mesh belonging to given OBJ file. If there's no baked mesh or it belongs to
+         * different contents of the source, OBJ file is loaded, optimized and baked first.
+         *
+         * @param sourcePath  Path of the OBJ file
+         * @param threadPool  Thread pool used to parse OBJ file, if it must be loaded (nullptr for calling thread)
+         */
+        bool openOrBake(const std::string& sourcePath, ThreadPool* threadPool = nullptr);
+
+        /**
+         * Maps baked mesh file and validates its header, blocks and indices.
+         */
+        bool open(const std::string& filepath);
+
+        const SourceStamp& getSource() const;
+        GLuint getNumVertices() const;
+        GLuint getNumIndices() const;
+        glm::vec3 getBoundsMin() const;
+        glm::vec3 getBoundsMax() const;
+
+        /**
+         * Gets interleaved vertices (pointer into the mapped file).
+         */
+        const MeshVertex* getVertices() const;
+
+        /**
+         * Gets triangle list indices (pointer into the mapped file).
+         */
+        const GLuint* getIndices() const;
+
+        /**
+         * Unmaps the file.
+         */
+        void close();
+
+    private:
+        static const char MAGIC[4]; // Magic of the file header
+        static const uint32_t VERSION; // Current version of the file format
+
+        MappedFile _file; // Mapped .cmesh file
+        std::vector<unsigned char> _fileImage; // Contents of the file, when it couldn't be written and mapped
+        const FileHeader* _header = nullptr; // Header in the mapped file
+
+        bool validate(const unsigned char* data, size_t size);
+        static std::vector<unsigned char> createFileImage(const MeshData& meshData, const SourceStamp& source);
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,163 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Project
+#include "bakedTexture.h"
+
+using namespace block_compression;
+
+const char BakedTexture::FILE_EXTENSION[] = ".ctex";
+const char BakedTexture::MAGIC[4] = { 'C', 'T', 'E', 'X' };
+const uint32_t BakedTexture::VERSION = 1;
+
+namespace {
+
+    // Data of every level start at multiple of this, so that blocks are never split between pages
+    const uint64_t DATA_ALIGNMENT = 16;
+
+    uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+
+} // unnamed namespace
+
+std::string BakedTexture::getBakedPath(const std::string& imagePath)
+{
+    return imagePath + FILE_EXTENSION;
+}
+
+GLenum BakedTexture::getInternalFormat(BlockFormat format)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+    return GL_NONE;
+}
+
+bool BakedTexture::write(const std::string& filepath, BlockFormat format, int width, int height, const std::vector<std::vector<uint8_t>>& mipLevels)
+{
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.format = static_cast<uint32_t>(format);
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.numMipLevels = static_cast<uint32_t>(mipLevels.size());
+
+    std::vector<MipLevel> mipTable(mipLevels.size());
+    auto offset = alignOffset(sizeof(FileHeader) + sizeof(MipLevel) * mipTable.size());
+    for (size_t level = 0; level < mipLevels.size(); level++)
+    {
+        mipTable[level].width = std::max(1u, header.width >> level);
+        mipTable[level].height = std::max(1u, header.height >> level);
+        mipTable[level].offset = offset;
+        mipTable[level].size = mipLevels[level].size();
+        offset = alignOffset(offset + mipLevels[level].size());
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(mipTable.data()), sizeof(MipLevel) * mipTable.size());
+    for (size_t level = 0; level < mipLevels.size(); level++)
+    {
+        // Pad up to the offset of the level
+        const auto padding = mipTable[level].offset - static_cast<uint64_t>(file.tellp());
+        const char zeros[DATA_ALIGNMENT] = {};
+        file.write(zeros, padding);
+        file.write(reinterpret_cast<const char*>(mipLevels[level].data()), mipLevels[level].size());
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool BakedTexture::open(const std::string& filepath)
+{
+    close();
+    if (!_file.open(filepath)) {
+        return false;
+    }
+
+    // Validate everything up front, so that getters never read past the mapping
+    const auto data = _file.getData();
+    const auto size = _file.getSize();
+    const auto header = reinterpret_cast<const FileHeader*>(data);
+    auto isValid = size >= sizeof(FileHeader)
+        && memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->version == VERSION
+        && (header->format == static_cast<uint32_t>(BlockFormat::BC1) || header->format == static_cast<uint32_t>(BlockFormat::BC3) || header->format == static_cast<uint32_t>(BlockFormat::BC7))
+        && header->numMipLevels > 0
+        && size >= sizeof(FileHeader) + sizeof(MipLevel) * header->numMipLevels;
+
+    if (isValid)
+    {
+        const auto mipLevels = reinterpret_cast<const MipLevel*>(data + sizeof(FileHeader));
+        const auto format = static_cast<BlockFormat>(header->format);
+        for (uint32_t level = 0; level < header->numMipLevels && isValid; level++)
+        {
+            const auto& mipLevel = mipLevels[level];
+            isValid = mipLevel.offset <= size && mipLevel.size <= size - mipLevel.offset
+                && mipLevel.size == getCompressedSizeBytes(format, mipLevel.width, mipLevel.height);
+        }
+    }
+
+    if (!isValid)
+    {
+        _file.close();
+        return false;
+    }
+
+    _header = header;
+    _mipLevels = reinterpret_cast<const MipLevel*>(data + sizeof(FileHeader));
+    return true;
+}
+
+BlockFormat BakedTexture::getFormat() const
+{
+    return static_cast<BlockFormat>(_header->format);
+}
+
+int BakedTexture::getWidth() const
+{
+    return static_cast<int>(_header->width);
+}
+
+int BakedTexture::getHeight() const
+{
+    return static_cast<int>(_header->height);
+}
+
+int BakedTexture::getNumMipLevels() const
+{
+    return static_cast<int>(_header->numMipLevels);
+}
+
+const BakedTexture::MipLevel& BakedTexture::getMipLevel(int level) const
+{
+    return _mipLevels[level];
+}
+
+const uint8_t* BakedTexture::getMipData(int level) const
+{
+    return _file.getData() + _mipLevels[level].offset;
+}
+
+void BakedTexture::close()
+{
+    _file.close();
+    _header = nullptr;
+    _mipLevels = nullptr;
+}
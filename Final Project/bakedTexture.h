@@ -0,0 +1,101 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Project
+#include "blockCompression.h"
+#include "mappedFile.h"
+
+/**
+ * Texture baked offline into block-compressed mip chain (.ctex file). File starts with a header
+ * and a table of mip levels, followed by compressed data of every level, so whole file is
+ * memory-mapped at runtime and levels are uploaded straight from the mapping.
+ */
+class BakedTexture
+{
+public:
+    static const char FILE_EXTENSION[]; // Extension appended to image path of baked texture (".ctex")
+
+    /**
+     * Header at the beginning of the file.
+     */
+    struct FileHeader
+    {
+        char magic[4]; // Always "CTEX"
+        uint32_t version; // Version of the file format
+        uint32_t format; // block_compression::BlockFormat of all levels
+        uint32_t width; // Width of the first level in texels
+        uint32_t height; // Height of the first level in texels
+        uint32_t numMipLevels; // Number of entries in mip table following the header
+    };
+
+    /**
+     * Entry of mip table.
+     */
+    struct MipLevel
+    {
+        uint32_t width; // Width of the level in texels
+        uint32_t height; // Height of the level in texels
+        uint64_t offset; // Offset of compressed data from beginning of the file
+        uint64_t size; // Size of compressed data in bytes
+    };
+
+    /**
+     * Gets path of baked texture belonging to given image.
+     */
+    static std::string getBakedPath(const std::string& imagePath);
+
+    /**
+     * Gets OpenGL internal format for given block format.
+     */
+    static GLenum getInternalFormat(block_compression::BlockFormat format);
+
+    /**
+     * Writes baked texture file.
+     *
+     * @param filepath   Path of the .ctex file
+     * @param format     Block format of all levels
+     * @param width      Width of the first level
+     * @param height     Height of the first level
+     * @param mipLevels  Compressed data of every level, first level first
+     */
+    static bool write(const std::string& filepath, block_compression::BlockFormat format, int width, int height, const std::vector<std::vector<uint8_t>>& mipLevels);
+
+    /**
+     * Maps baked texture file and validates its header and mip table.
+     */
+    bool open(const std::string& filepath);
+
+    block_compression::BlockFormat getFormat() const;
+    int getWidth() const;
+    int getHeight() const;
+    int getNumMipLevels() const;
+
+    /**
+     * Gets mip table entry of given level.
+     */
+    const MipLevel& getMipLevel(int level) const;
+
+    /**
+     * Gets compressed data of given level (pointer into the mapped file).
+     */
+    const uint8_t* getMipData(int level) const;
+
+    /**
+     * Unmaps the file.
+     */
+    void close();
+
+private:
+    static const char MAGIC[4]; // Magic of the file header
+    static const uint32_t VERSION; // Current version of the file format
+
+    MappedFile _file; // Mapped .ctex file
+    const FileHeader* _header = nullptr; // Header in the mapped file
+    const MipLevel* _mipLevels = nullptr; // Mip table in the mapped file
+};
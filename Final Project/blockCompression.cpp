@@ -0,0 +1,384 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Project
+#include "blockCompression.h"
+
+namespace block_compression {
+
+    namespace {
+
+        const int NUM_BLOCK_TEXELS = 16;
+
+        // Writes bits into 128-bit block, starting at the least significant bit of first byte
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(uint8_t* block)
+                : _block(block)
+            {
+                memset(_block, 0, 16);
+            }
+
+            void write(uint32_t value, int numBits)
+            {
+                for (auto i = 0; i < numBits; i++, _position++)
+                {
+                    if (value & (1u << i)) {
+                        _block[_position / 8] |= static_cast<uint8_t>(1u << (_position % 8));
+                    }
+                }
+            }
+
+        private:
+            uint8_t* _block;
+            int _position = 0;
+        };
+
+        /**
+         * Finds principal axis of texels (first numChannels channels) by power iteration on their
+         * covariance, and returns extreme texels projected on it as endpoints.
+         */
+        void findEndpoints(const uint8_t* texels, int numChannels, float* endpoint0, float* endpoint1)
+        {
+            float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+            {
+                for (auto c = 0; c < numChannels; c++) {
+                    mean[c] += texels[i * 4 + c] / static_cast<float>(NUM_BLOCK_TEXELS);
+                }
+            }
+
+            float covariance[4][4] = {};
+            for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+            {
+                for (auto a = 0; a < numChannels; a++)
+                {
+                    for (auto b = 0; b < numChannels; b++) {
+                        covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+                    }
+                }
+            }
+
+            float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            for (auto iteration = 0; iteration < 8; iteration++)
+            {
+                float nextAxis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                auto length = 0.0f;
+                for (auto a = 0; a < numChannels; a++)
+                {
+                    for (auto b = 0; b < numChannels; b++) {
+                        nextAxis[a] += covariance[a][b] * axis[b];
+                    }
+                    length += nextAxis[a] * nextAxis[a];
+                }
+
+                // Flat block, any axis works
+                if (length < 1e-6f) {
+                    break;
+                }
+
+                length = std::sqrt(length);
+                for (auto a = 0; a < numChannels; a++) {
+                    axis[a] = nextAxis[a] / length;
+                }
+            }
+
+            auto minProjection = 0.0f;
+            auto maxProjection = 0.0f;
+            for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+            {
+                auto projection = 0.0f;
+                for (auto c = 0; c < numChannels; c++) {
+                    projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+                }
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+
+            for (auto c = 0; c < numChannels; c++)
+            {
+                endpoint0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxProjection));
+                endpoint1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minProjection));
+            }
+        }
+
+        int squaredDistance(const uint8_t* texel, const int* color, int numChannels)
+        {
+            auto distance = 0;
+            for (auto c = 0; c < numChannels; c++)
+            {
+                const auto difference = texel[c] - color[c];
+                distance += difference * difference;
+            }
+
+            return distance;
+        }
+
+        uint16_t packColor565(const float* color)
+        {
+            const auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+            const auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+            const auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpackColor565(uint16_t packed, int* color)
+        {
+            const auto r = (packed >> 11) & 31;
+            const auto g = (packed >> 5) & 63;
+            const auto b = packed & 31;
+            color[0] = (r << 3) | (r >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (b << 3) | (b >> 2);
+        }
+
+        // 8 bytes: two RGB565 endpoints and 2-bit indices, always in four color mode
+        void compressColorBlock(const uint8_t* texels, uint8_t* block)
+        {
+            float endpoint0[4], endpoint1[4];
+            findEndpoints(texels, 3, endpoint0, endpoint1);
+
+            auto color0 = packColor565(endpoint0);
+            auto color1 = packColor565(endpoint1);
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+
+            uint32_t indices = 0;
+            if (color0 != color1)
+            {
+                // Palette order of BC1: endpoint 0, endpoint 1, 2/3 + 1/3, 1/3 + 2/3
+                int palette[4][3];
+                unpackColor565(color0, palette[0]);
+                unpackColor565(color1, palette[1]);
+                for (auto c = 0; c < 3; c++)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+
+                for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+                {
+                    auto bestIndex = 0;
+                    auto bestDistance = squaredDistance(texels + i * 4, palette[0], 3);
+                    for (auto p = 1; p < 4; p++)
+                    {
+                        const auto distance = squaredDistance(texels + i * 4, palette[p], 3);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = p;
+                        }
+                    }
+                    indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+                }
+            }
+
+            block[0] = static_cast<uint8_t>(color0 & 0xFF);
+            block[1] = static_cast<uint8_t>(color0 >> 8);
+            block[2] = static_cast<uint8_t>(color1 & 0xFF);
+            block[3] = static_cast<uint8_t>(color1 >> 8);
+            for (auto i = 0; i < 4; i++) {
+                block[4 + i] = static_cast<uint8_t>((indices >> (8 * i)) & 0xFF);
+            }
+        }
+
+        // 8 bytes: two alpha endpoints and 3-bit indices, in eight alpha mode
+        void compressAlphaBlock(const uint8_t* texels, uint8_t* block)
+        {
+            auto alpha0 = 0;
+            auto alpha1 = 255;
+            for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+            {
+                alpha0 = std::max(alpha0, static_cast<int>(texels[i * 4 + 3]));
+                alpha1 = std::min(alpha1, static_cast<int>(texels[i * 4 + 3]));
+            }
+
+            uint64_t indices = 0;
+            if (alpha0 != alpha1)
+            {
+                // Palette order: endpoint 0, endpoint 1, then six interpolated values from endpoint 0 on
+                int palette[8] = { alpha0, alpha1 };
+                for (auto p = 1; p < 7; p++) {
+                    palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+                }
+
+                for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+                {
+                    auto bestIndex = 0;
+                    auto bestDistance = 256;
+                    for (auto p = 0; p < 8; p++)
+                    {
+                        const auto distance = std::abs(texels[i * 4 + 3] - palette[p]);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = p;
+                        }
+                    }
+                    indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+                }
+            }
+
+            block[0] = static_cast<uint8_t>(alpha0);
+            block[1] = static_cast<uint8_t>(alpha1);
+            for (auto i = 0; i < 6; i++) {
+                block[2 + i] = static_cast<uint8_t>((indices >> (8 * i)) & 0xFF);
+            }
+        }
+
+        // Quantizes endpoint to 7 bits per channel plus shared p-bit, choosing p-bit with lower error
+        void quantizeEndpointBC7(const float* endpoint, int* quantized, int& pBit)
+        {
+            auto bestError = -1.0f;
+            for (auto p = 0; p < 2; p++)
+            {
+                int candidate[4];
+                auto error = 0.0f;
+                for (auto c = 0; c < 4; c++)
+                {
+                    candidate[c] = std::min(127, std::max(0, static_cast<int>(std::lround((endpoint[c] - p) / 2.0f))));
+                    const auto difference = endpoint[c] - ((candidate[c] << 1) | p);
+                    error += difference * difference;
+                }
+
+                if (bestError < 0.0f || error < bestError)
+                {
+                    bestError = error;
+                    pBit = p;
+                    std::copy(candidate, candidate + 4, quantized);
+                }
+            }
+        }
+
+        // 16 bytes: mode 6 - one subset, RGBA endpoints of 7 bits + p-bit, 4-bit indices
+        void compressBlockBC7(const uint8_t* texels, uint8_t* block)
+        {
+            static const int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+            float endpoints[2][4];
+            findEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+            int quantized[2][4];
+            int pBits[2];
+            quantizeEndpointBC7(endpoints[0], quantized[0], pBits[0]);
+            quantizeEndpointBC7(endpoints[1], quantized[1], pBits[1]);
+
+            int palette[16][4];
+            for (auto p = 0; p < 16; p++)
+            {
+                for (auto c = 0; c < 4; c++)
+                {
+                    const auto value0 = (quantized[0][c] << 1) | pBits[0];
+                    const auto value1 = (quantized[1][c] << 1) | pBits[1];
+                    palette[p][c] = ((64 - WEIGHTS[p]) * value0 + WEIGHTS[p] * value1 + 32) >> 6;
+                }
+            }
+
+            int indices[NUM_BLOCK_TEXELS];
+            for (auto i = 0; i < NUM_BLOCK_TEXELS; i++)
+            {
+                indices[i] = 0;
+                auto bestDistance = squaredDistance(texels + i * 4, palette[0], 4);
+                for (auto p = 1; p < 16; p++)
+                {
+                    const auto distance = squaredDistance(texels + i * 4, palette[p], 4);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        indices[i] = p;
+                    }
+                }
+            }
+
+            // Most significant bit of first index is implicit zero, swap endpoints if needed
+            if (indices[0] >= 8)
+            {
+                for (auto c = 0; c < 4; c++) {
+                    std::swap(quantized[0][c], quantized[1][c]);
+                }
+                std::swap(pBits[0], pBits[1]);
+                for (auto& index : indices) {
+                    index = 15 - index;
+                }
+            }
+
+            BitWriter writer(block);
+            writer.write(1u << 6, 7);
+            for (auto c = 0; c < 4; c++)
+            {
+                writer.write(quantized[0][c], 7);
+                writer.write(quantized[1][c], 7);
+            }
+            writer.write(pBits[0], 1);
+            writer.write(pBits[1], 1);
+            writer.write(indices[0], 3);
+            for (auto i = 1; i < NUM_BLOCK_TEXELS; i++) {
+                writer.write(indices[i], 4);
+            }
+        }
+
+    } // unnamed namespace
+
+    size_t getBlockSizeBytes(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    size_t getCompressedSizeBytes(BlockFormat format, int width, int height)
+    {
+        const auto numBlocksX = static_cast<size_t>((width + 3) / 4);
+        const auto numBlocksY = static_cast<size_t>((height + 3) / 4);
+        return numBlocksX * numBlocksY * getBlockSizeBytes(format);
+    }
+
+    void compressBlock(BlockFormat format, const uint8_t* texels, uint8_t* block)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            compressColorBlock(texels, block);
+            break;
+        case BlockFormat::BC3:
+            compressAlphaBlock(texels, block);
+            compressColorBlock(texels, block + 8);
+            break;
+        case BlockFormat::BC7:
+            compressBlockBC7(texels, block);
+            break;
+        }
+    }
+
+    std::vector<uint8_t> compressImage(BlockFormat format, const uint8_t* pixels, int width, int height)
+    {
+        std::vector<uint8_t> result(getCompressedSizeBytes(format, width, height));
+        const auto blockSize = getBlockSizeBytes(format);
+        auto block = result.data();
+
+        uint8_t texels[NUM_BLOCK_TEXELS * 4];
+        for (auto blockY = 0; blockY < height; blockY += 4)
+        {
+            for (auto blockX = 0; blockX < width; blockX += 4)
+            {
+                for (auto y = 0; y < 4; y++)
+                {
+                    for (auto x = 0; x < 4; x++)
+                    {
+                        const auto pixelX = std::min(blockX + x, width - 1);
+                        const auto pixelY = std::min(blockY + y, height - 1);
+                        memcpy(texels + (y * 4 + x) * 4, pixels + (static_cast<size_t>(pixelY) * width + pixelX) * 4, 4);
+                    }
+                }
+
+                compressBlock(format, texels, block);
+                block += blockSize;
+            }
+        }
+
+        return result;
+    }
+
+} // namespace block_compression
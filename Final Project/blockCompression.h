@@ -0,0 +1,46 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Block compression of RGBA8 images to BC1 (DXT1), BC3 (DXT5) and BC7 formats. Every format
+ * encodes 4x4 texel blocks; BC1 blocks take 8 bytes, BC3 and BC7 blocks take 16 bytes.
+ */
+namespace block_compression {
+
+    enum class BlockFormat : uint32_t
+    {
+        BC1 = 1, // RGB, 4 bits per texel
+        BC3 = 3, // RGBA with interpolated alpha, 8 bits per texel
+        BC7 = 7  // RGBA, high quality (mode 6 only), 8 bits per texel
+    };
+
+    /**
+     * Gets size of one compressed 4x4 block in bytes.
+     */
+    size_t getBlockSizeBytes(BlockFormat format);
+
+    /**
+     * Gets size of compressed image of given size in bytes.
+     */
+    size_t getCompressedSizeBytes(BlockFormat format, int width, int height);
+
+    /**
+     * Compresses one block.
+     *
+     * @param texels  16 RGBA texels of the block, row by row
+     * @param block   Output, getBlockSizeBytes(format) bytes
+     */
+    void compressBlock(BlockFormat format, const uint8_t* texels, uint8_t* block);
+
+    /**
+     * Compresses whole RGBA8 image (edge texels are repeated in blocks crossing image border).
+     *
+     * @return Compressed blocks, row by row.
+     */
+    std::vector<uint8_t> compressImage(BlockFormat format, const uint8_t* pixels, int width, int height);
+
+} // namespace block_compression
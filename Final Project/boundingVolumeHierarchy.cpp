@@ -0,0 +1,549 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+// Project
+#include "boundingVolumeHierarchy.h"
+
+namespace static_meshes_3D {
+
+    const int BoundingVolumeHierarchy::NULL_NODE = -1;
+    const float BoundingVolumeHierarchy::FAT_MARGIN = 0.1f;
+
+    namespace {
+
+        float getSurfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            const auto extent = boundsMax - boundsMin;
+            return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        }
+
+        float getUnionSurfaceArea(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax)
+        {
+            return getSurfaceArea(glm::min(aMin, bMin), glm::max(aMax, bMax));
+        }
+
+        bool containsBox(const glm::vec3& outerMin, const glm::vec3& outerMax, const glm::vec3& innerMin, const glm::vec3& innerMax)
+        {
+            return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z
+                && innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+        }
+
+        bool overlapsBox(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax)
+        {
+            return aMin.x <= bMax.x && bMin.x <= aMax.x && aMin.y <= bMax.y && bMin.y <= aMax.y && aMin.z <= bMax.z && bMin.z <= aMax.z;
+        }
+
+        float getDistanceSquared(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            const auto offset = glm::max(glm::max(boundsMin - point, point - boundsMax), glm::vec3(0.0f));
+            return glm::dot(offset, offset);
+        }
+
+        /**
+         * Intersects ray with box (slab test).
+         *
+         * @return Distance, at which the ray enters the box (0 if it starts inside), or infinity if it misses.
+         */
+        float intersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            auto entry = 0.0f;
+            auto exit = std::numeric_limits<float>::infinity();
+            for (auto axis = 0; axis < 3; axis++)
+            {
+                // Infinite inverse (ray parallel to the slab) gives infinite or NaN distances, NaN is ignored by min / max
+                auto t1 = (boundsMin[axis] - origin[axis]) * inverseDirection[axis];
+                auto t2 = (boundsMax[axis] - origin[axis]) * inverseDirection[axis];
+                if (t1 > t2) {
+                    std::swap(t1, t2);
+                }
+                entry = t1 > entry ? t1 : entry;
+                exit = t2 < exit ? t2 : exit;
+            }
+
+            return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+        }
+
+    } // unnamed namespace
+
+    int BoundingVolumeHierarchy::insert(const glm::vec3& boundsMin, const glm::vec3& boundsMax, int userData)
+    {
+        const auto leaf = allocateNode();
+        auto& node = _nodes[leaf];
+        const auto margin = glm::vec3(glm::length(boundsMax - boundsMin) * FAT_MARGIN);
+        node.fatMin = boundsMin - margin;
+        node.fatMax = boundsMax + margin;
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+        node.height = 0;
+        node.userData = userData;
+
+        insertLeaf(leaf);
+        _numObjects++;
+        return leaf;
+    }
+
+    void BoundingVolumeHierarchy::remove(int proxy)
+    {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        _numObjects--;
+    }
+
+    bool BoundingVolumeHierarchy::move(int proxy, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    {
+        auto& node = _nodes[proxy];
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+
+        // Enlarged box still fits and is not too large for the object (e.g. after it has shrunk)
+        const auto margin = glm::vec3(glm::length(boundsMax - boundsMin) * FAT_MARGIN);
+        if (containsBox(node.fatMin, node.fatMax, boundsMin, boundsMax)
+            && containsBox(boundsMin - margin * 4.0f, boundsMax + margin * 4.0f, node.fatMin, node.fatMax)) {
+            return false;
+        }
+
+        removeLeaf(proxy);
+        node.fatMin = boundsMin - margin;
+        node.fatMax = boundsMax + margin;
+        insertLeaf(proxy);
+        return true;
+    }
+
+    int BoundingVolumeHierarchy::getUserData(int proxy) const
+    {
+        return _nodes[proxy].userData;
+    }
+
+    const glm::vec3& BoundingVolumeHierarchy::getBoundsMin(int proxy) const
+    {
+        return _nodes[proxy].boundsMin;
+    }
+
+    const glm::vec3& BoundingVolumeHierarchy::getBoundsMax(int proxy) const
+    {
+        return _nodes[proxy].boundsMax;
+    }
+
+    int BoundingVolumeHierarchy::getNumObjects() const
+    {
+        return _numObjects;
+    }
+
+    int BoundingVolumeHierarchy::getHeight() const
+    {
+        return _root != NULL_NODE ? _nodes[_root].height + 1 : 0;
+    }
+
+    void BoundingVolumeHierarchy::clear()
+    {
+        _nodes.clear();
+        _root = NULL_NODE;
+        _freeList = NULL_NODE;
+        _numObjects = 0;
+    }
+
+    void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, std::vector<int>& userData) const
+    {
+        queryFrustum(frustum, userData, nullptr);
+    }
+
+    void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, std::vector<int>& insideUserData, std::vector<int>& candidateUserData) const
+    {
+        queryFrustum(frustum, insideUserData, &candidateUserData);
+    }
+
+    void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, std::vector<int>& userData, std::vector<int>* candidateUserData) const
+    {
+        if (_root == NULL_NODE) {
+            return;
+        }
+
+        std::vector<int> stack(1, _root);
+        std::vector<int> subtreeStack;
+        while (!stack.empty())
+        {
+            const auto& node = _nodes[stack.back()];
+            const auto index = stack.back();
+            stack.pop_back();
+
+            // Leaves under partially visible nodes are left to the caller, when it tests them in a batch
+            if (node.isLeaf() && candidateUserData != nullptr)
+            {
+                candidateUserData->push_back(node.userData);
+                continue;
+            }
+
+            // Leaves are classified by the exact box, inner nodes by the box of their subtree
+            const auto containment = node.isLeaf() ? frustum.classifyBox(node.boundsMin, node.boundsMax) : frustum.classifyBox(node.fatMin, node.fatMax);
+            if (containment == Frustum::Containment::Outside) {
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                userData.push_back(node.userData);
+            }
+            else if (containment == Frustum::Containment::Inside) {
+                collectLeaves(index, userData, subtreeStack);
+            }
+            else
+            {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+        }
+    }
+
+    void BoundingVolumeHierarchy::queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<int>& userData) const
+    {
+        if (_root == NULL_NODE) {
+            return;
+        }
+
+        std::vector<int> stack(1, _root);
+        while (!stack.empty())
+        {
+            const auto& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!overlapsBox(node.fatMin, node.fatMax, boundsMin, boundsMax)) {
+                continue;
+            }
+
+            if (!node.isLeaf())
+            {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+            else if (overlapsBox(node.boundsMin, node.boundsMax, boundsMin, boundsMax)) {
+                userData.push_back(node.userData);
+            }
+        }
+    }
+
+    void BoundingVolumeHierarchy::querySphere(const glm::vec3& center, float radius, std::vector<int>& userData) const
+    {
+        if (_root == NULL_NODE) {
+            return;
+        }
+
+        const auto radiusSquared = radius * radius;
+        std::vector<int> stack(1, _root);
+        while (!stack.empty())
+        {
+            const auto& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (getDistanceSquared(center, node.fatMin, node.fatMax) > radiusSquared) {
+                continue;
+            }
+
+            if (!node.isLeaf())
+            {
+                stack.push_back(node.children[0]);
+                stack.push_back(node.children[1]);
+            }
+            else if (getDistanceSquared(center, node.boundsMin, node.boundsMax) <= radiusSquared) {
+                userData.push_back(node.userData);
+            }
+        }
+    }
+
+    int BoundingVolumeHierarchy::findNearest(const glm::vec3& point, float maxDistance, float& distance) const
+    {
+        if (_root == NULL_NODE) {
+            return NULL_NODE;
+        }
+
+        // Nodes are visited nearest first, search ends when the nearest unvisited node is farther than the best object
+        typedef std::pair<float, int> QueueEntry;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        auto bestDistanceSquared = maxDistance * maxDistance;
+        auto bestUserData = NULL_NODE;
+        queue.push(QueueEntry(getDistanceSquared(point, _nodes[_root].fatMin, _nodes[_root].fatMax), _root));
+        while (!queue.empty() && queue.top().first <= bestDistanceSquared)
+        {
+            const auto& node = _nodes[queue.top().second];
+            queue.pop();
+            if (node.isLeaf())
+            {
+                const auto distanceSquared = getDistanceSquared(point, node.boundsMin, node.boundsMax);
+                if (distanceSquared <= bestDistanceSquared)
+                {
+                    bestDistanceSquared = distanceSquared;
+                    bestUserData = node.userData;
+                }
+                continue;
+            }
+
+            for (const auto child : node.children) {
+                queue.push(QueueEntry(getDistanceSquared(point, _nodes[child].fatMin, _nodes[child].fatMax), child));
+            }
+        }
+
+        distance = std::sqrt(bestDistanceSquared);
+        return bestUserData;
+    }
+
+    int BoundingVolumeHierarchy::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+    {
+        if (_root == NULL_NODE) {
+            return NULL_NODE;
+        }
+
+        const auto inverseDirection = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        auto bestDistance = maxDistance;
+        auto bestUserData = NULL_NODE;
+        std::vector<std::pair<float, int>> stack(1, std::make_pair(intersectRay(origin, inverseDirection, _nodes[_root].fatMin, _nodes[_root].fatMax), _root));
+        while (!stack.empty())
+        {
+            const auto entry = stack.back();
+            stack.pop_back();
+            if (entry.first > bestDistance) {
+                continue;
+            }
+
+            const auto& node = _nodes[entry.second];
+            if (node.isLeaf())
+            {
+                const auto hitDistance = intersectRay(origin, inverseDirection, node.boundsMin, node.boundsMax);
+                if (hitDistance <= bestDistance)
+                {
+                    bestDistance = hitDistance;
+                    bestUserData = node.userData;
+                }
+                continue;
+            }
+
+            // Nearer child goes on top of the stack, so that it can prune the farther one
+            auto first = std::make_pair(intersectRay(origin, inverseDirection, _nodes[node.children[0]].fatMin, _nodes[node.children[0]].fatMax), node.children[0]);
+            auto second = std::make_pair(intersectRay(origin, inverseDirection, _nodes[node.children[1]].fatMin, _nodes[node.children[1]].fatMax), node.children[1]);
+            if (first.first < second.first) {
+                std::swap(first, second);
+            }
+            stack.push_back(first);
+            stack.push_back(second);
+        }
+
+        distance = bestDistance;
+        return bestUserData;
+    }
+
+    void BoundingVolumeHierarchy::transformBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& matrix, glm::vec3& transformedMin, glm::vec3& transformedMax)
+    {
+        // Box rotated by the matrix is enclosed by box with absolute values of the matrix applied
+        const auto center = glm::vec3(matrix * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+        const auto halfExtent = (boundsMax - boundsMin) * 0.5f;
+        glm::vec3 extent(0.0f);
+        for (auto column = 0; column < 3; column++)
+        {
+            for (auto axis = 0; axis < 3; axis++) {
+                extent[axis] += std::abs(matrix[column][axis]) * halfExtent[column];
+            }
+        }
+
+        transformedMin = center - extent;
+        transformedMax = center + extent;
+    }
+
+    int BoundingVolumeHierarchy::allocateNode()
+    {
+        if (_freeList == NULL_NODE)
+        {
+            _nodes.push_back(Node());
+            _freeList = static_cast<int>(_nodes.size()) - 1;
+            _nodes[_freeList].parent = NULL_NODE;
+        }
+
+        const auto node = _freeList;
+        _freeList = _nodes[node].parent;
+        _nodes[node].parent = NULL_NODE;
+        _nodes[node].children[0] = NULL_NODE;
+        _nodes[node].children[1] = NULL_NODE;
+        _nodes[node].height = 0;
+        _nodes[node].userData = NULL_NODE;
+        return node;
+    }
+
+    void BoundingVolumeHierarchy::freeNode(int node)
+    {
+        _nodes[node].parent = _freeList;
+        _nodes[node].height = -1;
+        _freeList = node;
+    }
+
+    void BoundingVolumeHierarchy::insertLeaf(int leaf)
+    {
+        if (_root == NULL_NODE)
+        {
+            _root = leaf;
+            _nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // Descend to the sibling, next to which the leaf adds the least surface area to the tree
+        const auto leafMin = _nodes[leaf].fatMin;
+        const auto leafMax = _nodes[leaf].fatMax;
+        auto sibling = _root;
+        while (!_nodes[sibling].isLeaf())
+        {
+            const auto& node = _nodes[sibling];
+            const auto area = getSurfaceArea(node.fatMin, node.fatMax);
+            const auto combinedArea = getUnionSurfaceArea(node.fatMin, node.fatMax, leafMin, leafMax);
+
+            // Cost of new parent of this node and the leaf, and the cost pushed down to the children
+            const auto cost = 2.0f * combinedArea;
+            const auto inheritanceCost = 2.0f * (combinedArea - area);
+
+            float childCosts[2];
+            for (auto i = 0; i < 2; i++)
+            {
+                const auto& child = _nodes[node.children[i]];
+                const auto childCombinedArea = getUnionSurfaceArea(child.fatMin, child.fatMax, leafMin, leafMax);
+                childCosts[i] = (child.isLeaf() ? childCombinedArea : childCombinedArea - getSurfaceArea(child.fatMin, child.fatMax)) + inheritanceCost;
+            }
+
+            if (cost < childCosts[0] && cost < childCosts[1]) {
+                break;
+            }
+
+            sibling = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+        }
+
+        // New parent takes place of the sibling, with sibling and leaf as its children
+        const auto oldParent = _nodes[sibling].parent;
+        const auto newParent = allocateNode();
+        auto& parentNode = _nodes[newParent];
+        parentNode.parent = oldParent;
+        parentNode.fatMin = glm::min(leafMin, _nodes[sibling].fatMin);
+        parentNode.fatMax = glm::max(leafMax, _nodes[sibling].fatMax);
+        parentNode.height = _nodes[sibling].height + 1;
+        parentNode.children[0] = sibling;
+        parentNode.children[1] = leaf;
+        if (oldParent != NULL_NODE)
+        {
+            auto& oldParentNode = _nodes[oldParent];
+            oldParentNode.children[oldParentNode.children[0] == sibling ? 0 : 1] = newParent;
+        }
+        else {
+            _root = newParent;
+        }
+
+        _nodes[sibling].parent = newParent;
+        _nodes[leaf].parent = newParent;
+        refitAncestors(newParent);
+    }
+
+    void BoundingVolumeHierarchy::removeLeaf(int leaf)
+    {
+        if (leaf == _root)
+        {
+            _root = NULL_NODE;
+            return;
+        }
+
+        // Sibling takes place of the parent, which is no longer needed
+        const auto parent = _nodes[leaf].parent;
+        const auto grandParent = _nodes[parent].parent;
+        const auto sibling = _nodes[parent].children[0] == leaf ? _nodes[parent].children[1] : _nodes[parent].children[0];
+        freeNode(parent);
+        _nodes[sibling].parent = grandParent;
+        if (grandParent == NULL_NODE)
+        {
+            _root = sibling;
+            return;
+        }
+
+        auto& grandParentNode = _nodes[grandParent];
+        grandParentNode.children[grandParentNode.children[0] == parent ? 0 : 1] = sibling;
+        refitAncestors(grandParent);
+    }
+
+    void BoundingVolumeHierarchy::refitAncestors(int node)
+    {
+        while (node != NULL_NODE)
+        {
+            node = balance(node);
+            auto& currentNode = _nodes[node];
+            const auto& firstChild = _nodes[currentNode.children[0]];
+            const auto& secondChild = _nodes[currentNode.children[1]];
+            currentNode.fatMin = glm::min(firstChild.fatMin, secondChild.fatMin);
+            currentNode.fatMax = glm::max(firstChild.fatMax, secondChild.fatMax);
+            currentNode.height = 1 + std::max(firstChild.height, secondChild.height);
+            node = currentNode.parent;
+        }
+    }
+
+    int BoundingVolumeHierarchy::balance(int nodeA)
+    {
+        auto& a = _nodes[nodeA];
+        if (a.isLeaf() || a.height < 2) {
+            return nodeA;
+        }
+
+        // Higher child is rotated up, when heights of children differ by more than one
+        const auto heightDifference = _nodes[a.children[1]].height - _nodes[a.children[0]].height;
+        if (heightDifference >= -1 && heightDifference <= 1) {
+            return nodeA;
+        }
+
+        const auto upperSide = heightDifference > 1 ? 1 : 0;
+        const auto nodeUp = a.children[upperSide];
+        auto& up = _nodes[nodeUp];
+        const auto nodeF = up.children[0];
+        const auto nodeG = up.children[1];
+
+        // Up node takes place of A, A becomes its first child
+        up.children[0] = nodeA;
+        up.parent = a.parent;
+        a.parent = nodeUp;
+        if (up.parent != NULL_NODE)
+        {
+            auto& parent = _nodes[up.parent];
+            parent.children[parent.children[0] == nodeA ? 0 : 1] = nodeUp;
+        }
+        else {
+            _root = nodeUp;
+        }
+
+        // Higher grandchild stays under the up node, the lower one moves to A in place of the up node
+        const auto nodeKeep = _nodes[nodeF].height > _nodes[nodeG].height ? nodeF : nodeG;
+        const auto nodeMove = nodeKeep == nodeF ? nodeG : nodeF;
+        up.children[1] = nodeKeep;
+        a.children[upperSide] = nodeMove;
+        _nodes[nodeMove].parent = nodeA;
+
+        for (const auto node : { nodeA, nodeUp })
+        {
+            auto& refitted = _nodes[node];
+            const auto& firstChild = _nodes[refitted.children[0]];
+            const auto& secondChild = _nodes[refitted.children[1]];
+            refitted.fatMin = glm::min(firstChild.fatMin, secondChild.fatMin);
+            refitted.fatMax = glm::max(firstChild.fatMax, secondChild.fatMax);
+            refitted.height = 1 + std::max(firstChild.height, secondChild.height);
+        }
+
+        return nodeUp;
+    }
+
+    void BoundingVolumeHierarchy::collectLeaves(int node, std::vector<int>& userData, std::vector<int>& stack) const
+    {
+        stack.assign(1, node);
+        while (!stack.empty())
+        {
+            const auto& currentNode = _nodes[stack.back()];
+            stack.pop_back();
+            if (currentNode.isLeaf()) {
+                userData.push_back(currentNode.userData);
+            }
+            else
+            {
+                stack.push_back(currentNode.children[0]);
+                stack.push_back(currentNode.children[1]);
+            }
+        }
+    }
+
+} // namespace static_meshes_3D
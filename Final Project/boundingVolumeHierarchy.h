@@ -0,0 +1,156 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "frustumCulling.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Dynamic bounding volume hierarchy of axis-aligned boxes (binary tree, objects in leaves).
+     * Objects are inserted next to the sibling, which grows the tree surface the least, and the tree
+     * is kept balanced by rotations, so queries take O(log n). Leaves store boxes enlarged by a margin,
+     * so that small movements only refit the leaf, without touching the rest of the tree.
+     */
+    class BoundingVolumeHierarchy
+    {
+    public:
+        static const int NULL_NODE; // Index of no node (-1)
+        static const float FAT_MARGIN; // Fraction of box size, by which leaf boxes are enlarged (0.1)
+
+        BoundingVolumeHierarchy() = default;
+
+        /**
+         * Inserts object with given world space box.
+         *
+         * @param boundsMin  Minimal corner of the box
+         * @param boundsMax  Maximal corner of the box
+         * @param userData   Value returned by queries for this object
+         *
+         * @return Proxy of the object in the hierarchy.
+         */
+        int insert(const glm::vec3& boundsMin, const glm::vec3& boundsMax, int userData);
+
+        /**
+         * Removes object from the hierarchy.
+         */
+        void remove(int proxy);
+
+        /**
+         * Updates box of moved object. Object is reinserted only when it leaves its enlarged box.
+         *
+         * @return True, if the tree has been restructured.
+         */
+        bool move(int proxy, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+        /**
+         * Gets user data / exact box of given object.
+         */
+        int getUserData(int proxy) const;
+        const glm::vec3& getBoundsMin(int proxy) const;
+        const glm::vec3& getBoundsMax(int proxy) const;
+
+        /**
+         * Gets number of objects / height of the tree (0 for empty tree).
+         */
+        int getNumObjects() const;
+        int getHeight() const;
+
+        /**
+         * Removes all objects.
+         */
+        void clear();
+
+        /**
+         * Finds all objects, whose boxes are at least partially in the frustum. Objects under nodes
+         * completely inside the frustum are accepted without any further test.
+         */
+        void queryFrustum(const Frustum& frustum, std::vector<int>& userData) const;
+
+        /**
+         * Finds objects in the frustum like above, but leaves under nodes partially inside the frustum
+         * aren't tested. They're returned as candidates instead, so that the caller can test all of
+         * them in one batch (e.g. by CullingBounds).
+         *
+         * @param insideUserData     Gets objects under nodes completely inside the frustum
+         * @param candidateUserData  Gets objects, whose boxes are still to be tested
+         */
+        void queryFrustum(const Frustum& frustum, std::vector<int>& insideUserData, std::vector<int>& candidateUserData) const;
+
+        /**
+         * Finds all objects, whose boxes overlap given box.
+         */
+        void queryBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<int>& userData) const;
+
+        /**
+         * Finds all objects, whose boxes are closer than radius to given point.
+         */
+        void querySphere(const glm::vec3& center, float radius, std::vector<int>& userData) const;
+
+        /**
+         * Finds object, whose box is the nearest to given point.
+         *
+         * @param point        Point to search from
+         * @param maxDistance  Objects farther than this are ignored
+         * @param distance     Gets distance to box of the found object (0 for point inside the box)
+         *
+         * @return User data of the object, or NULL_NODE if there's none.
+         */
+        int findNearest(const glm::vec3& point, float maxDistance, float& distance) const;
+
+        /**
+         * Finds object, whose box is hit first by the ray.
+         *
+         * @param origin       Origin of the ray
+         * @param direction    Direction of the ray (doesn't need to be normalized)
+         * @param maxDistance  Hits farther than this (in multiples of direction) are ignored
+         * @param distance     Gets distance of the hit (in multiples of direction)
+         *
+         * @return User data of the object, or NULL_NODE if nothing has been hit.
+         */
+        int raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+
+        /**
+         * Computes world space box enclosing box transformed by given matrix.
+         */
+        static void transformBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& matrix, glm::vec3& transformedMin, glm::vec3& transformedMax);
+
+    private:
+        /**
+         * Node of the tree. Leaf nodes hold objects, free nodes are chained by their parent index.
+         */
+        struct Node
+        {
+            glm::vec3 fatMin; // Minimal corner of box enclosing the whole subtree (enlarged for leaves)
+            glm::vec3 fatMax; // Maximal corner of box enclosing the whole subtree (enlarged for leaves)
+            glm::vec3 boundsMin; // Minimal corner of exact object box (leaves only)
+            glm::vec3 boundsMax; // Maximal corner of exact object box (leaves only)
+            int parent; // Parent node (next free node for free nodes)
+            int children[2]; // Child nodes (NULL_NODE for leaves)
+            int height; // Height of subtree (0 for leaves, -1 for free nodes)
+            int userData; // User data of the object (leaves only)
+
+            bool isLeaf() const { return children[0] == NULL_NODE; }
+        };
+
+        std::vector<Node> _nodes; // All nodes, used and free
+        int _root = NULL_NODE; // Root node
+        int _freeList = NULL_NODE; // First free node
+        int _numObjects = 0; // Number of leaves
+
+        int allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        void refitAncestors(int node);
+        int balance(int node);
+        void collectLeaves(int node, std::vector<int>& userData, std::vector<int>& stack) const;
+        void queryFrustum(const Frustum& frustum, std::vector<int>& userData, std::vector<int>* candidateUserData) const;
+    };
+
+} // namespace static_meshes_3D
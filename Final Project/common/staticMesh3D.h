@@ -1,10 +1,38 @@
 #pragma once
 
+// STL
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "vertextBufferObject.h"
+#include "../instanceBuffer.h"
+#include "../meshData.h"
+#include "../vertexCompression.h"
+#include "../vertexKernels.h"
 
 
 namespace static_meshes_3D {
 
+/**
+	Layout of vertex attributes in the vertex buffer of static mesh.
+*/
+enum class VertexLayout
+{
+	Planar, //!< All positions, then all texture coordinates, then all normals
+	Interleaved //!< Position, texture coordinate and normal of every vertex next to each other
+};
+
+/**
+	Format of vertex attributes in the vertex buffer of static mesh. Applies only to meshes rendered on their own,
+	geometry arena always stores float vertices (getTriangleList decodes compressed ones).
+*/
+enum class VertexFormat
+{
+	Float, //!< 32-bit floats (32 bytes per vertex with all attributes)
+	Compressed //!< 16-bit positions within bounding box, half float texture coordinates, octahedral 2_10_10_10 normals (16 bytes per vertex)
+};
+
 /**
 	Represents generic 3D static mesh.
 */
@@ -15,7 +43,10 @@ public:
 	static const int TEXTURE_COORDINATE_ATTRIBUTE_INDEX; //!< Vertex attribute index of texture coordinate (1)
 	static const int NORMAL_ATTRIBUTE_INDEX; //!< Vertex attribute index of vertex normal (2)
 
-	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	/** \brief  Constructs static mesh. Concrete meshes get generated and uploaded by their constructors,
+	*           unless initialization is deferred - then generate() and upload() are left to the caller.
+	*/
+	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred = false);
 	virtual ~StaticMesh3D();
 
 	/** \brief  Renders static mesh. */
@@ -24,9 +55,29 @@ public:
 	/** \brief  Renders static mesh as points only. */
 	virtual void renderPoints() const {}
 
+	/** \brief  Renders several instances of static mesh in one draw call.
+	*   \param instanceBuffer Buffer with per-instance model and normal matrices
+	*   \param instanceCount  Number of instances to render
+	*/
+	void renderInstanced(const InstanceBuffer& instanceBuffer, GLsizei instanceCount) const;
+
 	/** \brief  Deletes static mesh data. */
 	virtual void deleteMesh();
 
+	/** \brief  Generates vertex (and index) data into in-memory buffers, without any OpenGL calls.
+	*           Can run on a worker thread, as long as no other thread touches the same mesh.
+	*           Does nothing, if data have been generated already.
+	*/
+	void generate();
+
+	/** \brief  Creates OpenGL objects and uploads generated data (on the thread with OpenGL context),
+	*           generating them first if needed. Mesh can be rendered afterwards.
+	*/
+	void upload();
+
+	/** \brief  Checks, if mesh has been uploaded and can be rendered. */
+	bool isInitialized() const;
+
 	/** \brief  Checks, if static mesh has vertex positions.
 	*   \return True if it has or false otherwise.
 	*/
@@ -42,25 +93,214 @@ public:
 	*/
 	bool hasNormals() const;
 
+	/** \brief  Gets layout of vertex attributes in the vertex buffer of this mesh. */
+	VertexLayout getVertexLayout() const;
+
+	/** \brief  Sets layout of vertex attributes used by meshes created from now on (interleaved by default).
+	*   \param vertexLayout Layout of vertex attributes
+	*/
+	static void setDefaultVertexLayout(VertexLayout vertexLayout);
+
+	/** \brief  Gets layout of vertex attributes used by newly created meshes. */
+	static VertexLayout getDefaultVertexLayout();
+
+	/** \brief  Gets format of vertex attributes in the vertex buffer of this mesh. */
+	VertexFormat getVertexFormat() const;
+
+	/** \brief  Sets format of vertex attributes used by meshes created from now on (float by default).
+	*   \param vertexFormat Format of vertex attributes
+	*/
+	static void setDefaultVertexFormat(VertexFormat vertexFormat);
+
+	/** \brief  Gets format of vertex attributes used by newly created meshes. */
+	static VertexFormat getDefaultVertexFormat();
+
+	/** \brief  Gets minimal / maximal corner of axis-aligned bounding box of the mesh (in model space). */
+	const glm::vec3& getBoundsMin() const;
+	const glm::vec3& getBoundsMax() const;
+
+	/** \brief  Gets center / radius of bounding sphere of the mesh (in model space). Sphere is centered
+	*           in the bounding box, its radius reaches the farthest generated vertex.
+	*/
+	glm::vec3 getBoundingSphereCenter() const;
+	float getBoundingSphereRadius() const;
+
+	/** \brief  Gets scale and bias, which turn positions read by vertex shader to model space
+	*           (position = bias + scale * attribute). Identity for float vertex format.
+	*/
+	glm::vec3 getPositionScale() const;
+	glm::vec3 getPositionBias() const;
+
+	/** \brief  Gets size of the vertex buffer in bytes. */
+	uint32_t getVertexBufferByteSize() const;
+
 	/** \brief  Calculates byte size of one vertex, depending on its attributes.
 	*   \return True if it has or false otherwise.
 	*/
 	int getVertexByteSize() const;
 
+	/** \brief  Gets generated or uploaded mesh geometry as indexed triangle list with interleaved vertices.
+	*           Generated data are read from memory, shared buffers are copied from the geometry store memory,
+	*           only buffers that are not shared are read back from the GPU. Strips and fans are converted
+	*           to triangles, missing attributes are zeroed. Doesn't need OpenGL, unless mesh has been uploaded.
+	*   \param meshData Mesh data to be filled
+	*/
+	void getTriangleList(MeshData& meshData) const;
+
 protected:
+	/**
+		Where one vertex attribute lives in the vertex buffer.
+	*/
+	struct AttributeLayout
+	{
+		bool isPresent; //!< Flag telling, if mesh has this attribute
+		size_t offset; //!< Byte offset of the attribute of the first vertex
+		size_t stride; //!< Byte distance between attributes of consecutive vertices
+		size_t size; //!< Byte size of the attribute of one vertex
+		GLint numComponents; //!< Number of components, as passed to glVertexAttribPointer
+		GLenum type; //!< Type of components, as passed to glVertexAttribPointer
+		GLboolean isNormalized; //!< Flag telling, if integer components are normalized
+	};
+
+	/**
+		Writes vertices into the in-memory vertex buffer in a single pass, whatever the vertex layout is.
+		Space for all vertices is reserved at once, so the writer just stores attributes at precomputed places.
+	*/
+	class VertexWriter
+	{
+	public:
+		/** \brief  Reserves space for all vertices of the mesh in its vertex buffer and sets mesh bounds.
+		*   \param mesh        Mesh, whose vertex buffer is filled
+		*   \param numVertices Number of vertices, which will be written
+		*   \param boundsMin   Minimal corner of bounding box of all written positions
+		*   \param boundsMax   Maximal corner of bounding box of all written positions
+		*/
+		VertexWriter(StaticMesh3D& mesh, int numVertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		/** \brief  Sets radius of mesh bounding sphere from all written positions. */
+		~VertexWriter();
+
+		/** \brief  Writes next vertex (attributes mesh doesn't have are skipped). */
+		void write(const glm::vec3& position, const glm::vec2& textureCoordinate, const glm::vec3& normal)
+		{
+			const auto offset = position - _sphereCenter;
+			_maxDistanceSquared = std::max(_maxDistanceSquared, glm::dot(offset, offset));
+
+			if (!_isCompressed)
+			{
+				writeAttribute(_positions, &position, sizeof(glm::vec3));
+				writeAttribute(_textureCoordinates, &textureCoordinate, sizeof(glm::vec2));
+				writeAttribute(_normals, &normal, sizeof(glm::vec3));
+				return;
+			}
+
+			// Attributes are encoded only when present, encoding is the expensive part
+			if (_positions.destination != nullptr)
+			{
+				const auto encodedPosition = vertex_compression::encodePosition(position, _boundsMin, _inverseScale);
+				writeAttribute(_positions, &encodedPosition, sizeof(encodedPosition));
+			}
+			if (_textureCoordinates.destination != nullptr)
+			{
+				const auto encodedTextureCoordinate = vertex_compression::encodeTextureCoordinate(textureCoordinate);
+				writeAttribute(_textureCoordinates, &encodedTextureCoordinate, sizeof(encodedTextureCoordinate));
+			}
+			if (_normals.destination != nullptr)
+			{
+				const auto encodedNormal = vertex_compression::encodeNormal(normal);
+				writeAttribute(_normals, &encodedNormal, sizeof(encodedNormal));
+			}
+		}
+
+		/** \brief  Writes all vertices of the row, in order. */
+		void writeRow(const VertexRow& row)
+		{
+			for (auto i = 0; i < row.size; i++) {
+				write(row.getPosition(i), row.getTextureCoordinate(i), row.getNormal(i));
+			}
+		}
+
+	private:
+		/**
+			Next place to write one attribute to.
+		*/
+		struct AttributeCursor
+		{
+			unsigned char* destination; //!< Where to write attribute of the next vertex (nullptr if not present)
+			size_t stride; //!< Byte distance between attributes of consecutive vertices
+		};
+
+		AttributeCursor _positions; //!< Cursor of vertex positions
+		AttributeCursor _textureCoordinates; //!< Cursor of texture coordinates
+		AttributeCursor _normals; //!< Cursor of vertex normals
+		bool _isCompressed; //!< Flag telling, if attributes are encoded (VertexFormat::Compressed)
+		glm::vec3 _boundsMin; //!< Minimal corner of bounding box, to which positions are quantized
+		glm::vec3 _inverseScale; //!< Reciprocal of bounding box extent (0 for flat dimensions)
+		StaticMesh3D& _mesh; //!< Mesh, whose vertex buffer is filled
+		glm::vec3 _sphereCenter; //!< Center of bounding sphere (center of bounding box)
+		float _maxDistanceSquared = 0.0f; //!< Squared distance of the farthest written position from sphere center
+
+		static void writeAttribute(AttributeCursor& cursor, const void* data, size_t dataSize)
+		{
+			if (cursor.destination != nullptr)
+			{
+				memcpy(cursor.destination, data, dataSize);
+				cursor.destination += cursor.stride;
+			}
+		}
+	};
+
+	static VertexLayout _defaultVertexLayout; //!< Vertex layout of newly created meshes
+	static VertexFormat _defaultVertexFormat; //!< Vertex format of newly created meshes
+
 	bool _hasPositions = false; //!< Flag telling, if we have vertex positions
 	bool _hasTextureCoordinates = false; //!< Flag telling, if we have texture coordinates
 	bool _hasNormals = false; //!< Flag telling, if we have vertex normals
+	VertexLayout _vertexLayout; //!< Layout of vertex attributes in the vertex buffer
+	VertexFormat _vertexFormat; //!< Format of vertex attributes in the vertex buffer
+	glm::vec3 _boundsMin = glm::vec3(0.0f); //!< Minimal corner of bounding box (set by VertexWriter)
+	glm::vec3 _boundsMax = glm::vec3(0.0f); //!< Maximal corner of bounding box (set by VertexWriter)
+	float _boundingSphereRadius = 0.0f; //!< Radius of bounding sphere around center of bounding box (set by VertexWriter)
 
+	bool _isInitializationDeferred; //!< Flag telling, if constructor leaves generation and upload to the caller
+	bool _isGenerated = false; //!< Flag telling, if generated data wait in in-memory buffers for upload
 	bool _isInitialized = false; //!< Is mesh initialized flag
 	GLuint _vao = 0; //!< VAO ID from OpenGL
 	VertexBufferObject _vbo; //!< Our VBO wrapper class holding static mesh data
+	int _numBufferVertices = 0; //!< Number of vertices in the VBO (set by VertexWriter)
+	mutable GLuint _instanceBufferID = 0; //!< ID of instance buffer, which is attached to the VAO
+
+	/** \brief  Initializes mesh, called by constructors of concrete meshes (unless initialization is deferred). */
+	void initializeData();
+
+	/** \brief  Generates vertex data through VertexWriter (CPU only, must not call OpenGL). */
+	virtual void generateData() {}
 
-	/** \brief  Initializes vertex data. */
-	virtual void initializeData() {};
+	/** \brief  Creates VAO and uploads generated vertex data with attribute pointers. */
+	virtual void uploadData();
 
-	/** \brief  Sets vertex attribute pointers in a standard way. */
+	/** \brief  Gets where attributes (indexed by attribute index) live in vertex buffer with given number of vertices. */
+	void getAttributeLayouts(int numVertices, AttributeLayout attributeLayouts[3]) const;
+
+	/** \brief  Sets vertex attribute pointers in a standard way (depending on vertex layout). */
 	void setVertexAttributesPointers(int numVertices);
+
+	/** \brief  Renders instances with VAO and instance buffer already bound. */
+	virtual void renderInstances(GLsizei /*instanceCount*/) const {}
+
+	/** \brief  Appends indices of all rendered triangles (in vertex buffer order) to the vector.
+	*           Base class appends nothing on purpose, meshes that don't override it have no triangle list.
+	*/
+	virtual void getTriangleIndices(std::vector<GLuint>& /*indices*/) const {}
+
+	/** \brief  Appends triangles of a triangle strip, which is restarted at every restart index. */
+	static void appendStripTriangles(const GLuint* stripIndices, size_t numStripIndices, GLuint restartIndex, std::vector<GLuint>& indices);
+
+	/** \brief  Appends triangles of a non-indexed triangle strip. */
+	static void appendStripTriangles(GLuint firstVertex, GLuint numVertices, std::vector<GLuint>& indices);
+
+	/** \brief  Appends triangles of a non-indexed triangle fan. */
+	static void appendFanTriangles(GLuint firstVertex, GLuint numVertices, std::vector<GLuint>& indices);
 };
 
 }; // namespace static_meshes_3D
\ No newline at end of file
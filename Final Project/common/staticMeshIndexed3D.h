@@ -10,17 +10,30 @@ namespace static_meshes_3D {
 class StaticMeshIndexed3D : public StaticMesh3D
 {
 public:
-	StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+	StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred = false);
 	virtual ~StaticMeshIndexed3D();
 
 	void deleteMesh() override;
 
+	//! Primitive restart index of all meshes (maximal unsigned index, as used by GL_PRIMITIVE_RESTART_FIXED_INDEX).
+	//! Being the same for every mesh, primitive restart can stay enabled for all indexed draws.
+	static const GLuint PRIMITIVE_RESTART_INDEX;
+
 protected:
 	VertexBufferObject _indicesVBO; //!< Our VBO wrapper class holding indices data
 
 	int _numVertices = 0; //!< Holds the total number of generated vertices
 	int _numIndices = 0; //!< Holds the number of generated indices used for rendering
-	int _primitiveRestartIndex = 0; //!< Index of primitive restart
+	GLuint _primitiveRestartIndex = PRIMITIVE_RESTART_INDEX; //!< Index of primitive restart
+
+	/** \brief  Uploads vertex data and indices generated into indices VBO (attached to the VAO). */
+	void uploadData() override;
+
+	/** \brief  Gets generated or uploaded indices. Generated ones are read from memory, shared buffers
+	*           are copied from the geometry store memory, only buffers that are not shared are read back from the GPU.
+	*   \return All indices as they are stored in the indices VBO.
+	*/
+	std::vector<GLuint> readIndices() const;
 };
 
 }; // namespace static_meshes_3D
\ No newline at end of file
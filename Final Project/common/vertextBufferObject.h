@@ -12,12 +12,27 @@
 class VertexBufferObject
 {
 public:
+	/**
+	  Writable range of typed elements, either in the in-memory buffer or in mapped GPU memory.
+	  Range stays valid only until more data are added / reserved or the buffer is unmapped.
+	*/
+	template<typename T>
+	struct DataRange
+	{
+		T* data; //! First element of the range
+		size_t size; //! Number of elements in the range
+
+		T* begin() const { return data; }
+		T* end() const { return data + size; }
+		T& operator[](size_t index) const { return data[index]; }
+	};
+
 	/** \brief Creates a new VBO, with optional reserved buffer size.
 	*   \param size Buffer size reservation, in bytes (so that memory allocations don't take place while adding data)
 	*/
 	void createVBO(uint32_t reserveSizeBytes = 0);
 
-	/** \brief Binds this vertex buffer object (makes current).
+	/** \brief Binds this vertex buffer object (makes current). OpenGL buffer name is generated on the first bind.
 	*   \param bufferType Type of the bound buffer (usually GL_ARRAY_BUFFER, but can be also GL_ELEMENT_BUFFER for instance)
 	*/
 	void bindVBO(GLenum bufferType = GL_ARRAY_BUFFER);
@@ -39,16 +54,65 @@ public:
 		addRawData(&obj, sizeof(T), repeat);
 	}
 
+	/** \brief Appends uninitialized space to the in-memory buffer, so that data can be written straight into it.
+	*   \param dataSizeBytes Size of the reserved space (in bytes)
+	*   \return Pointer to the reserved space.
+	*/
+	void* reserveRawData(uint32_t dataSizeBytes);
+
+	/** \brief Appends space for given number of elements to the in-memory buffer (see reserveRawData).
+	*   \param count Number of elements to be written
+	*   \return Writable range of the elements.
+	*/
+	template<typename T>
+	DataRange<T> reserveVertices(uint32_t count)
+	{
+		return DataRange<T>{ static_cast<T*>(reserveRawData(sizeof(T) * count)), count };
+	}
+
 	/** \brief Gets pointer to the data from in-memory buffer (only before uploading them).
 	*   \return Pointer to the raw data.
 	*/
 	void* getRawDataPointer();
 
+	/** \brief Gets read-only pointer to the data from in-memory buffer (only before uploading them).
+	*   \return Pointer to the raw data.
+	*/
+	const void* getRawDataPointer() const;
+
 	/** \brief Uploads gathered data to the GPU memory. Now the VBO is ready to be used.
 	*   \param usageHint Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	*/
 	void uploadDataToGPU(GLenum usageHint);
 
+	/** \brief Uploads gathered data to the GPU memory through the geometry store. If the same data have
+	*          already been uploaded by another VBO, that buffer is shared instead of uploading them again.
+	*          Shared buffer gets bound, so there's no need to bind this VBO before.
+	*   \param bufferType Type of the buffer (GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER...)
+	*   \param usageHint  Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+	*/
+	void uploadDataToGPUShared(GLenum bufferType, GLenum usageHint);
+
+	/** \brief Allocates GPU storage of the (bound) buffer and maps it for writing, skipping the in-memory buffer entirely.
+	*          Previous contents are orphaned, so mapping doesn't wait for the GPU. Call unmapBuffer when done.
+	*   \param dataSizeBytes Size of the buffer (in bytes)
+	*   \param usageHint     Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+	*   \return Pointer to the mapped data, or nullptr, if something fails.
+	*/
+	void* mapRawDataForWriting(uint32_t dataSizeBytes, GLenum usageHint);
+
+	/** \brief Allocates GPU storage for given number of elements and maps it for writing (see mapRawDataForWriting).
+	*   \param count     Number of elements to be written
+	*   \param usageHint Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+	*   \return Writable range of the elements (empty, if mapping fails).
+	*/
+	template<typename T>
+	DataRange<T> mapVerticesForWriting(uint32_t count, GLenum usageHint)
+	{
+		const auto data = static_cast<T*>(mapRawDataForWriting(sizeof(T) * count, usageHint));
+		return DataRange<T>{ data, data != nullptr ? count : 0 };
+	}
+
 	/** \brief Maps buffer data to a memory pointer.
 	*   \param usageHint Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	*   \return Pointer to the mapped data, or nullptr, if something fails.
@@ -69,24 +133,30 @@ public:
 	/** \brief Gets OpenGL-assigned buffer ID.
 	*   \return Buffer ID.
 	*/
-	GLuint getBufferID();
+	GLuint getBufferID() const;
 
 	/** \brief Gets buffer size, in bytes.
 	*   \return Buffer size in bytes.
 	*/
-	uint32_t getBufferSize();
+	uint32_t getBufferSize() const;
+
+	/** \brief Gets copy of the uploaded data. Shared buffers are copied from the geometry store memory,
+	*          only buffers that are not shared are read back from the GPU.
+	*   \return Uploaded data (empty, if nothing has been uploaded).
+	*/
+	std::vector<unsigned char> getUploadedData() const;
 
 	//* \brief Deletes VBO and frees memory and internal structures.
 	void deleteVBO();
 
 private:
 	GLuint _bufferID = 0; //! OpenGL assigned buffer ID
-	int _bufferType; //! Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
+	int _bufferType = GL_ARRAY_BUFFER; //! Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
 
-	std::vector<unsigned char> _rawData; //! In-memory raw data buffer, used to gather the data for VBO.
-	size_t _bytesAdded = 0; //! Number of bytes added to the buffer so far
+	std::vector<unsigned char> _rawData; //! In-memory raw data buffer, used to gather the data for VBO (its size is number of bytes added so far).
 	uint32_t _uploadedDataSize; //! Holds buffer data size after uploading to GPU
 
 	bool _isBufferCreated = false;
 	bool _isDataUploaded = false; //! Flag telling, if data has been uploaded to GPU already.
+	bool _isShared = false; //! Flag telling, if buffer is shared through the geometry store
 };
\ No newline at end of file
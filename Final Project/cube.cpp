@@ -3,6 +3,7 @@
 
 // Project
 #include "cube.h"
+#include "glStateCache.h"
 
 namespace static_meshes_3D {
 
@@ -38,8 +39,8 @@ namespace static_meshes_3D {
         glm::vec3(0.0f, -1.0f, 0.0f), // Bottom face
     };
 
-    Cube::Cube(glm::vec4 color, bool withPositions, bool withTextureCoordinates, bool withNormals)
-        : StaticMesh3D(withPositions, withTextureCoordinates, withNormals),
+    Cube::Cube(glm::vec4 color, bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
+        : StaticMesh3D(withPositions, withTextureCoordinates, withNormals, isInitializationDeferred),
         _color(color)
     {
         initializeData();
@@ -57,17 +58,29 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
+    void Cube::renderInstances(GLsizei instanceCount) const
+    {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
+    }
+
+    void Cube::getTriangleIndices(std::vector<GLuint>& indices) const
+    {
+        for (GLuint i = 0; i < 36; i++) {
+            indices.push_back(i);
+        }
+    }
+
     void Cube::renderPoints() const
     {
         if (!_isInitialized) {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
         glDrawArrays(GL_POINTS, 0, 36);
     }
 
@@ -77,7 +90,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
 
         if (facesBitmask & CUBE_FRONT_FACE) {
             glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -99,41 +112,15 @@ namespace static_meshes_3D {
         }
     }
 
-    void Cube::initializeData()
+    void Cube::generateData()
     {
-        if (_isInitialized) {
-            return;
-        }
-
-        glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
-
         const auto numVertices = 36;
-        const auto vertexByteSize = getVertexByteSize();
-        _vbo.createVBO(vertexByteSize * numVertices);
-        _vbo.bindVBO();
-
-        if (hasPositions())
-        {
-            _vbo.addRawData(vertices, sizeof(glm::vec3) * numVertices);
-        }
 
-        if (hasTextureCoordinates())
-        {
-            for (auto i = 0; i < 6; i++)
-            {
-                _vbo.addRawData(textureCoordinates, sizeof(glm::vec2) * 6);
-            }
+        // Every face repeats the same texture coordinates and has one normal
+        VertexWriter vertexWriter(*this, numVertices, glm::vec3(-0.5f), glm::vec3(0.5f));
+        for (auto i = 0; i < numVertices; i++) {
+            vertexWriter.write(vertices[i], textureCoordinates[i % 6], normals[i / 6]);
         }
-
-
-        // Add color for every vertex of cylinder bottom cover
-        _vbo.addData(_color, numVertices);
-
-
-        _vbo.uploadDataToGPU(GL_STATIC_DRAW);
-        setVertexAttributesPointers(numVertices);
-        _isInitialized = true;
     }
 
 } // namespace static_meshes_3D
\ No newline at end of file
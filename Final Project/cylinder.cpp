@@ -7,11 +7,12 @@
 
 // Project
 #include "cylinder.h"
+#include "glStateCache.h"
 
 namespace static_meshes_3D {
 
-	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals)
-		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
+		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals, isInitializationDeferred)
 		, _radius(radius)
 		, _numSlices(numSlices)
 		, _height(height)
@@ -34,123 +35,61 @@ namespace static_meshes_3D {
 		return _height;
 	}
 
-	void Cylinder::initializeData()
+	void Cylinder::generateData()
 	{
-		if (_isInitialized) {
-			return;
-		}
-
 		// Calculate and cache numbers of vertices
 		_numVerticesSide = (_numSlices + 1) * 2;
 		_numVerticesTopBottom = _numSlices + 2;
 		_numVerticesTotal = _numVerticesSide + _numVerticesTopBottom * 2;
 
-		// Generate VAO and VBO for vertex attributes
-		glGenVertexArrays(1, &_vao);
-		glBindVertexArray(_vao);
-		_vbo.createVBO(getVertexByteSize() * _numVerticesTotal);
-
-		// Pre-calculate sines / cosines for given number of slices
-		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
-		auto currentSliceAngle = 0.0f;
+		// Pre-calculate sines / cosines for given number of slices and circle of given radius made from them
 		std::vector<float> sines, cosines;
+		vertex_kernels::computeAngleTable(0.0f, 2.0f * glm::pi<float>() / float(_numSlices), _numSlices + 1, sines, cosines);
+		std::vector<float> circleX(_numSlices + 1), circleZ(_numSlices + 1);
+		vertex_kernels::affine(cosines.data(), _radius, 0.0f, circleX.data(), _numSlices + 1);
+		vertex_kernels::affine(sines.data(), _radius, 0.0f, circleZ.data(), _numSlices + 1);
+
+		// Pre-calculate step size in texture coordinate U
+		// I have decided to map the texture twice around cylinder, looks fine
+		const auto sliceTextureStepU = 2.0f / float(_numSlices);
+		const auto halfHeight = _height / 2.0f;
+		const auto topNormal = glm::vec3(0.0f, 1.0f, 0.0f);
+		const auto bottomNormal = glm::vec3(0.0f, -1.0f, 0.0f);
+		const glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
+
+		// Generate all vertices in one pass - position, texture coordinate and normal together
+		VertexWriter vertexWriter(*this, _numVerticesTotal, glm::vec3(-_radius, -halfHeight, -_radius), glm::vec3(_radius, halfHeight, _radius));
+
+		// Add cylinder side vertices
 		for (auto i = 0; i <= _numSlices; i++)
 		{
-			sines.push_back(sin(currentSliceAngle));
-			cosines.push_back(cos(currentSliceAngle));
-
-			// Update slice angle
-			currentSliceAngle += sliceAngleStep;
+			const auto x = circleX[i];
+			const auto z = circleZ[i];
+			const auto sideNormal = glm::vec3(cosines[i], 0.0f, sines[i]);
+			const auto currentSliceTexCoordU = i * sliceTextureStepU;
+			vertexWriter.write(glm::vec3(x, halfHeight, z), glm::vec2(currentSliceTexCoordU, 1.0f), sideNormal);
+			vertexWriter.write(glm::vec3(x, -halfHeight, z), glm::vec2(currentSliceTexCoordU, 0.0f), sideNormal);
 		}
 
-		if (hasPositions())
-		{
-			// Pre-calculate X and Z coordinates
-			std::vector<float> x;
-			std::vector<float> z;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				x.push_back(cosines[i] * _radius);
-				z.push_back(sines[i] * _radius);
-			}
-
-			// Add cylinder side vertices
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-
-			// Add top cylinder cover
-			glm::vec3 topCenterPosition(0.0f, _height / 2.0f, 0.0f);
-			_vbo.addRawData(&topCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-			}
-
-			// Add bottom cylinder cover
-			glm::vec3 bottomCenterPosition(0.0f, -_height / 2.0f, 0.0f);
-			_vbo.addRawData(&bottomCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, -z[i]);
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-		}
-
-		if (hasTextureCoordinates())
+		// Add top cylinder cover (circle texture coordinates)
+		vertexWriter.write(glm::vec3(0.0f, halfHeight, 0.0f), topBottomCenterTexCoord, topNormal);
+		for (auto i = 0; i <= _numSlices; i++)
 		{
-			// Pre-calculate step size in texture coordinate U
-			// I have decided to map the texture twice around cylinder, looks fine
-			const auto sliceTextureStepU = 2.0f / float(_numSlices);
-
-			auto currentSliceTexCoordU = 0.0f;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 1.0f));
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 0.0f));
-
-				// Update texture coordinate of current slice 
-				currentSliceTexCoordU += sliceTextureStepU;
-			}
-
-			// Generate circle texture coordinates for cylinder top cover
-			glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
-			}
-
-			// Generate circle texture coordinates for cylinder bottom cover
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
-			}
+			const auto x = circleX[i];
+			const auto z = circleZ[i];
+			const auto textureCoordinate = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f);
+			vertexWriter.write(glm::vec3(x, halfHeight, z), textureCoordinate, topNormal);
 		}
 
-		if (hasNormals())
+		// Add bottom cylinder cover (circle texture coordinates)
+		vertexWriter.write(glm::vec3(0.0f, -halfHeight, 0.0f), topBottomCenterTexCoord, bottomNormal);
+		for (auto i = 0; i <= _numSlices; i++)
 		{
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec3(cosines[i], 0.0f, sines[i]), 2);
-			}
-
-			// Add normal for every vertex of cylinder top cover
-			_vbo.addData(glm::vec3(0.0f, 1.0f, 0.0f), _numVerticesTopBottom);
-
-			// Add normal for every vertex of cylinder bottom cover
-			_vbo.addData(glm::vec3(0.0f, -1.0f, 0.0f), _numVerticesTopBottom);
+			const auto x = circleX[i];
+			const auto z = circleZ[i];
+			const auto textureCoordinate = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f);
+			vertexWriter.write(glm::vec3(x, -halfHeight, -z), textureCoordinate, bottomNormal);
 		}
-
-		// Finally upload data to the GPU
-		_vbo.bindVBO();
-		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
-		setVertexAttributesPointers(_numVerticesTotal);
-
-		_isInitialized = true;
 	}
 
 	void Cylinder::render() const
@@ -159,7 +98,7 @@ namespace static_meshes_3D {
 			return;
 		}
 
-		glBindVertexArray(_vao);
+		GLStateCache::getInstance().bindVertexArray(_vao);
 
 		// Render cylinder side first
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVerticesSide);
@@ -171,6 +110,26 @@ namespace static_meshes_3D {
 		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
 	}
 
+	void Cylinder::renderInstances(GLsizei instanceCount) const
+	{
+		// Render cylinder side first
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, _numVerticesSide, instanceCount);
+
+		// Render top cover
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom, instanceCount);
+
+		// Render bottom cover
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom, instanceCount);
+	}
+
+	void Cylinder::getTriangleIndices(std::vector<GLuint>& indices) const
+	{
+		// Side is a triangle strip, top and bottom covers are triangle fans
+		appendStripTriangles(0, _numVerticesSide, indices);
+		appendFanTriangles(_numVerticesSide, _numVerticesTopBottom, indices);
+		appendFanTriangles(_numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom, indices);
+	}
+
 	void Cylinder::renderPoints() const
 	{
 		if (!_isInitialized) {
@@ -178,7 +137,7 @@ namespace static_meshes_3D {
 		}
 
 		// Just render all points as they are stored in the VBO
-		glBindVertexArray(_vao);
+		GLStateCache::getInstance().bindVertexArray(_vao);
 		glDrawArrays(GL_POINTS, 0, _numVerticesTotal);
 	}
 
@@ -10,7 +10,7 @@ namespace static_meshes_3D {
 	{
 	public:
 		Cylinder(float radius, int numSlices, float height,
-			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true, bool isInitializationDeferred = false);
 
 		void render() const override;
 		void renderPoints() const override;
@@ -39,7 +39,9 @@ namespace static_meshes_3D {
 		int _numVerticesTopBottom; // How many vertices to render top / bottom of the cylinder
 		int _numVerticesTotal; // Just a sum of both numbers above
 
-		void initializeData() override;
+		void generateData() override;
+		void renderInstances(GLsizei instanceCount) const override;
+		void getTriangleIndices(std::vector<GLuint>& indices) const override;
 	};
 
 } // namespace static_meshes_3D
\ No newline at end of file
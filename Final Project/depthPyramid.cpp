@@ -0,0 +1,149 @@
+// STL
+#include <algorithm>
+#include <iostream>
+
+// Project
+#include "depthPyramid.h"
+
+namespace static_meshes_3D {
+
+    const GLuint DepthPyramid::WORK_GROUP_SIZE = 8;
+    const GLuint DepthPyramid::TEXTURE_UNIT = 1;
+
+    DepthPyramid::~DepthPyramid()
+    {
+        deletePyramid();
+    }
+
+    bool DepthPyramid::createPyramid(GLsizei width, GLsizei height)
+    {
+        deletePyramid();
+
+        _width = width;
+        _height = height;
+        _numLevels = 1;
+        while ((std::max(width, height) >> _numLevels) > 0) {
+            _numLevels++;
+        }
+
+        auto& stateCache = GLStateCache::getInstance();
+        stateCache.activeTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+
+        glGenTextures(1, &_depthTextureID);
+        stateCache.bindTexture(GL_TEXTURE_2D, _depthTextureID);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // Texels are always fetched exactly, never filtered
+        glGenTextures(1, &_pyramidTextureID);
+        stateCache.bindTexture(GL_TEXTURE_2D, _pyramidTextureID);
+        glTexStorage2D(GL_TEXTURE_2D, _numLevels, GL_R32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        stateCache.activeTexture(GL_TEXTURE0);
+
+        glGenFramebuffers(1, &_framebufferID);
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebufferID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depthTextureID, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        _isCreated = true;
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Failed to create occluder framebuffer (status 0x" << std::hex << status << std::dec << ")" << std::endl;
+            deletePyramid();
+            return false;
+        }
+
+        return true;
+    }
+
+    void DepthPyramid::beginOccluders()
+    {
+        glGetIntegerv(GL_VIEWPORT, _previousViewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebufferID);
+        glViewport(0, 0, _width, _height);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    void DepthPyramid::endOccluders()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(_previousViewport[0], _previousViewport[1], _previousViewport[2], _previousViewport[3]);
+    }
+
+    void DepthPyramid::build(const Shader& pyramidShader)
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        auto& stateCache = GLStateCache::getInstance();
+        stateCache.activeTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        stateCache.bindTexture(GL_TEXTURE_2D, _depthTextureID);
+        stateCache.activeTexture(GL_TEXTURE0);
+
+        pyramidShader.use();
+        pyramidShader.setInt("depthTexture", TEXTURE_UNIT);
+        for (auto level = 0; level < _numLevels; level++)
+        {
+            // Every level reads the one before it, so they're reduced one after another
+            const auto levelWidth = static_cast<GLuint>(std::max(1, _width >> level));
+            const auto levelHeight = static_cast<GLuint>(std::max(1, _height >> level));
+            pyramidShader.setBool("isFirstLevel", level == 0);
+            glBindImageTexture(0, _pyramidTextureID, std::max(0, level - 1), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            glBindImageTexture(1, _pyramidTextureID, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            glDispatchCompute((levelWidth + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, (levelHeight + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+
+        // Culling shader fetches the pyramid as texture
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    void DepthPyramid::bindPyramid() const
+    {
+        auto& stateCache = GLStateCache::getInstance();
+        stateCache.activeTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        stateCache.bindTexture(GL_TEXTURE_2D, _pyramidTextureID);
+        stateCache.activeTexture(GL_TEXTURE0);
+    }
+
+    GLsizei DepthPyramid::getWidth() const
+    {
+        return _width;
+    }
+
+    GLsizei DepthPyramid::getHeight() const
+    {
+        return _height;
+    }
+
+    int DepthPyramid::getNumLevels() const
+    {
+        return _numLevels;
+    }
+
+    void DepthPyramid::deletePyramid()
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        auto& stateCache = GLStateCache::getInstance();
+        glDeleteFramebuffers(1, &_framebufferID);
+        stateCache.onTextureDeleted(_depthTextureID);
+        glDeleteTextures(1, &_depthTextureID);
+        stateCache.onTextureDeleted(_pyramidTextureID);
+        glDeleteTextures(1, &_pyramidTextureID);
+        _framebufferID = 0;
+        _depthTextureID = 0;
+        _pyramidTextureID = 0;
+        _isCreated = false;
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,87 @@
+#pragma once
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "shader.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Hierarchical depth (Hi-Z) of occluders. Occluders are drawn depth-only to an offscreen depth
+     * texture, which is then reduced to a mipmapped pyramid, where every texel holds the farthest depth
+     * of the texels it covers. Any box, whose nearest depth is behind the farthest depth of the area it
+     * covers, is hidden, and a few texels of a matching level tell that for a box of any size.
+     */
+    class DepthPyramid
+    {
+    public:
+        static const GLuint WORK_GROUP_SIZE; // Texels reduced by one work group along x and y (8, local size of the shader)
+        static const GLuint TEXTURE_UNIT; // Texture unit the pyramid is bound to for culling (1, unit 0 holds materials)
+
+        DepthPyramid() = default;
+        DepthPyramid(const DepthPyramid&) = delete;
+        DepthPyramid& operator=(const DepthPyramid&) = delete;
+        ~DepthPyramid();
+
+        /**
+         * Creates depth texture of occluders, its framebuffer and the pyramid.
+         *
+         * @param width   Width of occluder depth (in pixels)
+         * @param height  Height of occluder depth (in pixels)
+         *
+         * @return True, if the framebuffer is complete, false otherwise.
+         */
+        bool createPyramid(GLsizei width, GLsizei height);
+
+        /**
+         * Binds occluder framebuffer (with its own viewport) and clears its depth. Occluders are drawn next.
+         */
+        void beginOccluders();
+
+        /**
+         * Binds default framebuffer again, with the viewport it had before occluders.
+         */
+        void endOccluders();
+
+        /**
+         * Reduces occluder depth to all levels of the pyramid.
+         *
+         * @param pyramidShader  Compute shader program (shaderfiles/depth_pyramid.cs)
+         */
+        void build(const Shader& pyramidShader);
+
+        /**
+         * Binds the pyramid to TEXTURE_UNIT.
+         */
+        void bindPyramid() const;
+
+        /**
+         * Gets size of level 0 of the pyramid (same as occluder depth).
+         */
+        GLsizei getWidth() const;
+        GLsizei getHeight() const;
+
+        /**
+         * Gets number of levels of the pyramid.
+         */
+        int getNumLevels() const;
+
+        /**
+         * Deletes textures and framebuffer.
+         */
+        void deletePyramid();
+
+    private:
+        GLuint _framebufferID = 0; // Framebuffer occluders are drawn to
+        GLuint _depthTextureID = 0; // Depth attachment of the framebuffer
+        GLuint _pyramidTextureID = 0; // Farthest depth of all levels (R32F)
+        GLsizei _width = 0; // Width of level 0
+        GLsizei _height = 0; // Height of level 0
+        int _numLevels = 0; // Number of levels, down to 1x1
+        GLint _previousViewport[4] = { 0, 0, 0, 0 }; // Viewport restored after occluders are drawn
+        bool _isCreated = false; // Flag telling, if textures have been created already
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,44 @@
+// Project
+#include "frameUniformBuffer.h"
+
+const GLuint FrameUniformBuffer::BINDING_POINT = 0;
+const char* FrameUniformBuffer::BLOCK_NAME = "FrameData";
+
+FrameUniformBuffer::~FrameUniformBuffer()
+{
+    deleteBuffer();
+}
+
+void FrameUniformBuffer::createBuffer()
+{
+    if (_isCreated) {
+        return;
+    }
+
+    glGenBuffers(1, &_bufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniformData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING_POINT, _bufferID);
+    _isCreated = true;
+}
+
+void FrameUniformBuffer::update(const FrameUniformData& frameData)
+{
+    if (!_isCreated) {
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniformData), &frameData);
+}
+
+void FrameUniformBuffer::deleteBuffer()
+{
+    if (!_isCreated) {
+        return;
+    }
+
+    glDeleteBuffers(1, &_bufferID);
+    _bufferID = 0;
+    _isCreated = false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+/**
+ * Per-frame data shared by all shader programs, laid out exactly as uniform block
+ * "FrameData" with std140 layout (every vec3 is padded to 16 bytes).
+ */
+struct FrameUniformData
+{
+    glm::mat4 view; // View matrix of the camera
+    glm::mat4 projection; // Projection matrix (perspective or ortho)
+    glm::vec3 objectColor; // Base color of objects
+    float padding0;
+    glm::vec3 lightColor; // Color of the light
+    float padding1;
+    glm::vec3 lightPos; // Position of the light in world space
+    float padding2;
+    glm::vec3 viewPosition; // Position of the camera in world space
+    float padding3;
+};
+
+static_assert(sizeof(FrameUniformData) == 2 * 64 + 4 * 16, "FrameUniformData must match std140 layout of FrameData block");
+
+/**
+ * Uniform buffer holding FrameUniformData. The buffer is bound to BINDING_POINT, so every
+ * program with FrameData block bound to that point reads the same data, uploaded once per frame.
+ */
+class FrameUniformBuffer
+{
+public:
+    static const GLuint BINDING_POINT; // Uniform buffer binding point of FrameData block (0)
+    static const char* BLOCK_NAME; // Name of the uniform block in shaders ("FrameData")
+
+    FrameUniformBuffer() = default;
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+    ~FrameUniformBuffer();
+
+    /**
+     * Creates the buffer and binds it to BINDING_POINT.
+     */
+    void createBuffer();
+
+    /**
+     * Uploads per-frame data to the buffer.
+     */
+    void update(const FrameUniformData& frameData);
+
+    /**
+     * Deletes the buffer.
+     */
+    void deleteBuffer();
+
+private:
+    GLuint _bufferID = 0; // OpenGL assigned buffer ID
+    bool _isCreated = false; // Flag telling, if buffer has been created already
+};
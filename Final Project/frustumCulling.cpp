@@ -0,0 +1,322 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Project
+#include "frustumCulling.h"
+#include "vertexKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRUSTUM_CULLING_X86
+#include <immintrin.h>
+#endif
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang need them enabled per function
+#if defined(FRUSTUM_CULLING_X86) && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace static_meshes_3D {
+
+    namespace {
+
+        /**
+         * Bound arrays and planes, as passed to the culling kernels.
+         */
+        struct CullingInput
+        {
+            const float* centerX;
+            const float* centerY;
+            const float* centerZ;
+            const float* extentX;
+            const float* extentY;
+            const float* extentZ;
+            const float* radius;
+            const glm::vec4* planes;
+        };
+
+        // Object is outside, when its center is farther behind a plane than the smaller of its two reaches
+        // towards the plane - projected half extent of the box, or radius of the sphere
+
+        int cullScalar(const CullingInput& input, int first, int count, uint8_t* visibility)
+        {
+            auto numVisible = 0;
+            for (auto i = first; i < first + count; i++)
+            {
+                auto isVisible = true;
+                for (auto p = 0; p < 6 && isVisible; p++)
+                {
+                    const auto& plane = input.planes[p];
+                    const auto distance = plane.x * input.centerX[i] + plane.y * input.centerY[i] + plane.z * input.centerZ[i] + plane.w;
+                    const auto boxReach = std::abs(plane.x) * input.extentX[i] + std::abs(plane.y) * input.extentY[i] + std::abs(plane.z) * input.extentZ[i];
+                    isVisible = distance >= -std::min(boxReach, input.radius[i]);
+                }
+
+                visibility[i] = isVisible ? 1 : 0;
+                numVisible += isVisible ? 1 : 0;
+            }
+
+            return numVisible;
+        }
+
+#ifdef FRUSTUM_CULLING_X86
+        /**
+         * Writes visibility of a vector of objects from bit mask of culled ones.
+         *
+         * @return Number of visible objects.
+         */
+        int storeVisibility(int outsideMask, int numObjects, uint8_t* visibility)
+        {
+            // Bytes of every 8-bit mask are looked up, so the vector is written with one store
+            static const struct VisibilityTable
+            {
+                VisibilityTable()
+                {
+                    for (auto mask = 0; mask < 256; mask++)
+                    {
+                        numVisible[mask] = 0;
+                        for (auto j = 0; j < 8; j++)
+                        {
+                            bytes[mask][j] = ((mask >> j) & 1) == 0 ? 1 : 0;
+                            numVisible[mask] += bytes[mask][j];
+                        }
+                    }
+                }
+
+                uint8_t bytes[256][8];
+                uint8_t numVisible[256];
+            } table;
+
+            memcpy(visibility, table.bytes[outsideMask], numObjects);
+            return table.numVisible[outsideMask | (0xFF << numObjects & 0xFF)];
+        }
+
+        // Vector loops handle whole vectors only, the rest is finished by scalar kernel
+
+        TARGET_SSE2 int cullSSE2(const CullingInput& input, int count, uint8_t* visibility)
+        {
+            // Planes are broadcast once, not in every iteration
+            __m128 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+            for (auto p = 0; p < 6; p++)
+            {
+                const auto& plane = input.planes[p];
+                planeX[p] = _mm_set1_ps(plane.x);
+                planeY[p] = _mm_set1_ps(plane.y);
+                planeZ[p] = _mm_set1_ps(plane.z);
+                planeW[p] = _mm_set1_ps(plane.w);
+                absPlaneX[p] = _mm_set1_ps(std::abs(plane.x));
+                absPlaneY[p] = _mm_set1_ps(std::abs(plane.y));
+                absPlaneZ[p] = _mm_set1_ps(std::abs(plane.z));
+            }
+
+            const auto signMask = _mm_set1_ps(-0.0f);
+            auto numVisible = 0;
+            auto i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto centerX = _mm_loadu_ps(input.centerX + i);
+                const auto centerY = _mm_loadu_ps(input.centerY + i);
+                const auto centerZ = _mm_loadu_ps(input.centerZ + i);
+                const auto extentX = _mm_loadu_ps(input.extentX + i);
+                const auto extentY = _mm_loadu_ps(input.extentY + i);
+                const auto extentZ = _mm_loadu_ps(input.extentZ + i);
+                const auto radius = _mm_loadu_ps(input.radius + i);
+                // Planes are tested until all objects of the vector are known to be outside
+                auto outside = _mm_setzero_ps();
+                for (auto p = 0; p < 6 && _mm_movemask_ps(outside) != 0xF; p++)
+                {
+                    const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+                        _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+                    const auto boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[p], extentX), _mm_mul_ps(absPlaneY[p], extentY)),
+                        _mm_mul_ps(absPlaneZ[p], extentZ));
+                    const auto negativeReach = _mm_xor_ps(_mm_min_ps(boxReach, radius), signMask);
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeReach));
+                }
+
+                numVisible += storeVisibility(_mm_movemask_ps(outside), 4, visibility + i);
+            }
+
+            return numVisible + cullScalar(input, i, count - i, visibility);
+        }
+
+        TARGET_AVX2 int cullAVX2(const CullingInput& input, int count, uint8_t* visibility)
+        {
+            // Planes are broadcast once, not in every iteration
+            __m256 planeX[6], planeY[6], planeZ[6], planeW[6], absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+            for (auto p = 0; p < 6; p++)
+            {
+                const auto& plane = input.planes[p];
+                planeX[p] = _mm256_set1_ps(plane.x);
+                planeY[p] = _mm256_set1_ps(plane.y);
+                planeZ[p] = _mm256_set1_ps(plane.z);
+                planeW[p] = _mm256_set1_ps(plane.w);
+                absPlaneX[p] = _mm256_set1_ps(std::abs(plane.x));
+                absPlaneY[p] = _mm256_set1_ps(std::abs(plane.y));
+                absPlaneZ[p] = _mm256_set1_ps(std::abs(plane.z));
+            }
+
+            const auto signMask = _mm256_set1_ps(-0.0f);
+            auto numVisible = 0;
+            auto i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto centerX = _mm256_loadu_ps(input.centerX + i);
+                const auto centerY = _mm256_loadu_ps(input.centerY + i);
+                const auto centerZ = _mm256_loadu_ps(input.centerZ + i);
+                const auto extentX = _mm256_loadu_ps(input.extentX + i);
+                const auto extentY = _mm256_loadu_ps(input.extentY + i);
+                const auto extentZ = _mm256_loadu_ps(input.extentZ + i);
+                const auto radius = _mm256_loadu_ps(input.radius + i);
+                // Planes are tested until all objects of the vector are known to be outside
+                auto outside = _mm256_setzero_ps();
+                for (auto p = 0; p < 6 && _mm256_movemask_ps(outside) != 0xFF; p++)
+                {
+                    const auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX), _mm256_mul_ps(planeY[p], centerY)),
+                        _mm256_add_ps(_mm256_mul_ps(planeZ[p], centerZ), planeW[p]));
+                    const auto boxReach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absPlaneX[p], extentX), _mm256_mul_ps(absPlaneY[p], extentY)),
+                        _mm256_mul_ps(absPlaneZ[p], extentZ));
+                    const auto negativeReach = _mm256_xor_ps(_mm256_min_ps(boxReach, radius), signMask);
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeReach, _CMP_LT_OQ));
+                }
+
+                numVisible += storeVisibility(_mm256_movemask_ps(outside), 8, visibility + i);
+            }
+
+            return numVisible + cullScalar(input, i, count - i, visibility);
+        }
+#endif
+
+    } // unnamed namespace
+
+    Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+    {
+        // Clip space point is inside, when -w <= x, y, z <= w, so every plane is row 3 +- another row
+        const auto row = [&viewProjection](int index) {
+            return glm::vec4(viewProjection[0][index], viewProjection[1][index], viewProjection[2][index], viewProjection[3][index]);
+        };
+
+        Frustum frustum;
+        for (auto i = 0; i < 3; i++)
+        {
+            frustum.planes[i * 2] = row(3) + row(i);
+            frustum.planes[i * 2 + 1] = row(3) - row(i);
+        }
+
+        for (auto& plane : frustum.planes)
+        {
+            const auto normalLength = glm::length(glm::vec3(plane));
+            plane = normalLength > 0.0f ? plane / normalLength : plane;
+        }
+
+        return frustum;
+    }
+
+    Frustum::Containment Frustum::classifyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const
+    {
+        const auto center = (boundsMin + boundsMax) * 0.5f;
+        const auto halfExtent = (boundsMax - boundsMin) * 0.5f;
+        auto containment = Containment::Inside;
+        for (const auto& plane : planes)
+        {
+            const auto distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            const auto reach = std::abs(plane.x) * halfExtent.x + std::abs(plane.y) * halfExtent.y + std::abs(plane.z) * halfExtent.z;
+            if (distance < -reach) {
+                return Containment::Outside;
+            }
+            if (distance < reach) {
+                containment = Containment::Intersecting;
+            }
+        }
+
+        return containment;
+    }
+
+    int CullingBounds::add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius, const glm::mat4& model)
+    {
+        const auto index = size();
+        for (auto array : { &_centerX, &_centerY, &_centerZ, &_extentX, &_extentY, &_extentZ, &_radius }) {
+            array->push_back(0.0f);
+        }
+
+        set(index, boundsMin, boundsMax, radius, model);
+        return index;
+    }
+
+    void CullingBounds::set(int index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius, const glm::mat4& model)
+    {
+        const auto center = glm::vec3(model * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+        const auto halfExtent = (boundsMax - boundsMin) * 0.5f;
+
+        // Box rotated by the model matrix is enclosed by box with absolute values of the matrix applied
+        glm::vec3 extent(0.0f);
+        for (auto column = 0; column < 3; column++)
+        {
+            for (auto axis = 0; axis < 3; axis++) {
+                extent[axis] += std::abs(model[column][axis]) * halfExtent[column];
+            }
+        }
+
+        const auto maxScale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        _centerX[index] = center.x;
+        _centerY[index] = center.y;
+        _centerZ[index] = center.z;
+        _extentX[index] = extent.x;
+        _extentY[index] = extent.y;
+        _extentZ[index] = extent.z;
+        _radius[index] = radius * maxScale;
+    }
+
+    int CullingBounds::append(const CullingBounds& source, int sourceIndex)
+    {
+        const auto index = size();
+        _centerX.push_back(source._centerX[sourceIndex]);
+        _centerY.push_back(source._centerY[sourceIndex]);
+        _centerZ.push_back(source._centerZ[sourceIndex]);
+        _extentX.push_back(source._extentX[sourceIndex]);
+        _extentY.push_back(source._extentY[sourceIndex]);
+        _extentZ.push_back(source._extentZ[sourceIndex]);
+        _radius.push_back(source._radius[sourceIndex]);
+        return index;
+    }
+
+    int CullingBounds::size() const
+    {
+        return static_cast<int>(_centerX.size());
+    }
+
+    void CullingBounds::clear()
+    {
+        for (auto array : { &_centerX, &_centerY, &_centerZ, &_extentX, &_extentY, &_extentZ, &_radius }) {
+            array->clear();
+        }
+    }
+
+    int CullingBounds::cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const
+    {
+        const auto count = size();
+        visibility.resize(count);
+        const CullingInput input{ _centerX.data(), _centerY.data(), _centerZ.data(),
+            _extentX.data(), _extentY.data(), _extentZ.data(), _radius.data(), frustum.planes };
+
+        // Same instruction set as vertex kernels, so that all SIMD paths are selected (and benchmarked) together
+#ifdef FRUSTUM_CULLING_X86
+        switch (vertex_kernels::getInstructionSet())
+        {
+        case vertex_kernels::InstructionSet::AVX2:
+            return cullAVX2(input, count, visibility.data());
+        case vertex_kernels::InstructionSet::SSE2:
+            return cullSSE2(input, count, visibility.data());
+        default:
+            break;
+        }
+#endif
+
+        return cullScalar(input, 0, count, visibility.data());
+    }
+
+} // namespace static_meshes_3D
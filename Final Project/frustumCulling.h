@@ -0,0 +1,99 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+namespace static_meshes_3D {
+
+    /**
+     * View frustum as six planes facing inside, extracted from projection * view matrix. Works for
+     * any projection (perspective or orthographic), as planes come from clip space bounds.
+     */
+    struct Frustum
+    {
+        /**
+         * Where a volume lies relative to the frustum.
+         */
+        enum class Containment
+        {
+            Outside, // Completely outside
+            Intersecting, // Partially inside (or near a corner of the frustum)
+            Inside // Completely inside
+        };
+
+        glm::vec4 planes[6]; // Left, right, bottom, top, near, far (xyz is unit normal, w distance)
+
+        /**
+         * Extracts planes of the frustum (world space planes for projection * view matrix).
+         */
+        static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+        /**
+         * Classifies axis-aligned box against the frustum.
+         */
+        Containment classifyBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+    };
+
+    /**
+     * World space bounds of many objects, stored as structure of arrays for culling many objects
+     * at once. Every object has a bounding box and a bounding sphere sharing one center; object is
+     * culled, when either of them is completely behind one of the frustum planes.
+     */
+    class CullingBounds
+    {
+    public:
+        /**
+         * Adds object, whose model space bounds are transformed by its model matrix.
+         *
+         * @param boundsMin  Minimal corner of bounding box (in model space)
+         * @param boundsMax  Maximal corner of bounding box (in model space)
+         * @param radius     Radius of bounding sphere around center of the box (in model space)
+         * @param model      Model matrix of the object
+         *
+         * @return Index of the object.
+         */
+        int add(const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius, const glm::mat4& model);
+
+        /**
+         * Replaces bounds of already added object (e.g. when it moves).
+         */
+        void set(int index, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius, const glm::mat4& model);
+
+        /**
+         * Adds copy of object of other bounds (e.g. to gather a batch of objects to cull).
+         *
+         * @return Index of the object.
+         */
+        int append(const CullingBounds& source, int sourceIndex);
+
+        /**
+         * Gets number of objects.
+         */
+        int size() const;
+
+        /**
+         * Removes all objects.
+         */
+        void clear();
+
+        /**
+         * Tests all objects against the frustum.
+         *
+         * @param frustum     Frustum to test against
+         * @param visibility  Gets 1 for every object intersecting the frustum, 0 for culled one
+         *
+         * @return Number of visible objects.
+         */
+        int cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const;
+
+    private:
+        std::vector<float> _centerX, _centerY, _centerZ; // Centers of boxes and spheres
+        std::vector<float> _extentX, _extentY, _extentZ; // Half extents of axis-aligned world space boxes
+        std::vector<float> _radius; // Radii of spheres
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,434 @@
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+// Project
+#include "geometryArena.h"
+#include "common/staticMesh3D.h"
+#include "glStateCache.h"
+
+namespace static_meshes_3D {
+
+    const int GeometryArena::INVALID_MESH_HANDLE = -1;
+    const int GeometryArena::NUM_INDIRECT_BUFFERS = 9;
+
+    GeometryArena::GeometryArena(GLuint initialVertexCapacity, GLuint initialIndexCapacity)
+        : _initialVertexCapacity(std::max(initialVertexCapacity, 1u))
+        , _initialIndexCapacity(std::max(initialIndexCapacity, 1u)) {}
+
+    GeometryArena::~GeometryArena()
+    {
+        deleteArena();
+    }
+
+    int GeometryArena::addMesh(const MeshData& meshData)
+    {
+        return addMesh(meshData.vertices.data(), static_cast<GLuint>(meshData.vertices.size()),
+            meshData.indices.data(), static_cast<GLuint>(meshData.indices.size()));
+    }
+
+    int GeometryArena::addMesh(const MeshVertex* vertices, GLuint numVertices, const GLuint* indices, GLuint numIndices)
+    {
+        if (!_isCreated) {
+            createArena();
+        }
+
+        MeshAllocation allocation{ 0, numVertices, 0, numIndices };
+        auto hasVertices = _vertexAllocator.allocate(numVertices, allocation.firstVertex);
+        auto hasIndices = _indexAllocator.allocate(numIndices, allocation.firstIndex);
+        if (!hasVertices || !hasIndices)
+        {
+            // Give back what we got, then compact and grow the buffers so that the mesh fits
+            if (hasVertices) {
+                _vertexAllocator.free(allocation.firstVertex, numVertices);
+            }
+            if (hasIndices) {
+                _indexAllocator.free(allocation.firstIndex, numIndices);
+            }
+
+            GLuint vertexCapacity, indexCapacity;
+            if (!getGrownCapacity(_vertexAllocator.getCapacity(), _vertexAllocator.getNumUsed(), numVertices, vertexCapacity)
+                || !getGrownCapacity(_indexAllocator.getCapacity(), _indexAllocator.getNumUsed(), numIndices, indexCapacity))
+            {
+                std::cout << "Geometry arena cannot grow to fit mesh with " << numVertices << " vertices and " << numIndices << " indices!" << std::endl;
+                return INVALID_MESH_HANDLE;
+            }
+
+            relocate(vertexCapacity, indexCapacity);
+            _vertexAllocator.allocate(numVertices, allocation.firstVertex);
+            _indexAllocator.allocate(numIndices, allocation.firstIndex);
+        }
+
+        // Upload through copy write target, so that no VAO state is touched
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _vertexBufferID);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(MeshVertex) * allocation.firstVertex, sizeof(MeshVertex) * numVertices, vertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _indexBufferID);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * allocation.firstIndex, sizeof(GLuint) * numIndices, indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        const auto meshHandle = _nextMeshHandle++;
+        _meshes[meshHandle] = allocation;
+        return meshHandle;
+    }
+
+    void GeometryArena::removeMesh(int meshHandle)
+    {
+        const auto it = _meshes.find(meshHandle);
+        if (it == _meshes.end()) {
+            return;
+        }
+
+        _vertexAllocator.free(it->second.firstVertex, it->second.numVertices);
+        _indexAllocator.free(it->second.firstIndex, it->second.numIndices);
+        _meshes.erase(it);
+        _areCommandsDirty = true;
+    }
+
+    void GeometryArena::compact()
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        relocate(_vertexAllocator.getCapacity(), _indexAllocator.getCapacity());
+    }
+
+    void GeometryArena::clearCommands()
+    {
+        _recordedCommands.clear();
+        _areCommandsDirty = true;
+    }
+
+    void GeometryArena::addCommand(int meshHandle, GLuint baseInstance, GLuint instanceCount)
+    {
+        _recordedCommands.push_back(RecordedCommand{ meshHandle, baseInstance, instanceCount });
+        _areCommandsDirty = true;
+    }
+
+    size_t GeometryArena::getNumCommands() const
+    {
+        return _recordedCommands.size();
+    }
+
+    void GeometryArena::bind(const InstanceBuffer& instanceBuffer)
+    {
+        if (!_isCreated) {
+            createArena();
+        }
+
+        GLStateCache::getInstance().bindVertexArray(_vao);
+
+        // Attach instance attributes to our VAO only when instance buffer changes
+        if (_instanceBufferID != instanceBuffer.getBufferID())
+        {
+            instanceBuffer.setVertexAttributesPointers();
+            _instanceBufferID = instanceBuffer.getBufferID();
+        }
+    }
+
+    void GeometryArena::submitCommands()
+    {
+        submitCommands(0, _recordedCommands.size());
+    }
+
+    void GeometryArena::submitCommands(size_t firstCommand, size_t numCommands)
+    {
+        if (!_isCreated || numCommands == 0) {
+            return;
+        }
+
+        if (_areCommandsDirty) {
+            uploadCommands();
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBufferIDs[_indirectBufferIndex]);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(sizeof(DrawElementsIndirectCommand) * firstCommand),
+            static_cast<GLsizei>(numCommands), 0);
+    }
+
+    void GeometryArena::submitIndirectBuffer(GLuint indirectBufferID, size_t numCommands)
+    {
+        if (!_isCreated || numCommands == 0) {
+            return;
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBufferID);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(numCommands), 0);
+    }
+
+    GeometryArena::DrawElementsIndirectCommand GeometryArena::getDrawCommand(int meshHandle, GLuint baseInstance, GLuint instanceCount) const
+    {
+        const auto it = _meshes.find(meshHandle);
+        if (it == _meshes.end()) {
+            return DrawElementsIndirectCommand{ 0, 0, 0, 0, 0 };
+        }
+
+        const auto& allocation = it->second;
+        return DrawElementsIndirectCommand{ allocation.numIndices, instanceCount,
+            allocation.firstIndex, static_cast<GLint>(allocation.firstVertex), baseInstance };
+    }
+
+    GLuint GeometryArena::getNumVerticesUsed() const
+    {
+        return _vertexAllocator.getNumUsed();
+    }
+
+    GLuint GeometryArena::getVertexCapacity() const
+    {
+        return _vertexAllocator.getCapacity();
+    }
+
+    GLuint GeometryArena::getNumIndices(int meshHandle) const
+    {
+        const auto it = _meshes.find(meshHandle);
+        return it != _meshes.end() ? it->second.numIndices : 0;
+    }
+
+    GLuint GeometryArena::getNumIndicesUsed() const
+    {
+        return _indexAllocator.getNumUsed();
+    }
+
+    GLuint GeometryArena::getIndexCapacity() const
+    {
+        return _indexAllocator.getCapacity();
+    }
+
+    GLuint GeometryArena::getVertexArrayID() const
+    {
+        return _vao;
+    }
+
+    void GeometryArena::deleteArena()
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        glDeleteVertexArrays(1, &_vao);
+        GLStateCache::getInstance().onVertexArrayDeleted(_vao);
+        glDeleteBuffers(1, &_vertexBufferID);
+        glDeleteBuffers(1, &_indexBufferID);
+        glDeleteBuffers(NUM_INDIRECT_BUFFERS, _indirectBufferIDs.data());
+        _indirectBufferIDs.clear();
+        _indirectBufferCapacities.clear();
+
+        _meshes.clear();
+        _recordedCommands.clear();
+        _instanceBufferID = 0;
+        _isCreated = false;
+    }
+
+    void GeometryArena::createArena()
+    {
+        glGenVertexArrays(1, &_vao);
+        glGenBuffers(1, &_vertexBufferID);
+        glGenBuffers(1, &_indexBufferID);
+        _indirectBufferIDs.resize(NUM_INDIRECT_BUFFERS);
+        _indirectBufferCapacities.assign(NUM_INDIRECT_BUFFERS, 0);
+        glGenBuffers(NUM_INDIRECT_BUFFERS, _indirectBufferIDs.data());
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _vertexBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(MeshVertex) * _initialVertexCapacity, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _indexBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * _initialIndexCapacity, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        _vertexAllocator.reset(_initialVertexCapacity);
+        _indexAllocator.reset(_initialIndexCapacity);
+        _isCreated = true;
+
+        setVertexAttributesPointers();
+    }
+
+    bool GeometryArena::getGrownCapacity(GLuint capacity, GLuint numUsed, GLuint numRequested, GLuint& grownCapacity)
+    {
+        // Computed in 64 bits, doubling a large capacity must not wrap around
+        const uint64_t maxCapacity = std::numeric_limits<GLuint>::max();
+        const auto requiredCapacity = static_cast<uint64_t>(numUsed) + numRequested;
+        if (requiredCapacity > maxCapacity) {
+            return false;
+        }
+
+        auto newCapacity = std::max(static_cast<uint64_t>(capacity), uint64_t(1));
+        while (newCapacity < requiredCapacity) {
+            newCapacity *= 2;
+        }
+
+        grownCapacity = static_cast<GLuint>(std::min(newCapacity, maxCapacity));
+        return true;
+    }
+
+    void GeometryArena::relocate(GLuint vertexCapacity, GLuint indexCapacity)
+    {
+        GLuint newVertexBufferID = 0, newIndexBufferID = 0;
+        glGenBuffers(1, &newVertexBufferID);
+        glGenBuffers(1, &newIndexBufferID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(MeshVertex) * vertexCapacity, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint) * indexCapacity, nullptr, GL_STATIC_DRAW);
+
+        _vertexAllocator.reset(vertexCapacity);
+        _indexAllocator.reset(indexCapacity);
+
+        // Pack meshes one after another on the GPU, indices are relative to base vertex so they stay valid
+        for (auto& mesh : _meshes)
+        {
+            auto& allocation = mesh.second;
+            GLuint newFirstVertex = 0, newFirstIndex = 0;
+            _vertexAllocator.allocate(allocation.numVertices, newFirstVertex);
+            _indexAllocator.allocate(allocation.numIndices, newFirstIndex);
+
+            glBindBuffer(GL_COPY_READ_BUFFER, _vertexBufferID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBufferID);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(MeshVertex) * allocation.firstVertex,
+                sizeof(MeshVertex) * newFirstVertex, sizeof(MeshVertex) * allocation.numVertices);
+
+            glBindBuffer(GL_COPY_READ_BUFFER, _indexBufferID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBufferID);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sizeof(GLuint) * allocation.firstIndex,
+                sizeof(GLuint) * newFirstIndex, sizeof(GLuint) * allocation.numIndices);
+
+            allocation.firstVertex = newFirstVertex;
+            allocation.firstIndex = newFirstIndex;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glDeleteBuffers(1, &_vertexBufferID);
+        glDeleteBuffers(1, &_indexBufferID);
+        _vertexBufferID = newVertexBufferID;
+        _indexBufferID = newIndexBufferID;
+
+        setVertexAttributesPointers();
+        _areCommandsDirty = true;
+    }
+
+    void GeometryArena::setVertexAttributesPointers()
+    {
+        GLStateCache::getInstance().bindVertexArray(_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferID);
+
+        glEnableVertexAttribArray(StaticMesh3D::POSITION_ATTRIBUTE_INDEX);
+        glVertexAttribPointer(StaticMesh3D::POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+            reinterpret_cast<void*>(offsetof(MeshVertex, position)));
+
+        glEnableVertexAttribArray(StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
+        glVertexAttribPointer(StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+            reinterpret_cast<void*>(offsetof(MeshVertex, textureCoordinate)));
+
+        glEnableVertexAttribArray(StaticMesh3D::NORMAL_ATTRIBUTE_INDEX);
+        glVertexAttribPointer(StaticMesh3D::NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+            reinterpret_cast<void*>(offsetof(MeshVertex, normal)));
+
+        // Element buffer binding is part of VAO state
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferID);
+        GLStateCache::getInstance().bindVertexArray(0);
+    }
+
+    void GeometryArena::uploadCommands()
+    {
+        std::vector<DrawElementsIndirectCommand> commands;
+        commands.reserve(_recordedCommands.size());
+        for (const auto& recordedCommand : _recordedCommands)
+        {
+            // Commands of removed meshes stay in place (drawing nothing), so that command ranges keep valid
+            commands.push_back(getDrawCommand(recordedCommand.meshHandle, recordedCommand.baseInstance, recordedCommand.instanceCount));
+        }
+
+        // Commands are uploaded up to three times per frame (occluders, prepass, main pass), so the ring covers
+        // three frames in flight and the buffer written is no longer read by the GPU. Storage is reallocated
+        // only when commands outgrow it, and it then grows to double the size of the commands
+        _indirectBufferIndex = (_indirectBufferIndex + 1) % NUM_INDIRECT_BUFFERS;
+        auto& capacity = _indirectBufferCapacities[_indirectBufferIndex];
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBufferIDs[_indirectBufferIndex]);
+        if (capacity < commands.size())
+        {
+            capacity = commands.size() * 2;
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * capacity, nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * commands.size(), commands.data());
+        _areCommandsDirty = false;
+    }
+
+    void GeometryArena::RangeAllocator::reset(GLuint capacity)
+    {
+        _freeRanges.clear();
+        _freeRanges[0] = capacity;
+        _capacity = capacity;
+        _numUsed = 0;
+    }
+
+    bool GeometryArena::RangeAllocator::allocate(GLuint size, GLuint& offset)
+    {
+        if (size == 0)
+        {
+            offset = 0;
+            return true;
+        }
+
+        for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it)
+        {
+            if (it->second < size) {
+                continue;
+            }
+
+            offset = it->first;
+            const auto remainingSize = it->second - size;
+            _freeRanges.erase(it);
+            if (remainingSize > 0) {
+                _freeRanges[offset + size] = remainingSize;
+            }
+
+            _numUsed += size;
+            return true;
+        }
+
+        return false;
+    }
+
+    void GeometryArena::RangeAllocator::free(GLuint offset, GLuint size)
+    {
+        if (size == 0) {
+            return;
+        }
+
+        _numUsed -= size;
+        auto it = _freeRanges.emplace(offset, size).first;
+
+        // Merge with following free range
+        const auto next = std::next(it);
+        if (next != _freeRanges.end() && it->first + it->second == next->first)
+        {
+            it->second += next->second;
+            _freeRanges.erase(next);
+        }
+
+        // Merge with preceding free range
+        if (it != _freeRanges.begin())
+        {
+            const auto previous = std::prev(it);
+            if (previous->first + previous->second == it->first)
+            {
+                previous->second += it->second;
+                _freeRanges.erase(it);
+            }
+        }
+    }
+
+    GLuint GeometryArena::RangeAllocator::getNumUsed() const
+    {
+        return _numUsed;
+    }
+
+    GLuint GeometryArena::RangeAllocator::getCapacity() const
+    {
+        return _capacity;
+    }
+
+} // namespace static_meshes_3D
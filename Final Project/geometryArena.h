@@ -0,0 +1,218 @@
+#pragma once
+
+// STL
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Project
+#include "instanceBuffer.h"
+#include "meshData.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * One vertex buffer and one index buffer shared by many static meshes. Every mesh is
+     * sub-allocated from the buffers as a triangle list, and draws are recorded as indirect
+     * commands, so the whole arena submits with a single VAO and glMultiDrawElementsIndirect.
+     * Per-draw transforms come from an instance buffer, indexed by command's base instance.
+     */
+    class GeometryArena
+    {
+    public:
+        static const int INVALID_MESH_HANDLE; // Handle never returned for a valid mesh (-1)
+
+        /**
+         * Layout of one indirect draw command, as expected by glMultiDrawElementsIndirect.
+         */
+        struct DrawElementsIndirectCommand
+        {
+            GLuint count; // Number of indices
+            GLuint instanceCount; // Number of instances
+            GLuint firstIndex; // First index in the index buffer
+            GLint baseVertex; // Value added to every index
+            GLuint baseInstance; // First instance (in instance buffer) of this draw
+        };
+
+        /**
+         * Creates arena with given initial capacities (buffers grow when needed).
+         *
+         * @param initialVertexCapacity  Number of vertices the arena can hold before growing
+         * @param initialIndexCapacity   Number of indices the arena can hold before growing
+         */
+        GeometryArena(GLuint initialVertexCapacity = 1 << 16, GLuint initialIndexCapacity = 1 << 18);
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+        ~GeometryArena();
+
+        /**
+         * Adds mesh given as indexed triangle list to the arena.
+         *
+         * @return Handle of the mesh in the arena, or INVALID_MESH_HANDLE if the buffers cannot grow to fit it.
+         */
+        int addMesh(const MeshData& meshData);
+
+        /**
+         * Adds mesh given as indexed triangle list to the arena, straight from given arrays (e.g. mapped file).
+         *
+         * @return Handle of the mesh in the arena, or INVALID_MESH_HANDLE if the buffers cannot grow to fit it.
+         */
+        int addMesh(const MeshVertex* vertices, GLuint numVertices, const GLuint* indices, GLuint numIndices);
+
+        /**
+         * Removes mesh from the arena, its space is returned to the free lists.
+         */
+        void removeMesh(int meshHandle);
+
+        /**
+         * Moves all meshes to the beginning of the buffers, so that all free space is in one range.
+         */
+        void compact();
+
+        /**
+         * Clears all recorded draw commands.
+         */
+        void clearCommands();
+
+        /**
+         * Records draw command of given mesh.
+         *
+         * @param meshHandle     Handle of the mesh to draw
+         * @param baseInstance   Index of the first instance in the instance buffer
+         * @param instanceCount  Number of instances to draw
+         */
+        void addCommand(int meshHandle, GLuint baseInstance, GLuint instanceCount = 1);
+
+        /**
+         * Gets number of recorded draw commands.
+         */
+        size_t getNumCommands() const;
+
+        /**
+         * Binds arena VAO, with instance attributes sourced from given instance buffer.
+         */
+        void bind(const InstanceBuffer& instanceBuffer);
+
+        /**
+         * Submits all recorded commands with one multi-draw call (arena must be bound).
+         */
+        void submitCommands();
+
+        /**
+         * Submits range of recorded commands with one multi-draw call (arena must be bound).
+         */
+        void submitCommands(size_t firstCommand, size_t numCommands);
+
+        /**
+         * Submits commands written to given indirect buffer (e.g. by compute shader) with one multi-draw
+         * call (arena must be bound). Commands are never read back to the CPU.
+         *
+         * @param indirectBufferID  Buffer with tightly packed DrawElementsIndirectCommand structures
+         * @param numCommands       Number of commands in the buffer
+         */
+        void submitIndirectBuffer(GLuint indirectBufferID, size_t numCommands);
+
+        /**
+         * Gets indirect command drawing given mesh where it lives now (empty command for invalid handle).
+         * Commands built this way must be rebuilt, when the arena compacts or grows.
+         */
+        DrawElementsIndirectCommand getDrawCommand(int meshHandle, GLuint baseInstance, GLuint instanceCount = 1) const;
+
+        /**
+         * Gets number of indices of given mesh (0 for invalid handle).
+         */
+        GLuint getNumIndices(int meshHandle) const;
+
+        /**
+         * Gets number of vertices used by meshes / vertex capacity of the arena.
+         */
+        GLuint getNumVerticesUsed() const;
+        GLuint getVertexCapacity() const;
+
+        /**
+         * Gets number of indices used by meshes / index capacity of the arena.
+         */
+        GLuint getNumIndicesUsed() const;
+        GLuint getIndexCapacity() const;
+
+        /**
+         * Gets OpenGL-assigned ID of the arena VAO.
+         */
+        GLuint getVertexArrayID() const;
+
+        /**
+         * Deletes all buffers and meshes of the arena.
+         */
+        void deleteArena();
+
+    private:
+        /**
+         * First-fit allocator of element ranges. Freed ranges are merged with their free neighbours.
+         */
+        class RangeAllocator
+        {
+        public:
+            void reset(GLuint capacity);
+            bool allocate(GLuint size, GLuint& offset);
+            void free(GLuint offset, GLuint size);
+            GLuint getNumUsed() const;
+            GLuint getCapacity() const;
+
+        private:
+            std::map<GLuint, GLuint> _freeRanges; // Sizes of free ranges by their offsets
+            GLuint _capacity = 0; // Total number of elements
+            GLuint _numUsed = 0; // Number of allocated elements
+        };
+
+        /**
+         * Where the mesh lives in the arena buffers.
+         */
+        struct MeshAllocation
+        {
+            GLuint firstVertex;
+            GLuint numVertices;
+            GLuint firstIndex;
+            GLuint numIndices;
+        };
+
+        /**
+         * Draw command as recorded, resolved to indirect command only at submission (meshes may move).
+         */
+        struct RecordedCommand
+        {
+            int meshHandle;
+            GLuint baseInstance;
+            GLuint instanceCount;
+        };
+
+        GLuint _initialVertexCapacity; // Vertex capacity of the arena when it gets created
+        GLuint _initialIndexCapacity; // Index capacity of the arena when it gets created
+
+        bool _isCreated = false; // Flag telling, if buffers have been created already
+        GLuint _vao = 0; // VAO ID from OpenGL
+        GLuint _vertexBufferID = 0; // Shared vertex buffer
+        GLuint _indexBufferID = 0; // Shared index buffer
+        static const int NUM_INDIRECT_BUFFERS; // Indirect buffers written in turn (9)
+
+        std::vector<GLuint> _indirectBufferIDs; // Ring of buffers with indirect draw commands, every upload writes the next one
+        std::vector<size_t> _indirectBufferCapacities; // Number of commands every buffer of the ring can hold
+        int _indirectBufferIndex = 0; // Buffer of the ring holding current commands
+        GLuint _instanceBufferID = 0; // ID of instance buffer, which is attached to the VAO
+
+        RangeAllocator _vertexAllocator; // Sub-allocator of vertex buffer
+        RangeAllocator _indexAllocator; // Sub-allocator of index buffer
+        std::unordered_map<int, MeshAllocation> _meshes; // All meshes by their handles
+        int _nextMeshHandle = 0; // Handle given to the next added mesh
+
+        std::vector<RecordedCommand> _recordedCommands; // Commands in order of recording
+        bool _areCommandsDirty = false; // Flag telling, if indirect buffer must be rebuilt
+
+        void createArena();
+        void relocate(GLuint vertexCapacity, GLuint indexCapacity);
+        void setVertexAttributesPointers();
+        void uploadCommands();
+
+        static bool getGrownCapacity(GLuint capacity, GLuint numUsed, GLuint numRequested, GLuint& grownCapacity);
+    };
+
+} // namespace static_meshes_3D
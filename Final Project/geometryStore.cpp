@@ -0,0 +1,128 @@
+// STL
+#include <cstring>
+
+// Project
+#include "geometryStore.h"
+
+namespace static_meshes_3D {
+
+    GeometryStore& GeometryStore::getInstance()
+    {
+        static GeometryStore instance;
+        return instance;
+    }
+
+    GLuint GeometryStore::acquire(GLenum bufferType, const void* ptrData, size_t dataSizeBytes, GLenum usageHint)
+    {
+        const auto hash = hashData(ptrData, dataSizeBytes);
+
+        // Look for buffer with the same contents, hash match is verified byte by byte
+        const auto range = _buffersByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            auto& entry = _entries[it->second];
+            if (entry.sizeBytes == dataSizeBytes && entry.bufferType == bufferType && hasSameData(entry, ptrData, dataSizeBytes))
+            {
+                entry.refCount++;
+                glBindBuffer(bufferType, it->second);
+                return it->second;
+            }
+        }
+
+        // Nothing found, upload new buffer
+        GLuint bufferID = 0;
+        glGenBuffers(1, &bufferID);
+        glBindBuffer(bufferType, bufferID);
+        glBufferData(bufferType, dataSizeBytes, ptrData, usageHint);
+
+        _buffersByHash.emplace(hash, bufferID);
+        const auto bytes = static_cast<const unsigned char*>(ptrData);
+        _entries[bufferID] = Entry{ hash, dataSizeBytes, bufferType, 1, std::vector<unsigned char>(bytes, bytes + dataSizeBytes) };
+        return bufferID;
+    }
+
+    void GeometryStore::release(GLuint bufferID)
+    {
+        const auto it = _entries.find(bufferID);
+        if (it == _entries.end()) {
+            return;
+        }
+
+        if (--it->second.refCount > 0) {
+            return;
+        }
+
+        const auto range = _buffersByHash.equal_range(it->second.hash);
+        for (auto hashIt = range.first; hashIt != range.second; ++hashIt)
+        {
+            if (hashIt->second == bufferID)
+            {
+                _buffersByHash.erase(hashIt);
+                break;
+            }
+        }
+
+        _entries.erase(it);
+        glDeleteBuffers(1, &bufferID);
+    }
+
+    const std::vector<unsigned char>* GeometryStore::getData(GLuint bufferID) const
+    {
+        const auto it = _entries.find(bufferID);
+        return it != _entries.end() ? &it->second.data : nullptr;
+    }
+
+    size_t GeometryStore::getNumBuffers() const
+    {
+        return _entries.size();
+    }
+
+    size_t GeometryStore::getBytesUploaded() const
+    {
+        size_t result = 0;
+        for (const auto& entry : _entries) {
+            result += entry.second.sizeBytes;
+        }
+
+        return result;
+    }
+
+    size_t GeometryStore::getBytesSaved() const
+    {
+        size_t result = 0;
+        for (const auto& entry : _entries) {
+            result += entry.second.sizeBytes * (entry.second.refCount - 1);
+        }
+
+        return result;
+    }
+
+    uint64_t GeometryStore::hashData(const void* ptrData, size_t dataSizeBytes)
+    {
+        // FNV-1a, consuming 8 bytes at a time (vertex data are always at least 4-byte aligned)
+        const auto FNV_PRIME = 1099511628211ULL;
+        auto hash = 14695981039346656037ULL ^ dataSizeBytes;
+
+        const auto bytes = static_cast<const unsigned char*>(ptrData);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= dataSizeBytes; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, bytes + i, sizeof(uint64_t));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+
+        for (; i < dataSizeBytes; i++) {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    bool GeometryStore::hasSameData(const Entry& entry, const void* ptrData, size_t dataSizeBytes)
+    {
+        // Compared with the copy in memory, reading the buffer back would stall the pipeline
+        return entry.data.size() == dataSizeBytes && memcmp(entry.data.data(), ptrData, dataSizeBytes) == 0;
+    }
+
+} // namespace static_meshes_3D
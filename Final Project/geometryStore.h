@@ -0,0 +1,89 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace static_meshes_3D {
+
+    /**
+     * Content-addressed store of GPU buffers. Buffer contents are hashed before upload and
+     * identical vertex / index streams share one reference counted buffer, so repeated
+     * geometry pays GPU memory and upload cost only once. Contents are kept in CPU memory too,
+     * so that hash matches are verified (and contents read) without reading buffers back.
+     */
+    class GeometryStore
+    {
+    public:
+        /**
+         * Gets the one and only geometry store instance.
+         */
+        static GeometryStore& getInstance();
+
+        GeometryStore(const GeometryStore&) = delete;
+        GeometryStore& operator=(const GeometryStore&) = delete;
+
+        /**
+         * Gets buffer holding given data. If the same data have been acquired before, the existing
+         * buffer is returned and its reference count is increased, otherwise new buffer gets uploaded.
+         * Returned buffer is left bound to given buffer type.
+         *
+         * @param bufferType     Type of the buffer (GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER...)
+         * @param ptrData        Pointer to the raw data
+         * @param dataSizeBytes  Size of the data (in bytes)
+         * @param usageHint      Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW...)
+         *
+         * @return OpenGL buffer ID holding the data.
+         */
+        GLuint acquire(GLenum bufferType, const void* ptrData, size_t dataSizeBytes, GLenum usageHint);
+
+        /**
+         * Releases one reference of the buffer, deleting it when no longer used.
+         */
+        void release(GLuint bufferID);
+
+        /**
+         * Gets contents of buffer held by the store (from CPU memory, no GPU readback).
+         *
+         * @return Contents of the buffer, or nullptr if the store doesn't hold it.
+         */
+        const std::vector<unsigned char>* getData(GLuint bufferID) const;
+
+        /**
+         * Gets number of unique buffers held by the store.
+         */
+        size_t getNumBuffers() const;
+
+        /**
+         * Gets number of bytes really uploaded to the GPU.
+         */
+        size_t getBytesUploaded() const;
+
+        /**
+         * Gets number of bytes that didn't have to be uploaded thanks to sharing.
+         */
+        size_t getBytesSaved() const;
+
+    private:
+        GeometryStore() = default;
+
+        struct Entry
+        {
+            uint64_t hash; // Hash of the buffer contents
+            size_t sizeBytes; // Size of the buffer contents
+            GLenum bufferType; // Type the buffer has been created as
+            int refCount; // How many VBOs share this buffer
+            std::vector<unsigned char> data; // Copy of the buffer contents
+        };
+
+        std::unordered_multimap<uint64_t, GLuint> _buffersByHash; // Buffer IDs by their content hash
+        std::unordered_map<GLuint, Entry> _entries; // Buffer information by buffer ID
+
+        static uint64_t hashData(const void* ptrData, size_t dataSizeBytes);
+        static bool hasSameData(const Entry& entry, const void* ptrData, size_t dataSizeBytes);
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,201 @@
+// Project
+#include "glStateCache.h"
+
+const GLuint GLStateCache::UNKNOWN_ID = 0xFFFFFFFF;
+
+GLStateCache& GLStateCache::getInstance()
+{
+    static GLStateCache instance;
+    return instance;
+}
+
+void GLStateCache::useProgram(GLuint programID)
+{
+    if (trackChange(_programID == programID)) {
+        return;
+    }
+
+    glUseProgram(programID);
+    _programID = programID;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+    if (trackChange(_vao == vao)) {
+        return;
+    }
+
+    glBindVertexArray(vao);
+    _vao = vao;
+}
+
+void GLStateCache::activeTexture(GLenum textureUnit)
+{
+    if (trackChange(_activeTextureUnit == textureUnit)) {
+        return;
+    }
+
+    glActiveTexture(textureUnit);
+    _activeTextureUnit = textureUnit;
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint textureID)
+{
+    // Binding goes to the active unit, which must be known to be cached
+    if (_activeTextureUnit == 0) {
+        activeTexture(GL_TEXTURE0);
+    }
+
+    const auto key = (static_cast<uint64_t>(_activeTextureUnit) << 32) | target;
+    const auto it = _textureBindings.find(key);
+    if (trackChange(it != _textureBindings.end() && it->second == textureID)) {
+        return;
+    }
+
+    glBindTexture(target, textureID);
+    _textureBindings[key] = textureID;
+}
+
+void GLStateCache::enable(GLenum capability)
+{
+    setCapability(capability, true);
+}
+
+void GLStateCache::disable(GLenum capability)
+{
+    setCapability(capability, false);
+}
+
+void GLStateCache::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    const auto isRedundant = _isClearColorKnown && _clearColor[0] == red && _clearColor[1] == green
+        && _clearColor[2] == blue && _clearColor[3] == alpha;
+    if (trackChange(isRedundant)) {
+        return;
+    }
+
+    glClearColor(red, green, blue, alpha);
+    _clearColor[0] = red;
+    _clearColor[1] = green;
+    _clearColor[2] = blue;
+    _clearColor[3] = alpha;
+    _isClearColorKnown = true;
+}
+
+void GLStateCache::depthFunc(GLenum function)
+{
+    if (trackChange(_depthFunc == function)) {
+        return;
+    }
+
+    glDepthFunc(function);
+    _depthFunc = function;
+}
+
+void GLStateCache::depthMask(GLboolean isWritten)
+{
+    if (trackChange(_isDepthMaskKnown && _depthMask == isWritten)) {
+        return;
+    }
+
+    glDepthMask(isWritten);
+    _depthMask = isWritten;
+    _isDepthMaskKnown = true;
+}
+
+void GLStateCache::colorMask(GLboolean isWritten)
+{
+    if (trackChange(_isColorMaskKnown && _colorMask == isWritten)) {
+        return;
+    }
+
+    glColorMask(isWritten, isWritten, isWritten, isWritten);
+    _colorMask = isWritten;
+    _isColorMaskKnown = true;
+}
+
+void GLStateCache::onProgramDeleted(GLuint programID)
+{
+    if (_programID == programID) {
+        _programID = UNKNOWN_ID;
+    }
+}
+
+void GLStateCache::onVertexArrayDeleted(GLuint vao)
+{
+    // Deleting bound VAO reverts the binding to zero
+    if (_vao == vao) {
+        _vao = 0;
+    }
+}
+
+void GLStateCache::onTextureDeleted(GLuint textureID)
+{
+    // Deleted texture gets unbound from all units
+    for (auto& binding : _textureBindings)
+    {
+        if (binding.second == textureID) {
+            binding.second = 0;
+        }
+    }
+}
+
+void GLStateCache::invalidate()
+{
+    _programID = UNKNOWN_ID;
+    _vao = UNKNOWN_ID;
+    _activeTextureUnit = 0;
+    _textureBindings.clear();
+    _capabilities.clear();
+    _isClearColorKnown = false;
+    _depthFunc = 0;
+    _isDepthMaskKnown = false;
+    _isColorMaskKnown = false;
+}
+
+void GLStateCache::beginFrame()
+{
+    _lastFrameIssuedChanges = _numIssuedChanges;
+    _lastFrameElidedChanges = _numElidedChanges;
+    _numIssuedChanges = 0;
+    _numElidedChanges = 0;
+}
+
+int GLStateCache::getNumIssuedChanges() const
+{
+    return _lastFrameIssuedChanges;
+}
+
+int GLStateCache::getNumElidedChanges() const
+{
+    return _lastFrameElidedChanges;
+}
+
+bool GLStateCache::trackChange(bool isRedundant)
+{
+    if (isRedundant) {
+        _numElidedChanges++;
+    }
+    else {
+        _numIssuedChanges++;
+    }
+
+    return isRedundant;
+}
+
+void GLStateCache::setCapability(GLenum capability, bool isEnabled)
+{
+    const auto it = _capabilities.find(capability);
+    if (trackChange(it != _capabilities.end() && it->second == isEnabled)) {
+        return;
+    }
+
+    if (isEnabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+
+    _capabilities[capability] = isEnabled;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+/**
+ * Thin layer over OpenGL state changes. It remembers current program, VAO, active texture unit,
+ * texture bindings, enabled capabilities and depth / color writes, and drops every change that would set the state
+ * to what it already is. Issued and elided changes are counted per frame.
+ *
+ * All program, VAO, texture and enable/disable calls must go through the cache, otherwise
+ * it gets out of sync with the real OpenGL state (call invalidate() after such calls).
+ */
+class GLStateCache
+{
+public:
+    /**
+     * Gets the one and only state cache instance.
+     */
+    static GLStateCache& getInstance();
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+    /**
+     * Makes given program current (glUseProgram).
+     */
+    void useProgram(GLuint programID);
+
+    /**
+     * Binds given vertex array object (glBindVertexArray).
+     */
+    void bindVertexArray(GLuint vao);
+
+    /**
+     * Selects active texture unit (glActiveTexture).
+     *
+     * @param textureUnit  Texture unit (GL_TEXTURE0, GL_TEXTURE1...)
+     */
+    void activeTexture(GLenum textureUnit);
+
+    /**
+     * Binds texture to given target of currently active texture unit (glBindTexture).
+     */
+    void bindTexture(GLenum target, GLuint textureID);
+
+    /**
+     * Enables / disables OpenGL capability (glEnable / glDisable).
+     */
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+
+    /**
+     * Sets color used to clear color buffer (glClearColor).
+     */
+    void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+    /**
+     * Sets comparison of depth test (glDepthFunc).
+     */
+    void depthFunc(GLenum function);
+
+    /**
+     * Enables / disables writing to depth buffer (glDepthMask).
+     */
+    void depthMask(GLboolean isWritten);
+
+    /**
+     * Enables / disables writing to all channels of color buffer (glColorMask).
+     */
+    void colorMask(GLboolean isWritten);
+
+    /**
+     * Forgets deleted objects, so that their IDs don't look bound when OpenGL reuses them.
+     */
+    void onProgramDeleted(GLuint programID);
+    void onVertexArrayDeleted(GLuint vao);
+    void onTextureDeleted(GLuint textureID);
+
+    /**
+     * Forgets all cached state, next change of every state is issued.
+     */
+    void invalidate();
+
+    /**
+     * Starts counting state changes of a new frame.
+     */
+    void beginFrame();
+
+    /**
+     * Gets number of state changes issued to OpenGL / elided by the cache during last finished frame.
+     */
+    int getNumIssuedChanges() const;
+    int getNumElidedChanges() const;
+
+private:
+    GLStateCache() = default;
+
+    static const GLuint UNKNOWN_ID; // ID meaning, that the bound object is not known (forces next bind)
+
+    GLuint _programID = UNKNOWN_ID; // Current program
+    GLuint _vao = UNKNOWN_ID; // Bound vertex array object
+    GLenum _activeTextureUnit = 0; // Active texture unit (0 = not known)
+    std::unordered_map<uint64_t, GLuint> _textureBindings; // Bound textures by texture unit and target
+    std::unordered_map<GLenum, bool> _capabilities; // Enabled flag by capability
+    bool _isClearColorKnown = false; // Flag telling, if clear color below is the current one
+    GLfloat _clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f }; // Current clear color
+    GLenum _depthFunc = 0; // Comparison of depth test (0 = not known)
+    bool _isDepthMaskKnown = false; // Flag telling, if depth mask below is the current one
+    GLboolean _depthMask = GL_TRUE; // Flag telling, if depth is written
+    bool _isColorMaskKnown = false; // Flag telling, if color mask below is the current one
+    GLboolean _colorMask = GL_TRUE; // Flag telling, if color is written
+
+    int _numIssuedChanges = 0; // Changes issued during current frame
+    int _numElidedChanges = 0; // Changes elided during current frame
+    int _lastFrameIssuedChanges = 0; // Changes issued during last finished frame
+    int _lastFrameElidedChanges = 0; // Changes elided during last finished frame
+
+    bool trackChange(bool isRedundant);
+    void setCapability(GLenum capability, bool isEnabled);
+};
@@ -0,0 +1,259 @@
+// STL
+#include <cstddef>
+#include <iostream>
+
+// Project
+#include "gpuCulling.h"
+
+namespace static_meshes_3D {
+
+    const GLuint GpuCulling::WORK_GROUP_SIZE = 64;
+    const int GpuCulling::NUM_STATISTICS_FRAMES = 3;
+
+    static_assert(sizeof(InstanceBuffer::InstanceData) == 26 * sizeof(float), "Compute shader writes instances as 26 floats");
+
+    GpuCulling::GpuCulling(GeometryArena& arena)
+        : _arena(arena) {}
+
+    GpuCulling::~GpuCulling()
+    {
+        deleteCulling();
+    }
+
+    void GpuCulling::setScene(const std::vector<LodChain>& lodChains, const std::vector<Object>& objects)
+    {
+        if (!_isCreated) {
+            createBuffers();
+        }
+
+        // Object of a chain can be drawn at any of its levels, so every level reserves instances for all of them
+        std::vector<GLuint> numChainObjects(lodChains.size(), 0);
+        for (const auto& object : objects) {
+            numChainObjects[object.lodChain]++;
+        }
+
+        std::vector<GpuLodChain> gpuLodChains;
+        std::vector<GeometryArena::DrawElementsIndirectCommand> commands;
+        GLuint numInstances = 0;
+        for (size_t i = 0; i < lodChains.size(); i++)
+        {
+            const auto& lodChain = lodChains[i];
+            gpuLodChains.push_back(GpuLodChain{ static_cast<GLuint>(commands.size()), static_cast<GLuint>(lodChain.getNumLevels()),
+                lodChain.getFullDetailScreenRadius(), 0.0f });
+            for (auto level = 0; level < lodChain.getNumLevels(); level++)
+            {
+                commands.push_back(_arena.getDrawCommand(lodChain.getMeshHandle(level), numInstances, 0));
+                numInstances += numChainObjects[i];
+            }
+        }
+
+        std::vector<GpuObject> gpuObjects;
+        gpuObjects.reserve(objects.size());
+        for (const auto& object : objects)
+        {
+            const auto& lodChain = lodChains[object.lodChain];
+            gpuObjects.push_back(GpuObject{ object.model, glm::vec4(lodChain.getBoundsMin(), lodChain.getBoundingSphereRadius()),
+                glm::vec4(lodChain.getBoundsMax(), 0.0f), static_cast<GLuint>(object.lodChain), object.materialLayer, { 0, 0 } });
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _objectBufferID);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuObject) * gpuObjects.size(), gpuObjects.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lodChainBufferID);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuLodChain) * gpuLodChains.size(), gpuLodChains.data(), GL_STATIC_DRAW);
+        const std::vector<GLuint> lodLevels(objects.size(), 0);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lodLevelBufferID);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * lodLevels.size(), lodLevels.data(), GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _commandTemplateBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GeometryArena::DrawElementsIndirectCommand) * commands.size(), commands.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _commandBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GeometryArena::DrawElementsIndirectCommand) * commands.size(), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        _instances.allocateInstances(static_cast<GLsizei>(numInstances));
+        _numObjects = objects.size();
+        _numCommands = commands.size();
+    }
+
+    void GpuCulling::setObjectTransform(int index, const glm::mat4& model)
+    {
+        if (!_isCreated || index < 0 || static_cast<size_t>(index) >= _numObjects) {
+            return;
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _objectBufferID);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuObject) * index + offsetof(GpuObject, model), sizeof(glm::mat4), &model);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void GpuCulling::cull(const Shader& cullShader, const Frustum& frustum, const LodView& view,
+        const glm::mat4& viewProjection, const DepthPyramid* occluderDepth)
+    {
+        if (!_isCreated || _numObjects == 0) {
+            return;
+        }
+
+        // Copy of counts written NUM_STATISTICS_FRAMES ago is read (if finished), before it gets reused
+        const auto isStatisticsCopyFree = readStatistics();
+
+        // Every frame starts with no instances in any command
+        const auto commandsSize = sizeof(GeometryArena::DrawElementsIndirectCommand) * _numCommands;
+        glBindBuffer(GL_COPY_READ_BUFFER, _commandTemplateBufferID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _commandBufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandsSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _statisticsBufferID);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // Binding points match the buffer blocks of the shader
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _objectBufferID);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _lodChainBufferID);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _commandBufferID);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _instances.getBufferID());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _lodLevelBufferID);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _statisticsBufferID);
+
+        cullShader.use();
+        glUniform4fv(cullShader.getUniformLocation("frustumPlanes"), 6, &frustum.planes[0][0]);
+        cullShader.setVec3("cameraPosition", view.cameraPosition);
+        cullShader.setFloat("pixelsPerUnit", view.pixelsPerUnit);
+        cullShader.setBool("isPerspective", view.isPerspective);
+        cullShader.setInt("numObjects", static_cast<int>(_numObjects));
+        cullShader.setBool("isOcclusionCulling", occluderDepth != nullptr);
+        if (occluderDepth != nullptr)
+        {
+            occluderDepth->bindPyramid();
+            cullShader.setMat4("viewProjection", viewProjection);
+            cullShader.setInt("depthPyramid", DepthPyramid::TEXTURE_UNIT);
+        }
+
+        const auto numWorkGroups = (static_cast<GLuint>(_numObjects) + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE;
+        glDispatchCompute(numWorkGroups, 1, 1);
+
+        // Commands are read by the indirect draw, instances as vertex attributes, levels by the next dispatch, counts by the copy
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        // Counts of this frame are not copied, while the copy is still waiting to be read (it's retried next frame)
+        if (isStatisticsCopyFree)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, _statisticsBufferID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _statisticsReadbackIDs[_statisticsFrame]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(Statistics));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            _statisticsFences[_statisticsFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            _statisticsFrame = (_statisticsFrame + 1) % NUM_STATISTICS_FRAMES;
+        }
+    }
+
+    void GpuCulling::draw()
+    {
+        if (!_isCreated || _numCommands == 0) {
+            return;
+        }
+
+        _arena.bind(_instances);
+        _arena.submitIndirectBuffer(_commandBufferID, _numCommands);
+    }
+
+    const GpuCulling::Statistics& GpuCulling::getStatistics() const
+    {
+        return _statistics;
+    }
+
+    size_t GpuCulling::getNumObjects() const
+    {
+        return _numObjects;
+    }
+
+    size_t GpuCulling::getNumCommands() const
+    {
+        return _numCommands;
+    }
+
+    void GpuCulling::deleteCulling()
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        glDeleteBuffers(1, &_objectBufferID);
+        glDeleteBuffers(1, &_lodChainBufferID);
+        glDeleteBuffers(1, &_commandTemplateBufferID);
+        glDeleteBuffers(1, &_commandBufferID);
+        glDeleteBuffers(1, &_lodLevelBufferID);
+        glDeleteBuffers(1, &_statisticsBufferID);
+        glDeleteBuffers(static_cast<GLsizei>(_statisticsReadbackIDs.size()), _statisticsReadbackIDs.data());
+        for (auto fence : _statisticsFences)
+        {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+            }
+        }
+        _statisticsReadbackIDs.clear();
+        _statisticsFences.clear();
+        _instances.deleteInstanceBuffer();
+        _numObjects = 0;
+        _numCommands = 0;
+        _isCreated = false;
+    }
+
+    void GpuCulling::createBuffers()
+    {
+        glGenBuffers(1, &_objectBufferID);
+        glGenBuffers(1, &_lodChainBufferID);
+        glGenBuffers(1, &_commandTemplateBufferID);
+        glGenBuffers(1, &_commandBufferID);
+        glGenBuffers(1, &_lodLevelBufferID);
+
+        glGenBuffers(1, &_statisticsBufferID);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _statisticsBufferID);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Statistics), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        _statisticsReadbackIDs.resize(NUM_STATISTICS_FRAMES);
+        _statisticsFences.assign(NUM_STATISTICS_FRAMES, nullptr);
+        glGenBuffers(NUM_STATISTICS_FRAMES, _statisticsReadbackIDs.data());
+        for (auto bufferID : _statisticsReadbackIDs)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+            glBufferData(GL_COPY_WRITE_BUFFER, sizeof(Statistics), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        _statisticsFrame = 0;
+        _statistics = Statistics{ 0, 0, 0 };
+        _isCreated = true;
+    }
+
+    bool GpuCulling::readStatistics()
+    {
+        auto& fence = _statisticsFences[_statisticsFrame];
+        if (fence == nullptr) {
+            return true;
+        }
+
+        // Copy not finished yet keeps its fence, counts stay those of an older frame
+        const auto waitResult = glClientWaitSync(fence, 0, 0);
+        if (waitResult == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+
+        if (waitResult == GL_WAIT_FAILED) {
+            std::cout << "Failed to wait for GPU culling statistics!" << std::endl;
+        }
+        else
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, _statisticsReadbackIDs[_statisticsFrame]);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(Statistics), &_statistics);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+        return true;
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,159 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "shader.h"
+#include "depthPyramid.h"
+#include "frustumCulling.h"
+#include "geometryArena.h"
+#include "instanceBuffer.h"
+#include "lodChain.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Frustum culling and level of detail selection of all scene objects in a compute shader. Objects
+     * stay in a shader storage buffer; every frame the shader tests them against the frustum and appends
+     * visible ones to the instance range of the indirect command of their level of detail. There is one
+     * command per mesh (level of every LOD chain), so all objects are drawn with one multi-draw call,
+     * and the CPU never waits for the culling results. Objects inside the frustum can be also tested
+     * against depth pyramid of occluders, and per-frame counts are read back a few frames late.
+     */
+    class GpuCulling
+    {
+    public:
+        static const GLuint WORK_GROUP_SIZE; // Objects processed by one work group (64, local_size_x of the shader)
+        static const int NUM_STATISTICS_FRAMES; // Frames of statistics in flight, before they're read back (3)
+
+        /**
+         * Objects counted by one cull, laid out as Statistics block of the shader.
+         */
+        struct Statistics
+        {
+            GLuint numDrawn; // Objects drawn
+            GLuint numOutsideFrustum; // Objects culled by the frustum
+            GLuint numOccluded; // Objects inside the frustum, hidden behind occluders
+        };
+
+        /**
+         * Object to cull and draw.
+         */
+        struct Object
+        {
+            glm::mat4 model; // Model matrix of the object
+            int lodChain; // Index of the LOD chain drawn by the object
+            int materialLayer; // Layer of material texture array
+        };
+
+        /**
+         * Creates culling of meshes of given geometry arena.
+         */
+        explicit GpuCulling(GeometryArena& arena);
+        GpuCulling(const GpuCulling&) = delete;
+        GpuCulling& operator=(const GpuCulling&) = delete;
+        ~GpuCulling();
+
+        /**
+         * Replaces all objects and builds indirect commands for all levels of given LOD chains. Must be
+         * called again, when meshes move in the arena (it compacts or grows).
+         *
+         * @param lodChains  LOD chains, whose meshes live in the arena
+         * @param objects    Objects referencing the LOD chains
+         */
+        void setScene(const std::vector<LodChain>& lodChains, const std::vector<Object>& objects);
+
+        /**
+         * Replaces model matrix of already set object (e.g. when it moves).
+         */
+        void setObjectTransform(int index, const glm::mat4& model);
+
+        /**
+         * Dispatches the culling compute shader, which writes commands and instances of visible objects.
+         *
+         * @param cullShader      Compute shader program (shaderfiles/cull_instances.cs)
+         * @param frustum         View frustum to cull against
+         * @param view            How the camera projects objects (for level of detail)
+         * @param viewProjection  Projection * view matrix, which the depth pyramid was drawn with
+         * @param occluderDepth   Depth pyramid of occluders of this frame (nullptr for no occlusion culling)
+         */
+        void cull(const Shader& cullShader, const Frustum& frustum, const LodView& view,
+            const glm::mat4& viewProjection, const DepthPyramid* occluderDepth = nullptr);
+
+        /**
+         * Draws visible objects written by the last cull with one multi-draw call. Program and material
+         * texture must be bound by the caller.
+         */
+        void draw();
+
+        /**
+         * Gets counts of the latest cull already finished by the GPU (usually a few frames old, as reading
+         * them back never waits for the GPU).
+         */
+        const Statistics& getStatistics() const;
+
+        /**
+         * Gets number of objects set.
+         */
+        size_t getNumObjects() const;
+
+        /**
+         * Gets number of indirect commands (meshes of all LOD levels).
+         */
+        size_t getNumCommands() const;
+
+        /**
+         * Deletes all buffers.
+         */
+        void deleteCulling();
+
+    private:
+        /**
+         * Object as stored in the shader storage buffer (std430 layout of CullObject).
+         */
+        struct GpuObject
+        {
+            glm::mat4 model; // Model matrix
+            glm::vec4 boundsMin; // Minimal corner of bounding box (in model space), radius of bounding sphere in w
+            glm::vec4 boundsMax; // Maximal corner of bounding box (in model space)
+            GLuint lodChain; // Index of the LOD chain
+            GLint materialLayer; // Layer of material texture array
+            GLuint padding[2];
+        };
+
+        /**
+         * LOD chain as stored in the shader storage buffer (std430 layout of CullLodChain).
+         */
+        struct GpuLodChain
+        {
+            GLuint firstCommand; // Command of level 0, other levels follow
+            GLuint numLevels; // Number of levels
+            float fullDetailScreenRadius; // Projected radius, from which level 0 is used
+            float padding;
+        };
+
+        GeometryArena& _arena; // Arena holding meshes of all objects
+        InstanceBuffer _instances; // Instances of visible objects, written by the compute shader
+        GLuint _objectBufferID = 0; // Objects to cull
+        GLuint _lodChainBufferID = 0; // LOD chains of objects
+        GLuint _commandTemplateBufferID = 0; // Commands with no instances, copied over commands every frame
+        GLuint _commandBufferID = 0; // Indirect commands, instance counts written by the compute shader
+        GLuint _lodLevelBufferID = 0; // Level of detail of every object drawn last frame (for hysteresis)
+        GLuint _statisticsBufferID = 0; // Counts of the current cull, written by the compute shader
+        std::vector<GLuint> _statisticsReadbackIDs; // Copies of counts of the last frames, read when GPU finishes them
+        std::vector<GLsync> _statisticsFences; // Fences signaled when copies of counts are written (nullptr for none)
+        int _statisticsFrame = 0; // Copy written by the current cull
+        Statistics _statistics = Statistics{ 0, 0, 0 }; // Latest counts read back
+        size_t _numObjects = 0; // Number of objects
+        size_t _numCommands = 0; // Number of indirect commands
+        bool _isCreated = false; // Flag telling, if buffers have been created already
+
+        void createBuffers();
+        bool readStatistics();
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,111 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "imageUtils.h"
+#include "stb_image.h"
+
+namespace image_utils {
+
+    std::vector<unsigned char> loadImage(const std::string& filepath, int width, int height)
+    {
+        int imageWidth, imageHeight, channels;
+        unsigned char* image = stbi_load(filepath.c_str(), &imageWidth, &imageHeight, &channels, NUM_CHANNELS);
+        if (!image) {
+            return std::vector<unsigned char>();
+        }
+
+        std::vector<unsigned char> pixels;
+        if (imageWidth == width && imageHeight == height) {
+            pixels.assign(image, image + imageWidth * imageHeight * NUM_CHANNELS);
+        }
+        else {
+            pixels = resampleImage(image, imageWidth, imageHeight, width, height);
+        }
+
+        stbi_image_free(image);
+        return pixels;
+    }
+
+    std::vector<unsigned char> resampleImage(const unsigned char* pixels, int width, int height, int newWidth, int newHeight)
+    {
+        // Bilinear filtering, sampling at texel centers
+        std::vector<unsigned char> result(newWidth * newHeight * NUM_CHANNELS);
+        const auto scaleX = static_cast<float>(width) / newWidth;
+        const auto scaleY = static_cast<float>(height) / newHeight;
+        for (auto y = 0; y < newHeight; y++)
+        {
+            const auto sourceY = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f);
+            const auto y0 = std::min(static_cast<int>(sourceY), height - 1);
+            const auto y1 = std::min(y0 + 1, height - 1);
+            const auto fractionY = sourceY - y0;
+
+            for (auto x = 0; x < newWidth; x++)
+            {
+                const auto sourceX = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f);
+                const auto x0 = std::min(static_cast<int>(sourceX), width - 1);
+                const auto x1 = std::min(x0 + 1, width - 1);
+                const auto fractionX = sourceX - x0;
+
+                for (auto c = 0; c < NUM_CHANNELS; c++)
+                {
+                    const auto top = pixels[(y0 * width + x0) * NUM_CHANNELS + c] * (1.0f - fractionX) + pixels[(y0 * width + x1) * NUM_CHANNELS + c] * fractionX;
+                    const auto bottom = pixels[(y1 * width + x0) * NUM_CHANNELS + c] * (1.0f - fractionX) + pixels[(y1 * width + x1) * NUM_CHANNELS + c] * fractionX;
+                    result[(y * newWidth + x) * NUM_CHANNELS + c] = static_cast<unsigned char>(top * (1.0f - fractionY) + bottom * fractionY + 0.5f);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<unsigned char> downsampleImage(const unsigned char* pixels, int width, int height)
+    {
+        const auto newWidth = std::max(1, width / 2);
+        const auto newHeight = std::max(1, height / 2);
+        std::vector<unsigned char> result(newWidth * newHeight * NUM_CHANNELS);
+        for (auto y = 0; y < newHeight; y++)
+        {
+            // Odd sizes and 1 texel wide images clamp the second sample to the edge
+            const auto y0 = std::min(y * 2, height - 1);
+            const auto y1 = std::min(y * 2 + 1, height - 1);
+            for (auto x = 0; x < newWidth; x++)
+            {
+                const auto x0 = std::min(x * 2, width - 1);
+                const auto x1 = std::min(x * 2 + 1, width - 1);
+                for (auto c = 0; c < NUM_CHANNELS; c++)
+                {
+                    const auto sum = pixels[(y0 * width + x0) * NUM_CHANNELS + c] + pixels[(y0 * width + x1) * NUM_CHANNELS + c]
+                        + pixels[(y1 * width + x0) * NUM_CHANNELS + c] + pixels[(y1 * width + x1) * NUM_CHANNELS + c];
+                    result[(y * newWidth + x) * NUM_CHANNELS + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void appendMipLevels(std::vector<unsigned char>& pixels, int width, int height)
+    {
+        auto levelOffset = size_t(0);
+        for (auto level = 1; level < getNumMipLevels(width, height); level++)
+        {
+            const auto mipLevel = downsampleImage(pixels.data() + levelOffset, width, height);
+            levelOffset += static_cast<size_t>(width) * height * NUM_CHANNELS;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            pixels.insert(pixels.end(), mipLevel.begin(), mipLevel.end());
+        }
+    }
+
+    int getNumMipLevels(int width, int height)
+    {
+        auto numMipLevels = 1;
+        for (auto size = std::max(width, height); size > 1; size /= 2) {
+            numMipLevels++;
+        }
+
+        return numMipLevels;
+    }
+
+} // namespace image_utils
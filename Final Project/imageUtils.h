@@ -0,0 +1,41 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+/**
+ * Helpers for RGBA8 images in CPU memory (4 bytes per texel, rows stored bottom to top as OpenGL expects).
+ */
+namespace image_utils {
+
+    static const int NUM_CHANNELS = 4; // All images are RGBA
+
+    /**
+     * Decodes image file to RGBA8 and resamples it to given size (vertically flipped for OpenGL).
+     *
+     * @return Pixels of given size, or empty vector on failure.
+     */
+    std::vector<unsigned char> loadImage(const std::string& filepath, int width, int height);
+
+    /**
+     * Resamples image to new size with bilinear filtering.
+     */
+    std::vector<unsigned char> resampleImage(const unsigned char* pixels, int width, int height, int newWidth, int newHeight);
+
+    /**
+     * Creates next mip level of the image - half its size (at least 1), with 2x2 box filter.
+     */
+    std::vector<unsigned char> downsampleImage(const unsigned char* pixels, int width, int height);
+
+    /**
+     * Appends all smaller mip levels after the image (level 0), one after another down to 1x1.
+     */
+    void appendMipLevels(std::vector<unsigned char>& pixels, int width, int height);
+
+    /**
+     * Gets number of mip levels of full mip chain of image of given size.
+     */
+    int getNumMipLevels(int width, int height);
+
+} // namespace image_utils
@@ -0,0 +1,108 @@
+// STL
+#include <cstddef>
+
+// Project
+#include "instanceBuffer.h"
+
+namespace static_meshes_3D {
+
+    const int InstanceBuffer::MODEL_MATRIX_ATTRIBUTE_INDEX  = 3;
+    const int InstanceBuffer::NORMAL_MATRIX_ATTRIBUTE_INDEX = 7;
+    const int InstanceBuffer::MATERIAL_LAYER_ATTRIBUTE_INDEX = 10;
+
+    InstanceBuffer::~InstanceBuffer()
+    {
+        deleteInstanceBuffer();
+    }
+
+    void InstanceBuffer::setInstances(const std::vector<glm::mat4>& modelMatrices, const std::vector<GLint>& materialLayers)
+    {
+        if (!_isCreated)
+        {
+            _vbo.createVBO();
+            _isCreated = true;
+        }
+
+        // Instances are written straight to the GPU buffer, with no staging copy
+        _vbo.bindVBO();
+        const auto instances = _vbo.mapVerticesForWriting<InstanceData>(static_cast<uint32_t>(modelMatrices.size()), GL_DYNAMIC_DRAW);
+        for (size_t i = 0; i < instances.size; i++)
+        {
+            auto& instance = instances[i];
+            instance.modelMatrix = modelMatrices[i];
+            instance.normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrices[i])));
+            instance.materialLayer = i < materialLayers.size() ? materialLayers[i] : 0;
+        }
+
+        if (instances.data != nullptr) {
+            _vbo.unmapBuffer();
+        }
+        _numInstances = static_cast<GLsizei>(instances.size);
+    }
+
+    void InstanceBuffer::allocateInstances(GLsizei numInstances)
+    {
+        if (!_isCreated)
+        {
+            _vbo.createVBO();
+            _isCreated = true;
+        }
+
+        // Mapping allocates the storage, nothing is written from the CPU side
+        _vbo.bindVBO();
+        const auto instances = _vbo.mapVerticesForWriting<InstanceData>(static_cast<uint32_t>(numInstances), GL_DYNAMIC_COPY);
+        if (instances.data != nullptr) {
+            _vbo.unmapBuffer();
+        }
+        _numInstances = numInstances;
+    }
+
+    void InstanceBuffer::setVertexAttributesPointers() const
+    {
+        _vbo.bindVBO();
+
+        // Matrices take one attribute location per column
+        for (auto i = 0; i < 4; i++)
+        {
+            const auto offset = sizeof(glm::vec4) * i;
+            glEnableVertexAttribArray(MODEL_MATRIX_ATTRIBUTE_INDEX + i);
+            glVertexAttribPointer(MODEL_MATRIX_ATTRIBUTE_INDEX + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(offset));
+            glVertexAttribDivisor(MODEL_MATRIX_ATTRIBUTE_INDEX + i, 1);
+        }
+
+        for (auto i = 0; i < 3; i++)
+        {
+            const auto offset = sizeof(glm::mat4) + sizeof(glm::vec3) * i;
+            glEnableVertexAttribArray(NORMAL_MATRIX_ATTRIBUTE_INDEX + i);
+            glVertexAttribPointer(NORMAL_MATRIX_ATTRIBUTE_INDEX + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void*>(offset));
+            glVertexAttribDivisor(NORMAL_MATRIX_ATTRIBUTE_INDEX + i, 1);
+        }
+
+        // Layer is an integer attribute, so it must not be converted to float
+        glEnableVertexAttribArray(MATERIAL_LAYER_ATTRIBUTE_INDEX);
+        glVertexAttribIPointer(MATERIAL_LAYER_ATTRIBUTE_INDEX, 1, GL_INT, sizeof(InstanceData), reinterpret_cast<void*>(offsetof(InstanceData, materialLayer)));
+        glVertexAttribDivisor(MATERIAL_LAYER_ATTRIBUTE_INDEX, 1);
+    }
+
+    GLsizei InstanceBuffer::getNumInstances() const
+    {
+        return _numInstances;
+    }
+
+    GLuint InstanceBuffer::getBufferID() const
+    {
+        return _vbo.getBufferID();
+    }
+
+    void InstanceBuffer::deleteInstanceBuffer()
+    {
+        if (!_isCreated) {
+            return;
+        }
+
+        _vbo.deleteVBO();
+        _numInstances = 0;
+        _isCreated = false;
+    }
+
+} // namespace static_meshes_3D
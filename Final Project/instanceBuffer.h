@@ -0,0 +1,80 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "common/vertextBufferObject.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Holds per-instance model and normal matrices for instanced rendering of static meshes.
+     * Matrices are sourced as vertex attributes with attribute divisor of 1.
+     */
+    class InstanceBuffer
+    {
+    public:
+        static const int MODEL_MATRIX_ATTRIBUTE_INDEX; // First vertex attribute index of model matrix (3, occupies 3-6)
+        static const int NORMAL_MATRIX_ATTRIBUTE_INDEX; // First vertex attribute index of normal matrix (7, occupies 7-9)
+        static const int MATERIAL_LAYER_ATTRIBUTE_INDEX; // Vertex attribute index of material layer (10)
+
+        /**
+         * Data of one instance, exactly as they are stored in the buffer.
+         */
+        struct InstanceData
+        {
+            glm::mat4 modelMatrix; // Model matrix of the instance
+            glm::mat3 normalMatrix; // Normal matrix (transposed inverse of upper 3x3 model matrix)
+            GLint materialLayer; // Layer of material texture array
+        };
+
+        InstanceBuffer() = default;
+        InstanceBuffer(const InstanceBuffer&) = delete;
+        InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+        ~InstanceBuffer();
+
+        /**
+         * Replaces all instances with given model matrices (normal matrices are calculated) and uploads them.
+         *
+         * @param modelMatrices   Model matrix of every instance
+         * @param materialLayers  Material layer of every instance (layer 0 for all, if empty)
+         */
+        void setInstances(const std::vector<glm::mat4>& modelMatrices, const std::vector<GLint>& materialLayers = std::vector<GLint>());
+
+        /**
+         * Resizes the buffer to given number of instances, whose data are left to be written on the GPU
+         * (e.g. by compute shader, binding the buffer as shader storage buffer).
+         */
+        void allocateInstances(GLsizei numInstances);
+
+        /**
+         * Sets instance attribute pointers on currently bound VAO.
+         */
+        void setVertexAttributesPointers() const;
+
+        /**
+         * Gets number of instances in the buffer.
+         */
+        GLsizei getNumInstances() const;
+
+        /**
+         * Gets OpenGL-assigned buffer ID.
+         */
+        GLuint getBufferID() const;
+
+        /**
+         * Deletes instance buffer.
+         */
+        void deleteInstanceBuffer();
+
+    private:
+        mutable VertexBufferObject _vbo; // Our VBO wrapper class holding instance data
+        GLsizei _numInstances = 0; // Number of instances uploaded
+        bool _isCreated = false; // Flag telling, if buffer has been created already
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,170 @@
+// STL
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Project
+#include "layoutBenchmark.h"
+#include "frameUniformBuffer.h"
+#include "glStateCache.h"
+#include "shader.h"
+#include "sphere.h"
+#include "torus.h"
+#include "vertexKernels.h"
+
+using namespace static_meshes_3D;
+
+namespace layout_benchmark {
+
+    namespace {
+
+        const int NUM_SEGMENTS = 1024; // Slices and stacks of benchmarked meshes
+        const int NUM_DRAWS = 100; // Number of timed draws of every mesh
+
+        /**
+         * Results of one mesh in one layout.
+         */
+        struct Measurement
+        {
+            double generationMilliseconds; // CPU time of generating and uploading the mesh
+            double drawMilliseconds; // Average GPU time of one draw
+            uint32_t vertexBufferByteSize; // Size of the vertex buffer
+        };
+
+        /**
+         * Vertex layout and format of benchmarked meshes.
+         */
+        struct Configuration
+        {
+            const char* name;
+            VertexLayout vertexLayout;
+            VertexFormat vertexFormat;
+        };
+
+        Measurement measure(const Configuration& configuration, const Shader& shader, const std::function<StaticMesh3D*()>& createMesh)
+        {
+            StaticMesh3D::setDefaultVertexLayout(configuration.vertexLayout);
+            StaticMesh3D::setDefaultVertexFormat(configuration.vertexFormat);
+
+            // Upload is finished by glFinish, so that it's included in generation time
+            const auto generationStart = std::chrono::steady_clock::now();
+            std::unique_ptr<StaticMesh3D> mesh(createMesh());
+            glFinish();
+            const auto generationTime = std::chrono::steady_clock::now() - generationStart;
+
+            // Depth buffer is cleared only once, so that repeated draws are dominated by vertex work
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            shader.use();
+            shader.setMat4("model", glm::mat4(1.0f));
+            shader.setVec3("positionScale", mesh->getPositionScale());
+            shader.setVec3("positionBias", mesh->getPositionBias());
+            shader.setBool("octahedralNormals", mesh->getVertexFormat() == VertexFormat::Compressed);
+            mesh->render();
+
+            GLuint query;
+            glGenQueries(1, &query);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            for (auto i = 0; i < NUM_DRAWS; i++) {
+                mesh->render();
+            }
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 elapsedNanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNanoseconds);
+            glDeleteQueries(1, &query);
+
+            Measurement measurement;
+            measurement.generationMilliseconds = std::chrono::duration<double, std::milli>(generationTime).count();
+            measurement.drawMilliseconds = elapsedNanoseconds / 1e6 / NUM_DRAWS;
+            measurement.vertexBufferByteSize = mesh->getVertexBufferByteSize();
+            mesh->deleteMesh();
+            return measurement;
+        }
+
+    } // unnamed namespace
+
+    int run()
+    {
+        Shader shader("shaderfiles/object.vs", "shaderfiles/object.fs");
+        FrameUniformBuffer frameUniforms;
+        frameUniforms.createBuffer();
+        shader.bindUniformBlock(FrameUniformBuffer::BLOCK_NAME, FrameUniformBuffer::BINDING_POINT);
+
+        // Meshes fill most of the view
+        FrameUniformData frameData;
+        frameData.view = glm::lookAt(glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        frameData.projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+        frameData.objectColor = glm::vec3(1.0f);
+        frameData.lightColor = glm::vec3(1.0f);
+        frameData.lightPos = glm::vec3(0.0f, 0.0f, 4.0f);
+        frameData.viewPosition = glm::vec3(0.0f, 0.0f, 4.0f);
+        frameUniforms.update(frameData);
+        GLStateCache::getInstance().enable(GL_DEPTH_TEST);
+
+        struct BenchmarkedMesh
+        {
+            const char* name;
+            std::function<StaticMesh3D*()> create;
+        };
+
+        const BenchmarkedMesh meshes[] =
+        {
+            { "Sphere", []() -> StaticMesh3D* { return new Sphere(1.0f, NUM_SEGMENTS, NUM_SEGMENTS); } },
+            { "Torus", []() -> StaticMesh3D* { return new Torus(NUM_SEGMENTS, NUM_SEGMENTS, 1.0f, 0.4f); } }
+        };
+
+        const Configuration configurations[] =
+        {
+            { "planar", VertexLayout::Planar, VertexFormat::Float },
+            { "interleaved", VertexLayout::Interleaved, VertexFormat::Float },
+            { "compressed", VertexLayout::Interleaved, VertexFormat::Compressed }
+        };
+
+        const auto originalVertexLayout = StaticMesh3D::getDefaultVertexLayout();
+        const auto originalVertexFormat = StaticMesh3D::getDefaultVertexFormat();
+        std::cout << NUM_SEGMENTS << "x" << NUM_SEGMENTS << " segments, " << NUM_DRAWS << " draws per mesh" << std::endl;
+        std::cout << std::left << std::setw(10) << "Mesh" << std::setw(14) << "Vertices"
+            << std::setw(18) << "Generation [ms]" << std::setw(14) << "Draw [ms]" << "VBO [MB]" << std::endl;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& configuration : configurations)
+            {
+                const auto measurement = measure(configuration, shader, mesh.create);
+                std::cout << std::left << std::setw(10) << mesh.name << std::setw(14) << configuration.name
+                    << std::fixed << std::setprecision(3) << std::setw(18) << measurement.generationMilliseconds
+                    << std::setw(14) << measurement.drawMilliseconds << measurement.vertexBufferByteSize / (1024.0 * 1024.0) << std::endl;
+            }
+        }
+
+        // Generation kernels are compared on the interleaved float layout, from scalar up to the best supported
+        const auto originalInstructionSet = vertex_kernels::getInstructionSet();
+        const auto supportedInstructionSet = static_cast<int>(vertex_kernels::getSupportedInstructionSet());
+        std::cout << std::endl << std::left << std::setw(10) << "Mesh" << std::setw(14) << "Kernels" << "Generation [ms]" << std::endl;
+        for (const auto& mesh : meshes)
+        {
+            for (auto instructionSet = 0; instructionSet <= supportedInstructionSet; instructionSet++)
+            {
+                vertex_kernels::setInstructionSet(static_cast<vertex_kernels::InstructionSet>(instructionSet));
+                const auto measurement = measure(configurations[1], shader, mesh.create);
+                std::cout << std::left << std::setw(10) << mesh.name << std::setw(14) << vertex_kernels::getInstructionSetName(vertex_kernels::getInstructionSet())
+                    << std::fixed << std::setprecision(3) << measurement.generationMilliseconds << std::endl;
+            }
+        }
+
+        vertex_kernels::setInstructionSet(originalInstructionSet);
+        StaticMesh3D::setDefaultVertexLayout(originalVertexLayout);
+        StaticMesh3D::setDefaultVertexFormat(originalVertexFormat);
+        frameUniforms.deleteBuffer();
+        glDeleteProgram(shader.ID);
+        GLStateCache::getInstance().onProgramDeleted(shader.ID);
+        return EXIT_SUCCESS;
+    }
+
+} // namespace layout_benchmark
@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Benchmark comparing vertex layouts and formats of static meshes (see VertexLayout and VertexFormat).
+ * High-tessellation meshes are generated in every configuration, measuring CPU time of generation
+ * and upload, size of vertex buffer and GPU time of drawing them (with timer queries). Generation
+ * is then timed once more with every supported instruction set of vertex kernels.
+ */
+namespace layout_benchmark {
+
+    /**
+     * Command line option, which runs the benchmark instead of the application.
+     */
+    static const char BENCHMARK_OPTION[] = "--benchmark-layouts";
+
+    /**
+     * Runs the benchmark and prints results (OpenGL context must be current).
+     *
+     * @return Process exit code.
+     */
+    int run();
+
+} // namespace layout_benchmark
@@ -0,0 +1,136 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// GLM
+#include <glm/gtc/constants.hpp>
+
+// Project
+#include "lodChain.h"
+
+namespace static_meshes_3D {
+
+    const int LodChain::DEFAULT_NUM_LEVELS = 4;
+    const int LodChain::MIN_LEVEL_SEGMENTS = 4;
+    const float LodChain::DEFAULT_EDGE_LENGTH_PIXELS = 8.0f;
+    const float LodChain::HYSTERESIS = 0.25f;
+
+    LodView LodView::perspective(const glm::vec3& cameraPosition, float verticalFov, float viewportHeight)
+    {
+        return LodView{ cameraPosition, viewportHeight / (2.0f * std::tan(verticalFov / 2.0f)), true };
+    }
+
+    LodView LodView::orthographic(float halfHeight, float viewportHeight)
+    {
+        return LodView{ glm::vec3(0.0f), viewportHeight / (2.0f * halfHeight), false };
+    }
+
+    LodChain::LodChain(float fullDetailScreenRadius)
+        : _fullDetailScreenRadius(fullDetailScreenRadius) {}
+
+    void LodChain::addLevel(int meshHandle, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius)
+    {
+        if (_meshHandles.empty())
+        {
+            _boundsMin = boundsMin;
+            _boundsMax = boundsMax;
+        }
+        else
+        {
+            _boundsMin = glm::min(_boundsMin, boundsMin);
+            _boundsMax = glm::max(_boundsMax, boundsMax);
+        }
+
+        _meshHandles.push_back(meshHandle);
+
+        // Box center moves as levels are added, so the chain sphere is rebuilt from sphere of every level
+        const auto levelCenter = (boundsMin + boundsMax) * 0.5f;
+        _levelSpheres.push_back(glm::vec4(levelCenter, radius >= 0.0f ? radius : glm::length(boundsMax - boundsMin) * 0.5f));
+        const auto center = (_boundsMin + _boundsMax) * 0.5f;
+        _boundingSphereRadius = 0.0f;
+        for (const auto& levelSphere : _levelSpheres) {
+            _boundingSphereRadius = std::max(_boundingSphereRadius, glm::length(glm::vec3(levelSphere) - center) + levelSphere.w);
+        }
+    }
+
+    int LodChain::getNumLevels() const
+    {
+        return static_cast<int>(_meshHandles.size());
+    }
+
+    int LodChain::getMeshHandle(int level) const
+    {
+        return _meshHandles[level];
+    }
+
+    const glm::vec3& LodChain::getBoundsMin() const
+    {
+        return _boundsMin;
+    }
+
+    const glm::vec3& LodChain::getBoundsMax() const
+    {
+        return _boundsMax;
+    }
+
+    float LodChain::getBoundingSphereRadius() const
+    {
+        return _boundingSphereRadius;
+    }
+
+    float LodChain::getFullDetailScreenRadius() const
+    {
+        return _fullDetailScreenRadius;
+    }
+
+    float LodChain::getScreenRadius(const LodView& view, const glm::mat4& model) const
+    {
+        // Bounding sphere, scaled by the longest axis of the model matrix
+        const auto center = glm::vec3(model * glm::vec4((_boundsMin + _boundsMax) * 0.5f, 1.0f));
+        const auto maxScale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        const auto radius = _boundingSphereRadius * maxScale;
+        if (!view.isPerspective) {
+            return radius * view.pixelsPerUnit;
+        }
+
+        // Camera inside the sphere sees the object as large as it gets
+        const auto distance = glm::length(center - view.cameraPosition);
+        if (distance <= radius) {
+            return std::numeric_limits<float>::max();
+        }
+
+        return radius * view.pixelsPerUnit / distance;
+    }
+
+    int LodChain::selectLevel(const LodView& view, const glm::mat4& model, int currentLevel) const
+    {
+        const auto maxLevel = getNumLevels() - 1;
+        if (maxLevel <= 0) {
+            return 0;
+        }
+
+        // Continuous level - every halving of the projected radius adds one
+        const auto screenRadius = getScreenRadius(view, model);
+        const auto level = screenRadius > 0.0f ? std::log2(_fullDetailScreenRadius / screenRadius) : static_cast<float>(maxLevel);
+
+        // Current level is kept, until continuous level leaves it by more than hysteresis
+        currentLevel = glm::clamp(currentLevel, 0, maxLevel);
+        if (level >= currentLevel - HYSTERESIS && level < currentLevel + 1.0f + HYSTERESIS) {
+            return currentLevel;
+        }
+
+        return glm::clamp(static_cast<int>(std::floor(level)), 0, maxLevel);
+    }
+
+    int LodChain::getLevelSegments(int numSegments, int level)
+    {
+        return std::max(MIN_LEVEL_SEGMENTS, numSegments >> level);
+    }
+
+    float LodChain::getScreenRadiusForSegments(int numSegments, float edgeLengthPixels)
+    {
+        return numSegments * edgeLengthPixels / (2.0f * glm::pi<float>());
+    }
+
+} // namespace static_meshes_3D
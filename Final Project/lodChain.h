@@ -0,0 +1,130 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+namespace static_meshes_3D {
+
+    /**
+     * How the camera projects objects to the screen, as needed to select level of detail.
+     */
+    struct LodView
+    {
+        glm::vec3 cameraPosition; // Position of the camera in world space
+        float pixelsPerUnit; // Screen pixels per world unit (at distance 1 for perspective projection)
+        bool isPerspective; // Flag telling, if projected size depends on distance
+
+        /**
+         * Creates view of perspective camera.
+         *
+         * @param cameraPosition  Position of the camera in world space
+         * @param verticalFov     Vertical field of view (in radians)
+         * @param viewportHeight  Height of the viewport (in pixels)
+         */
+        static LodView perspective(const glm::vec3& cameraPosition, float verticalFov, float viewportHeight);
+
+        /**
+         * Creates view of orthographic camera.
+         *
+         * @param halfHeight      Half of the vertical extent of the view volume (in world units)
+         * @param viewportHeight  Height of the viewport (in pixels)
+         */
+        static LodView orthographic(float halfHeight, float viewportHeight);
+    };
+
+    /**
+     * Levels of detail of one mesh, every level being a mesh in the same geometry arena. Each next
+     * level halves the segments of the previous one, so it's selected when the projected radius of
+     * the object halves. Selection has hysteresis, so objects near the threshold don't pop back and forth.
+     */
+    class LodChain
+    {
+    public:
+        static const int DEFAULT_NUM_LEVELS; // Levels generated for parametric meshes (4)
+        static const int MIN_LEVEL_SEGMENTS; // Segments of a level never go below this (4)
+        static const float DEFAULT_EDGE_LENGTH_PIXELS; // Screen length of mesh edges, at which level 0 ends (8)
+        static const float HYSTERESIS; // Fraction of a level the radius must cross beyond threshold to switch (0.25)
+
+        /**
+         * Creates empty chain.
+         *
+         * @param fullDetailScreenRadius  Projected radius (in pixels), from which level 0 is used
+         */
+        explicit LodChain(float fullDetailScreenRadius = 0.0f);
+
+        /**
+         * Appends next (coarser) level.
+         *
+         * @param meshHandle  Handle of the level mesh in the geometry arena
+         * @param boundsMin   Minimal corner of bounding box of the mesh (in model space)
+         * @param boundsMax   Maximal corner of bounding box of the mesh (in model space)
+         * @param radius      Radius of bounding sphere around center of the box (negative for sphere around the box)
+         */
+        void addLevel(int meshHandle, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius = -1.0f);
+
+        /**
+         * Gets number of levels in the chain.
+         */
+        int getNumLevels() const;
+
+        /**
+         * Gets handle of the mesh of given level in the geometry arena.
+         */
+        int getMeshHandle(int level) const;
+
+        /**
+         * Gets minimal / maximal corner of bounding box of all levels (in model space).
+         */
+        const glm::vec3& getBoundsMin() const;
+        const glm::vec3& getBoundsMax() const;
+
+        /**
+         * Gets radius of bounding sphere of all levels, centered in the bounding box (in model space).
+         */
+        float getBoundingSphereRadius() const;
+
+        /**
+         * Gets projected radius (in pixels), from which level 0 is used.
+         */
+        float getFullDetailScreenRadius() const;
+
+        /**
+         * Gets projected radius (in pixels) of the chain bounding sphere transformed by model matrix.
+         */
+        float getScreenRadius(const LodView& view, const glm::mat4& model) const;
+
+        /**
+         * Selects level of detail for object with given model matrix.
+         *
+         * @param view          How the camera projects the object
+         * @param model         Model matrix of the object
+         * @param currentLevel  Level used by the object so far (for hysteresis)
+         *
+         * @return Level to use.
+         */
+        int selectLevel(const LodView& view, const glm::mat4& model, int currentLevel) const;
+
+        /**
+         * Gets number of segments of given level, when level 0 has given number of segments.
+         */
+        static int getLevelSegments(int numSegments, int level);
+
+        /**
+         * Gets projected radius (in pixels), at which edges of round mesh with given number of segments
+         * around have given screen length. Suitable as full detail radius of the chain.
+         */
+        static float getScreenRadiusForSegments(int numSegments, float edgeLengthPixels = DEFAULT_EDGE_LENGTH_PIXELS);
+
+    private:
+        std::vector<int> _meshHandles; // Mesh handles of all levels, from the finest one
+        float _fullDetailScreenRadius; // Projected radius, from which level 0 is used
+        glm::vec3 _boundsMin = glm::vec3(0.0f); // Minimal corner of bounding box of all levels
+        glm::vec3 _boundsMax = glm::vec3(0.0f); // Maximal corner of bounding box of all levels
+        std::vector<glm::vec4> _levelSpheres; // Bounding sphere (center, radius) of every level
+        float _boundingSphereRadius = 0.0f; // Radius of sphere around center of the box, enclosing all level spheres
+    };
+
+} // namespace static_meshes_3D
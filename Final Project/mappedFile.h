@@ -0,0 +1,53 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file. Data are paged in by the OS on first access,
+ * so nothing is copied until it's actually read.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /**
+     * Maps file to memory (previously mapped file is closed).
+     *
+     * @return True, if file has been mapped successfully.
+     */
+    bool open(const std::string& filepath);
+
+    /**
+     * Gets mapped data (nullptr, if no file is mapped).
+     */
+    const unsigned char* getData() const;
+
+    /**
+     * Gets size of mapped file in bytes.
+     */
+    size_t getSize() const;
+
+    /**
+     * Checks, if a file is mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * Unmaps file.
+     */
+    void close();
+
+private:
+    const unsigned char* _data = nullptr; // Start of the mapping
+    size_t _size = 0; // Size of the file in bytes
+#ifdef _WIN32
+    void* _fileHandle = nullptr; // Handle of opened file
+    void* _mappingHandle = nullptr; // Handle of file mapping object
+#endif
+};
@@ -0,0 +1,335 @@
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Project
+#include "materialLibrary.h"
+#include "glStateCache.h"
+#include "imageUtils.h"
+#include "stb_image.h"
+
+namespace static_meshes_3D {
+
+    const int MaterialLibrary::INVALID_MATERIAL = -1;
+    const int MaterialLibrary::NUM_CHANNELS = 4;
+    const int MaterialLibrary::NUM_UPLOAD_SLOTS = 2;
+    const unsigned char MaterialLibrary::PLACEHOLDER_COLOR[4] = { 128, 128, 128, 255 };
+
+    MaterialLibrary::MaterialLibrary(ThreadPool& threadPool, GLsizei layerWidth, GLsizei layerHeight)
+        : _threadPool(threadPool)
+        , _layerWidth(layerWidth)
+        , _layerHeight(layerHeight) {}
+
+    MaterialLibrary::~MaterialLibrary()
+    {
+        deleteLibrary();
+    }
+
+    int MaterialLibrary::addMaterial(const std::string& filepath)
+    {
+        // Baked texture is used only if it has exactly the layout of the array
+        std::unique_ptr<BakedTexture> bakedTexture(new BakedTexture);
+        if (bakedTexture->open(BakedTexture::getBakedPath(filepath))
+            && bakedTexture->getWidth() == _layerWidth && bakedTexture->getHeight() == _layerHeight
+            && bakedTexture->getNumMipLevels() == image_utils::getNumMipLevels(_layerWidth, _layerHeight))
+        {
+            _bakedMaterials.push_back(BakedMaterial{ _numMaterials, filepath, std::move(bakedTexture) });
+            return _numMaterials++;
+        }
+
+        // Fail early on missing files, decoding errors are reported when decoding finishes
+        if (!std::ifstream(filepath, std::ios::binary))
+        {
+            std::cout << "Failed to load texture " << filepath << std::endl;
+            return INVALID_MATERIAL;
+        }
+
+        startDecoding(_numMaterials, filepath);
+        return _numMaterials++;
+    }
+
+    bool MaterialLibrary::createTextureArray()
+    {
+        if (_textureID != 0 || _numMaterials == 0) {
+            return false;
+        }
+
+        if (canUseBakedMaterials())
+        {
+            createCompressedTextureArray();
+            return true;
+        }
+
+        // Uncompressed array can't take baked data, so baked materials are decoded as well
+        for (auto& bakedMaterial : _bakedMaterials) {
+            startDecoding(bakedMaterial.layer, bakedMaterial.filepath);
+        }
+        _bakedMaterials.clear();
+
+        const auto numMipLevels = image_utils::getNumMipLevels(_layerWidth, _layerHeight);
+
+        glGenTextures(1, &_textureID);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, _textureID);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, numMipLevels, GL_RGBA8, _layerWidth, _layerHeight, _numMaterials);
+
+        // Every layer shows placeholder until its image is decoded
+        for (auto level = 0; level < numMipLevels; level++) {
+            glClearTexImage(_textureID, level, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_COLOR);
+        }
+
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Upload slots stay mapped for the whole loading, writes are coherent without flushing
+        const auto pixelBufferSize = getLayerSizeBytes() * NUM_UPLOAD_SLOTS;
+        const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &_pixelBufferID);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBufferID);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, pixelBufferSize, nullptr, mapFlags);
+        _pixelBufferData = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pixelBufferSize, mapFlags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _slotFences.assign(NUM_UPLOAD_SLOTS, nullptr);
+        _nextSlot = 0;
+
+        // Some images may be decoded already
+        update();
+        return true;
+    }
+
+    bool MaterialLibrary::update()
+    {
+        if (_textureID == 0) {
+            return false;
+        }
+
+        // Upload at most one layer per slot, so that the frame never waits for its own uploads
+        auto numUploaded = 0;
+        for (auto it = _pendingMaterials.begin(); it != _pendingMaterials.end() && numUploaded < NUM_UPLOAD_SLOTS;)
+        {
+            if (it->pixels.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+
+            // Slot still read by the GPU is retried next update
+            if (!isSlotFree(_nextSlot)) {
+                break;
+            }
+
+            const auto pixels = it->pixels.get();
+            if (pixels.empty()) {
+                std::cout << "Failed to decode texture " << it->filepath << std::endl;
+            }
+            else
+            {
+                uploadLayer(it->layer, pixels);
+                numUploaded++;
+            }
+
+            it = _pendingMaterials.erase(it);
+        }
+
+        // Upload slots are not needed anymore, when everything is loaded
+        if (_pendingMaterials.empty()) {
+            deletePixelBuffer();
+        }
+
+        return _pendingMaterials.empty();
+    }
+
+    void MaterialLibrary::bind(GLenum textureUnit) const
+    {
+        auto& stateCache = GLStateCache::getInstance();
+        stateCache.activeTexture(textureUnit);
+        stateCache.bindTexture(GL_TEXTURE_2D_ARRAY, _textureID);
+    }
+
+    GLuint MaterialLibrary::getTextureID() const
+    {
+        return _textureID;
+    }
+
+    int MaterialLibrary::getNumMaterials() const
+    {
+        return _numMaterials;
+    }
+
+    void MaterialLibrary::deleteLibrary()
+    {
+        // Wait for running decodes, their results are dropped
+        for (auto& pendingMaterial : _pendingMaterials)
+        {
+            if (pendingMaterial.pixels.valid()) {
+                pendingMaterial.pixels.wait();
+            }
+        }
+        _pendingMaterials.clear();
+        _bakedMaterials.clear();
+
+        deletePixelBuffer();
+        if (_textureID != 0)
+        {
+            glDeleteTextures(1, &_textureID);
+            GLStateCache::getInstance().onTextureDeleted(_textureID);
+            _textureID = 0;
+        }
+
+        _numMaterials = 0;
+    }
+
+    void MaterialLibrary::startDecoding(int layer, const std::string& filepath)
+    {
+        // Flip flag is global in stb, so it's set here and only read by workers
+        stbi_set_flip_vertically_on_load(true);
+
+        const auto layerWidth = _layerWidth;
+        const auto layerHeight = _layerHeight;
+        auto pixels = _threadPool.enqueue([filepath, layerWidth, layerHeight]() {
+            // Mip levels are filtered by the worker too, so that only the decoded layer is uploaded
+            auto layerPixels = image_utils::loadImage(filepath, layerWidth, layerHeight);
+            if (!layerPixels.empty()) {
+                image_utils::appendMipLevels(layerPixels, layerWidth, layerHeight);
+            }
+            return layerPixels;
+        });
+
+        _pendingMaterials.push_back(PendingMaterial{ layer, filepath, std::move(pixels) });
+    }
+
+    bool MaterialLibrary::canUseBakedMaterials() const
+    {
+        if (!_pendingMaterials.empty() || _bakedMaterials.empty()) {
+            return false;
+        }
+
+        // All layers of the array share one internal format
+        const auto format = _bakedMaterials.front().texture->getFormat();
+        for (const auto& bakedMaterial : _bakedMaterials)
+        {
+            if (bakedMaterial.texture->getFormat() != format) {
+                return false;
+            }
+        }
+
+        // BPTC is core since OpenGL 4.2, S3TC is still an extension
+        return format == block_compression::BlockFormat::BC7 || GLEW_EXT_texture_compression_s3tc;
+    }
+
+    void MaterialLibrary::createCompressedTextureArray()
+    {
+        const auto internalFormat = BakedTexture::getInternalFormat(_bakedMaterials.front().texture->getFormat());
+        const auto numMipLevels = image_utils::getNumMipLevels(_layerWidth, _layerHeight);
+
+        glGenTextures(1, &_textureID);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, _textureID);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, numMipLevels, internalFormat, _layerWidth, _layerHeight, _numMaterials);
+
+        // Levels go from the mapped files to the driver without any intermediate copy
+        for (const auto& bakedMaterial : _bakedMaterials)
+        {
+            for (auto level = 0; level < numMipLevels; level++)
+            {
+                const auto& mipLevel = bakedMaterial.texture->getMipLevel(level);
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, bakedMaterial.layer, mipLevel.width, mipLevel.height, 1,
+                    internalFormat, static_cast<GLsizei>(mipLevel.size), bakedMaterial.texture->getMipData(level));
+            }
+        }
+        _bakedMaterials.clear();
+
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    size_t MaterialLibrary::getLayerSizeBytes() const
+    {
+        // All mip levels of one layer
+        auto sizeBytes = size_t(0);
+        for (auto level = 0; level < image_utils::getNumMipLevels(_layerWidth, _layerHeight); level++) {
+            sizeBytes += static_cast<size_t>(std::max(1, _layerWidth >> level)) * std::max(1, _layerHeight >> level) * NUM_CHANNELS;
+        }
+
+        return sizeBytes;
+    }
+
+    bool MaterialLibrary::isSlotFree(int slot)
+    {
+        if (_slotFences[slot] == nullptr) {
+            return true;
+        }
+
+        const auto result = glClientWaitSync(_slotFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+
+        // State of the failed fence is unknown, so the slot is freed by finishing all commands
+        if (result == GL_WAIT_FAILED)
+        {
+            std::cout << "Failed to wait for texture upload slot " << slot << std::endl;
+            glFinish();
+        }
+
+        glDeleteSync(_slotFences[slot]);
+        _slotFences[slot] = nullptr;
+        return true;
+    }
+
+    void MaterialLibrary::uploadLayer(int layer, const std::vector<unsigned char>& pixels)
+    {
+        // Slot is free, update checks it before uploading
+        const auto slot = _nextSlot;
+        _nextSlot = (_nextSlot + 1) % NUM_UPLOAD_SLOTS;
+
+        const auto slotOffset = getLayerSizeBytes() * slot;
+        memcpy(_pixelBufferData + slotOffset, pixels.data(), getLayerSizeBytes());
+
+        // Levels of the layer were filtered by the worker, other layers are left as they are
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBufferID);
+        GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, _textureID);
+        auto levelOffset = slotOffset;
+        for (auto level = 0; level < image_utils::getNumMipLevels(_layerWidth, _layerHeight); level++)
+        {
+            const auto levelWidth = std::max(1, _layerWidth >> level);
+            const auto levelHeight = std::max(1, _layerHeight >> level);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelWidth, levelHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(levelOffset));
+            levelOffset += static_cast<size_t>(levelWidth) * levelHeight * NUM_CHANNELS;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _slotFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void MaterialLibrary::deletePixelBuffer()
+    {
+        if (_pixelBufferID == 0) {
+            return;
+        }
+
+        for (auto& fence : _slotFences)
+        {
+            if (fence != nullptr) {
+                glDeleteSync(fence);
+            }
+        }
+        _slotFences.clear();
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBufferID);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &_pixelBufferID);
+        _pixelBufferID = 0;
+        _pixelBufferData = nullptr;
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,139 @@
+#pragma once
+
+// STL
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Project
+#include "bakedTexture.h"
+#include "threadPool.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Material system packing textures of all materials into one GL_TEXTURE_2D_ARRAY. Every material
+     * is one layer of the array, so objects with different textures differ only by a layer index
+     * (passed per instance) and a whole batch of them can be drawn without rebinding textures.
+     * Images not matching layer size are resampled to it when loaded.
+     *
+     * Images are decoded asynchronously on a thread pool. Until its image is ready, every layer
+     * holds placeholder color; decoded layers are streamed to the array through persistently
+     * mapped pixel buffer on the GL thread (see update).
+     *
+     * Materials baked offline (see texture_baker) skip all of that - if every material has a valid
+     * .ctex file of the same block format, the array is created compressed and all mip levels are
+     * uploaded directly from the mapped files, with nothing decoded and no mipmaps generated.
+     */
+    class MaterialLibrary
+    {
+    public:
+        static const int INVALID_MATERIAL; // Material index never returned for a valid material (-1)
+
+        /**
+         * Creates library with given size of array layers.
+         *
+         * @param threadPool   Thread pool decoding images
+         * @param layerWidth   Width of one layer in texels
+         * @param layerHeight  Height of one layer in texels
+         */
+        MaterialLibrary(ThreadPool& threadPool, GLsizei layerWidth = 1024, GLsizei layerHeight = 1024);
+        MaterialLibrary(const MaterialLibrary&) = delete;
+        MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+        ~MaterialLibrary();
+
+        /**
+         * Adds material baked next to the image, or starts decoding the image (uploaded later, by update).
+         *
+         * @param filepath  Path to the image file
+         *
+         * @return Material index (layer of the texture array), or INVALID_MATERIAL if image can't be opened.
+         */
+        int addMaterial(const std::string& filepath);
+
+        /**
+         * Creates texture array with all added materials - compressed with all baked materials uploaded,
+         * or filled with placeholder color until images are decoded.
+         */
+        bool createTextureArray();
+
+        /**
+         * Uploads images decoded since last update to their layers (must be called on the GL thread).
+         *
+         * @return True, if all materials have been loaded already.
+         */
+        bool update();
+
+        /**
+         * Binds texture array to given texture unit.
+         *
+         * @param textureUnit  Texture unit (GL_TEXTURE0, GL_TEXTURE1...)
+         */
+        void bind(GLenum textureUnit) const;
+
+        /**
+         * Gets OpenGL-assigned ID of the texture array (0 before it's created).
+         */
+        GLuint getTextureID() const;
+
+        /**
+         * Gets number of materials in the library.
+         */
+        int getNumMaterials() const;
+
+        /**
+         * Deletes texture array and all loaded images.
+         */
+        void deleteLibrary();
+
+    private:
+        static const int NUM_CHANNELS; // Every layer is RGBA
+        static const int NUM_UPLOAD_SLOTS; // Number of layers the pixel buffer holds at once
+        static const unsigned char PLACEHOLDER_COLOR[4]; // Color of layers not loaded yet
+
+        /**
+         * Material, whose image is being decoded.
+         */
+        struct PendingMaterial
+        {
+            int layer; // Layer of the texture array
+            std::string filepath; // Path to the image file
+            std::future<std::vector<unsigned char>> pixels; // Decoded pixels of all mip levels of a layer (empty on failure)
+        };
+
+        /**
+         * Material with baked texture matching the layer size.
+         */
+        struct BakedMaterial
+        {
+            int layer; // Layer of the texture array
+            std::string filepath; // Path to the image file (decoded if baked textures can't be used)
+            std::unique_ptr<BakedTexture> texture; // Mapped baked texture
+        };
+
+        ThreadPool& _threadPool; // Thread pool decoding images
+        GLsizei _layerWidth; // Width of one layer in texels
+        GLsizei _layerHeight; // Height of one layer in texels
+        std::vector<PendingMaterial> _pendingMaterials; // Materials not uploaded yet
+        std::vector<BakedMaterial> _bakedMaterials; // Materials with baked textures, not uploaded yet
+        int _numMaterials = 0; // Number of added materials
+        GLuint _textureID = 0; // OpenGL assigned texture ID
+
+        GLuint _pixelBufferID = 0; // Upload slots, from which layers are copied to the array
+        unsigned char* _pixelBufferData = nullptr; // Persistent mapping of the pixel buffer
+        std::vector<GLsync> _slotFences; // Fences signaled when the GPU stops reading slots (nullptr for free slot)
+        int _nextSlot = 0; // Slot used for next upload
+
+        void startDecoding(int layer, const std::string& filepath);
+        bool canUseBakedMaterials() const;
+        void createCompressedTextureArray();
+        size_t getLayerSizeBytes() const;
+        bool isSlotFree(int slot);
+        void uploadLayer(int layer, const std::vector<unsigned char>& pixels);
+        void deletePixelBuffer();
+    };
+
+} // namespace static_meshes_3D
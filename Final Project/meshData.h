@@ -0,0 +1,32 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+namespace static_meshes_3D {
+
+    /**
+     * One vertex with all attributes interleaved (position, texture coordinate, normal).
+     */
+    struct MeshVertex
+    {
+        glm::vec3 position;
+        glm::vec2 textureCoordinate;
+        glm::vec3 normal;
+    };
+
+    /**
+     * Mesh geometry in CPU memory as indexed triangle list.
+     */
+    struct MeshData
+    {
+        std::vector<MeshVertex> vertices; // Interleaved vertices
+        std::vector<GLuint> indices; // Triangle list indices (three per triangle)
+    };
+
+} // namespace static_meshes_3D
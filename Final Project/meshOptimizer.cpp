@@ -0,0 +1,294 @@
+// STL
+#include <algorithm>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "meshOptimizer.h"
+
+namespace static_meshes_3D {
+namespace mesh_optimizer {
+
+    namespace {
+
+        /**
+         * Triangles around every vertex, stored as one array with offsets (compressed adjacency).
+         */
+        struct VertexTriangles
+        {
+            std::vector<size_t> offsets; // First triangle of every vertex in triangles (one extra at the end)
+            std::vector<size_t> triangles; // Triangle indices grouped by vertex
+
+            VertexTriangles(const std::vector<GLuint>& indices, size_t numVertices)
+                : offsets(numVertices + 1, 0)
+                , triangles(indices.size())
+            {
+                for (const auto index : indices) {
+                    offsets[index + 1]++;
+                }
+                for (size_t i = 0; i < numVertices; i++) {
+                    offsets[i + 1] += offsets[i];
+                }
+
+                std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++) {
+                    triangles[fill[indices[i]]++] = i / 3;
+                }
+            }
+        };
+
+        const size_t NO_VERTEX = static_cast<size_t>(-1);
+
+    } // unnamed namespace
+
+    float VertexCacheStatistics::getACMR() const
+    {
+        return numTriangles > 0 ? static_cast<float>(numTransformedVertices) / numTriangles : 0.0f;
+    }
+
+    float VertexCacheStatistics::getATVR() const
+    {
+        return numVertices > 0 ? static_cast<float>(numTransformedVertices) / numVertices : 0.0f;
+    }
+
+    VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics& other)
+    {
+        numTriangles += other.numTriangles;
+        numVertices += other.numVertices;
+        numTransformedVertices += other.numTransformedVertices;
+        return *this;
+    }
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<GLuint>& indices, size_t numVertices, unsigned int cacheSize)
+    {
+        VertexCacheStatistics statistics;
+        statistics.numTriangles = indices.size() / 3;
+
+        // Vertex is in the cache, if it has been pushed less than cacheSize pushes ago
+        std::vector<size_t> pushTime(numVertices, 0);
+        std::vector<bool> isUsed(numVertices, false);
+        size_t numPushes = 0;
+        for (const auto index : indices)
+        {
+            if (!isUsed[index])
+            {
+                isUsed[index] = true;
+                statistics.numVertices++;
+            }
+
+            if (pushTime[index] == 0 || numPushes - pushTime[index] >= cacheSize)
+            {
+                pushTime[index] = ++numPushes;
+                statistics.numTransformedVertices++;
+            }
+        }
+
+        return statistics;
+    }
+
+    void optimizeVertexCache(std::vector<GLuint>& indices, size_t numVertices, unsigned int cacheSize, std::vector<size_t>* clusterStarts)
+    {
+        const auto numTriangles = indices.size() / 3;
+        const VertexTriangles vertexTriangles(indices, numVertices);
+
+        std::vector<size_t> liveTriangles(numVertices);
+        for (size_t i = 0; i < numVertices; i++) {
+            liveTriangles[i] = vertexTriangles.offsets[i + 1] - vertexTriangles.offsets[i];
+        }
+
+        std::vector<size_t> cacheTime(numVertices, 0); // Time stamp of the vertex entering the cache
+        std::vector<bool> isEmitted(numTriangles, false);
+        std::vector<size_t> deadEnds; // Stack of recently used vertices to continue from
+        std::vector<GLuint> result;
+        result.reserve(indices.size());
+        if (clusterStarts != nullptr) {
+            clusterStarts->clear();
+        }
+
+        size_t timeStamp = cacheSize + 1;
+        size_t nextInputVertex = 0; // Cursor of the input order, used when all else fails
+        size_t fanningVertex = numTriangles > 0 ? indices[0] : NO_VERTEX;
+        auto isNewCluster = true;
+        std::vector<size_t> candidates;
+        while (fanningVertex != NO_VERTEX)
+        {
+            if (isNewCluster && clusterStarts != nullptr) {
+                clusterStarts->push_back(result.size());
+            }
+
+            // Emit all remaining triangles around the fanning vertex
+            candidates.clear();
+            for (auto i = vertexTriangles.offsets[fanningVertex]; i < vertexTriangles.offsets[fanningVertex + 1]; i++)
+            {
+                const auto triangle = vertexTriangles.triangles[i];
+                if (isEmitted[triangle]) {
+                    continue;
+                }
+
+                for (auto j = 0; j < 3; j++)
+                {
+                    const auto vertex = indices[triangle * 3 + j];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (timeStamp - cacheTime[vertex] > cacheSize) {
+                        cacheTime[vertex] = timeStamp++;
+                    }
+                }
+
+                isEmitted[triangle] = true;
+            }
+
+            // Next fanning vertex is the candidate, which stays in the cache longest after its triangles are emitted
+            auto nextVertex = NO_VERTEX;
+            size_t bestPriority = 0;
+            for (const auto vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0) {
+                    continue;
+                }
+
+                size_t priority = 0;
+                if (timeStamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                    priority = timeStamp - cacheTime[vertex];
+                }
+                if (nextVertex == NO_VERTEX || priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    nextVertex = vertex;
+                }
+            }
+
+            // Dead end - continue from a recently used vertex or anywhere, which starts new cluster
+            isNewCluster = nextVertex == NO_VERTEX;
+            while (nextVertex == NO_VERTEX && !deadEnds.empty())
+            {
+                const auto vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[vertex] > 0) {
+                    nextVertex = vertex;
+                }
+            }
+            while (nextVertex == NO_VERTEX && nextInputVertex < indices.size())
+            {
+                const auto vertex = indices[nextInputVertex++];
+                if (liveTriangles[vertex] > 0) {
+                    nextVertex = vertex;
+                }
+            }
+
+            fanningVertex = nextVertex;
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeOverdraw(std::vector<GLuint>& indices, const std::vector<MeshVertex>& vertices, const std::vector<size_t>& clusterStarts)
+    {
+        if (clusterStarts.size() < 2) {
+            return;
+        }
+
+        /**
+         * Cluster with its sort key.
+         */
+        struct Cluster
+        {
+            size_t begin; // First index of the cluster
+            size_t end; // Index after the last one of the cluster
+            float occlusion; // How much the cluster faces out of the mesh (higher first)
+        };
+
+        // Area weighted centroids and normals, both of the clusters and of the whole mesh
+        std::vector<Cluster> clusters;
+        std::vector<glm::vec3> clusterCentroids;
+        std::vector<glm::vec3> clusterNormals;
+        auto meshCentroid = glm::vec3(0.0f);
+        auto meshArea = 0.0f;
+        for (size_t i = 0; i < clusterStarts.size(); i++)
+        {
+            const auto begin = clusterStarts[i];
+            const auto end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : indices.size();
+            auto centroid = glm::vec3(0.0f);
+            auto normal = glm::vec3(0.0f);
+            auto area = 0.0f;
+            for (auto j = begin; j < end; j += 3)
+            {
+                const auto& a = vertices[indices[j]].position;
+                const auto& b = vertices[indices[j + 1]].position;
+                const auto& c = vertices[indices[j + 2]].position;
+                const auto areaNormal = glm::cross(b - a, c - a);
+                const auto triangleArea = glm::length(areaNormal);
+                centroid += (a + b + c) * (triangleArea / 3.0f);
+                normal += areaNormal;
+                area += triangleArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+            clusters.push_back(Cluster{ begin, end, 0.0f });
+            clusterCentroids.push_back(area > 0.0f ? centroid / area : vertices[indices[begin]].position);
+            clusterNormals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f));
+        }
+
+        if (meshArea > 0.0f) {
+            meshCentroid /= meshArea;
+        }
+
+        for (size_t i = 0; i < clusters.size(); i++) {
+            clusters[i].occlusion = glm::dot(clusterCentroids[i] - meshCentroid, clusterNormals[i]);
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+            return a.occlusion > b.occlusion;
+        });
+
+        std::vector<GLuint> result;
+        result.reserve(indices.size());
+        for (const auto& cluster : clusters) {
+            result.insert(result.end(), indices.begin() + cluster.begin, indices.begin() + cluster.end);
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeVertexFetch(MeshData& meshData)
+    {
+        const auto unassigned = static_cast<GLuint>(-1);
+        std::vector<GLuint> remap(meshData.vertices.size(), unassigned);
+        std::vector<MeshVertex> vertices;
+        vertices.reserve(meshData.vertices.size());
+        for (auto& index : meshData.indices)
+        {
+            if (remap[index] == unassigned)
+            {
+                remap[index] = static_cast<GLuint>(vertices.size());
+                vertices.push_back(meshData.vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        meshData.vertices.swap(vertices);
+    }
+
+    void optimizeMesh(MeshData& meshData, VertexCacheStatistics* before, VertexCacheStatistics* after, unsigned int cacheSize)
+    {
+        if (before != nullptr) {
+            *before = analyzeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize);
+        }
+
+        std::vector<size_t> clusterStarts;
+        optimizeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize, &clusterStarts);
+        optimizeOverdraw(meshData.indices, meshData.vertices, clusterStarts);
+        optimizeVertexFetch(meshData);
+
+        if (after != nullptr) {
+            *after = analyzeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize);
+        }
+    }
+
+} // namespace mesh_optimizer
+} // namespace static_meshes_3D
@@ -0,0 +1,82 @@
+#pragma once
+
+// STL
+#include <cstddef>
+#include <vector>
+
+// Project
+#include "meshData.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Reordering of indexed triangle lists for the GPU - triangles for post-transform vertex cache and
+     * overdraw (Tipsify by Sander, Nehab and Barczak), then vertices for fetch locality. Works on any
+     * triangle list, like the one read back from StaticMeshIndexed3D or indexed OBJ data.
+     */
+    namespace mesh_optimizer {
+
+        static const unsigned int DEFAULT_CACHE_SIZE = 16; // Size of the simulated FIFO vertex cache
+
+        /**
+         * Vertex cache efficiency of a triangle list, simulated with FIFO cache.
+         */
+        struct VertexCacheStatistics
+        {
+            size_t numTriangles = 0; // Number of triangles
+            size_t numVertices = 0; // Number of distinct vertices referenced
+            size_t numTransformedVertices = 0; // Number of vertex cache misses (vertex shader invocations)
+
+            /**
+             * Gets average cache miss ratio - transformed vertices per triangle (0.5 at best, 3 at worst).
+             */
+            float getACMR() const;
+
+            /**
+             * Gets average transform to vertex ratio - transformed vertices per vertex (1 at best).
+             */
+            float getATVR() const;
+
+            VertexCacheStatistics& operator+=(const VertexCacheStatistics& other);
+        };
+
+        /**
+         * Simulates FIFO vertex cache over the triangle list.
+         */
+        VertexCacheStatistics analyzeVertexCache(const std::vector<GLuint>& indices, size_t numVertices, unsigned int cacheSize = DEFAULT_CACHE_SIZE);
+
+        /**
+         * Reorders triangles for vertex cache locality (Tipsify).
+         *
+         * @param indices        Triangle list to reorder
+         * @param numVertices    Number of vertices referenced by the indices
+         * @param cacheSize      Size of targeted vertex cache
+         * @param clusterStarts  If not null, gets first index of every cluster - run of triangles, which
+         *                       doesn't depend on cache contents left by the previous run
+         */
+        void optimizeVertexCache(std::vector<GLuint>& indices, size_t numVertices, unsigned int cacheSize = DEFAULT_CACHE_SIZE,
+            std::vector<size_t>* clusterStarts = nullptr);
+
+        /**
+         * Reorders clusters of triangles so that outward facing ones go first, occluding the rest.
+         * Order of triangles within clusters (and so vertex cache efficiency) is kept.
+         */
+        void optimizeOverdraw(std::vector<GLuint>& indices, const std::vector<MeshVertex>& vertices, const std::vector<size_t>& clusterStarts);
+
+        /**
+         * Reorders vertices in order of their first use by the indices (which are remapped), dropping unused ones.
+         */
+        void optimizeVertexFetch(MeshData& meshData);
+
+        /**
+         * Runs all optimizations on the mesh (vertex cache, overdraw, vertex fetch).
+         *
+         * @param before  If not null, gets statistics of the mesh before optimization
+         * @param after   If not null, gets statistics of the mesh after optimization
+         */
+        void optimizeMesh(MeshData& meshData, VertexCacheStatistics* before = nullptr, VertexCacheStatistics* after = nullptr,
+            unsigned int cacheSize = DEFAULT_CACHE_SIZE);
+
+    } // namespace mesh_optimizer
+
+} // namespace static_meshes_3D
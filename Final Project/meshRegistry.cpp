@@ -0,0 +1,123 @@
+// STL
+#include <exception>
+#include <iostream>
+#include <tuple>
+
+// Project
+#include "meshRegistry.h"
+
+namespace static_meshes_3D {
+
+    bool MeshRegistry::MeshKey::operator<(const MeshKey& other) const
+    {
+        return std::tie(type, params[0], params[1], params[2], params[3], attributeFlags)
+            < std::tie(other.type, other.params[0], other.params[1], other.params[2], other.params[3], other.attributeFlags);
+    }
+
+    MeshRegistry::MeshKey MeshRegistry::makeKey(MeshType type, float p0, float p1, float p2, float p3,
+        bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        MeshKey key;
+        key.type = type;
+        key.params[0] = p0;
+        key.params[1] = p1;
+        key.params[2] = p2;
+        key.params[3] = p3;
+        key.attributeFlags = (withPositions ? 1 : 0) | (withTextureCoordinates ? 2 : 0) | (withNormals ? 4 : 0);
+        return key;
+    }
+
+    const Cone& MeshRegistry::getCone(float radius, int numSlices, float height,
+        bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        const auto key = makeKey(MeshType::Cone, radius, static_cast<float>(numSlices), height, 0.0f,
+            withPositions, withTextureCoordinates, withNormals);
+        return getOrCreate<Cone>(key, radius, numSlices, height, withPositions, withTextureCoordinates, withNormals);
+    }
+
+    const Cylinder& MeshRegistry::getCylinder(float radius, int numSlices, float height,
+        bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        const auto key = makeKey(MeshType::Cylinder, radius, static_cast<float>(numSlices), height, 0.0f,
+            withPositions, withTextureCoordinates, withNormals);
+        return getOrCreate<Cylinder>(key, radius, numSlices, height, withPositions, withTextureCoordinates, withNormals);
+    }
+
+    const Torus& MeshRegistry::getTorus(int mainSegments, int tubeSegments, float mainRadius, float tubeRadius,
+        bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        const auto key = makeKey(MeshType::Torus, static_cast<float>(mainSegments), static_cast<float>(tubeSegments), mainRadius, tubeRadius,
+            withPositions, withTextureCoordinates, withNormals);
+        return getOrCreate<Torus>(key, mainSegments, tubeSegments, mainRadius, tubeRadius, withPositions, withTextureCoordinates, withNormals);
+    }
+
+    const Sphere& MeshRegistry::getSphere(float radius, int numSlices, int numStacks,
+        bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        const auto key = makeKey(MeshType::Sphere, radius, static_cast<float>(numSlices), static_cast<float>(numStacks), 0.0f,
+            withPositions, withTextureCoordinates, withNormals);
+        return getOrCreate<Sphere>(key, radius, numSlices, numStacks, withPositions, withTextureCoordinates, withNormals);
+    }
+
+    const Cube& MeshRegistry::getCube(glm::vec4 color, bool withPositions, bool withTextureCoordinates, bool withNormals)
+    {
+        const auto key = makeKey(MeshType::Cube, color.r, color.g, color.b, color.a,
+            withPositions, withTextureCoordinates, withNormals);
+        return getOrCreate<Cube>(key, color, withPositions, withTextureCoordinates, withNormals);
+    }
+
+    void MeshRegistry::beginBatch(ThreadPool& threadPool)
+    {
+        _batchThreadPool = &threadPool;
+    }
+
+    bool MeshRegistry::endBatch()
+    {
+        _batchThreadPool = nullptr;
+        auto numFailed = 0;
+        for (auto& pendingMesh : _pendingMeshes)
+        {
+            try
+            {
+                pendingMesh.generation.get();
+                continue;
+            }
+            catch (const std::exception& e) {
+                std::cout << "Failed to create mesh: " << e.what() << std::endl;
+            }
+            catch (...) {
+                std::cout << "Failed to create mesh: unknown error" << std::endl;
+            }
+
+            // Mesh that isn't generated mustn't be handed out again
+            _meshes.erase(pendingMesh.key);
+            numFailed++;
+        }
+
+        _pendingMeshes.clear();
+        return numFailed == 0;
+    }
+
+    void MeshRegistry::startGeneration(const MeshKey& key, StaticMesh3D& mesh)
+    {
+        auto meshPointer = &mesh;
+        _pendingMeshes.push_back(PendingMesh{ key, meshPointer, _batchThreadPool->enqueue([meshPointer]() { meshPointer->generate(); }) });
+    }
+
+    size_t MeshRegistry::getNumMeshes() const
+    {
+        return _meshes.size();
+    }
+
+    void MeshRegistry::clear()
+    {
+        // Workers mustn't be left writing into deleted meshes
+        for (auto& pendingMesh : _pendingMeshes) {
+            pendingMesh.generation.wait();
+        }
+
+        _pendingMeshes.clear();
+        _meshes.clear();
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,158 @@
+#pragma once
+
+// STL
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "cone.h"
+#include "cube.h"
+#include "cylinder.h"
+#include "sphere.h"
+#include "threadPool.h"
+#include "torus.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Owns every static mesh used by the scene. Each distinct primitive is generated only once
+     * (the first time it is requested) and is keyed by its generation parameters, so later requests
+     * hand out the same mesh. Meshes are never uploaded to the GPU, their generated data are meant
+     * to be read with getTriangleList (e.g. into the geometry arena), clear the registry afterwards.
+     *
+     * Meshes requested between beginBatch and endBatch are generated on a thread pool,
+     * so creating many meshes scales with cores.
+     */
+    class MeshRegistry
+    {
+    public:
+        MeshRegistry() = default;
+        MeshRegistry(const MeshRegistry&) = delete;
+        MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+        /**
+         * Gets cone with given parameters, creating it if it does not exist yet.
+         */
+        const Cone& getCone(float radius, int numSlices, float height,
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+        /**
+         * Gets cylinder with given parameters, creating it if it does not exist yet.
+         */
+        const Cylinder& getCylinder(float radius, int numSlices, float height,
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+        /**
+         * Gets torus with given parameters, creating it if it does not exist yet.
+         */
+        const Torus& getTorus(int mainSegments, int tubeSegments, float mainRadius, float tubeRadius,
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+        /**
+         * Gets sphere with given parameters, creating it if it does not exist yet.
+         */
+        const Sphere& getSphere(float radius, int numSlices, int numStacks,
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+        /**
+         * Gets cube with given parameters, creating it if it does not exist yet.
+         */
+        const Cube& getCube(glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+
+        /**
+         * Starts batch of mesh creation. Meshes created from now on are generated on the thread pool
+         * and their data mustn't be read before endBatch.
+         *
+         * @param threadPool  Thread pool generating mesh data (must outlive the batch)
+         */
+        void beginBatch(ThreadPool& threadPool);
+
+        /**
+         * Waits for generation of all meshes created in the batch. Meshes that failed are reported
+         * and removed from the registry (references to them are no longer valid, requesting them
+         * again creates them anew).
+         *
+         * @return True, if all meshes of the batch have been generated.
+         */
+        bool endBatch();
+
+        /**
+         * Gets number of distinct meshes held by the registry.
+         */
+        size_t getNumMeshes() const;
+
+        /**
+         * Deletes all meshes and their generated data.
+         */
+        void clear();
+
+    private:
+        enum class MeshType { Cone, Cylinder, Torus, Sphere, Cube };
+
+        /**
+         * Generation parameters of a mesh, used as a key to find already created meshes.
+         */
+        struct MeshKey
+        {
+            MeshType type;
+            float params[4];
+            int attributeFlags;
+
+            bool operator<(const MeshKey& other) const;
+        };
+
+        /**
+         * Mesh created in the current batch, with its data being generated on the thread pool.
+         */
+        struct PendingMesh
+        {
+            MeshKey key;
+            StaticMesh3D* mesh;
+            std::future<void> generation;
+        };
+
+        std::map<MeshKey, std::unique_ptr<StaticMesh3D>> _meshes; // All created meshes by their parameters
+        ThreadPool* _batchThreadPool = nullptr; // Thread pool of the current batch (nullptr outside of batch)
+        std::vector<PendingMesh> _pendingMeshes; // Meshes created in the current batch, in order of creation
+
+        void startGeneration(const MeshKey& key, StaticMesh3D& mesh);
+
+        static MeshKey makeKey(MeshType type, float p0, float p1, float p2, float p3,
+            bool withPositions, bool withTextureCoordinates, bool withNormals);
+
+        template<typename T, typename... Args>
+        const T& getOrCreate(const MeshKey& key, Args... args)
+        {
+            auto it = _meshes.find(key);
+            if (it == _meshes.end())
+            {
+                // Constructor leaves generation to us, meshes stay in memory only
+                it = _meshes.emplace(key, std::unique_ptr<StaticMesh3D>(new T(args..., true))).first;
+                if (_batchThreadPool != nullptr) {
+                    startGeneration(key, *it->second);
+                }
+                else
+                {
+                    // Mesh that isn't generated mustn't be handed out again
+                    try {
+                        it->second->generate();
+                    }
+                    catch (...)
+                    {
+                        _meshes.erase(it);
+                        throw;
+                    }
+                }
+            }
+
+            return static_cast<const T&>(*it->second);
+        }
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,646 @@
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <limits>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "objMeshLoader.h"
+#include "mappedFile.h"
+
+namespace static_meshes_3D {
+namespace obj_loader {
+
+    namespace {
+
+        const size_t MIN_CHUNK_SIZE = 1 << 20; // Smaller files are not worth splitting
+        const size_t CHUNKS_PER_THREAD = 4; // More chunks than threads even out different chunk complexity
+        const int32_t MISSING_INDEX = std::numeric_limits<int32_t>::min(); // Index of attribute not given in the face
+        const uint32_t EMPTY_SLOT = 0xFFFFFFFFu; // Value of unused slot in reference maps
+
+        /**
+         * Reference to position, texture coordinate and normal of a face vertex, as written in the file.
+         * Absolute indices are zero-based indices to the whole file, relative ones (negative in the file)
+         * are resolved against elements of the chunk only, as counts of previous chunks are not known yet.
+         */
+        struct VertexReference
+        {
+            int32_t indices[3]; // Position, texture coordinate and normal index (MISSING_INDEX, if not given)
+            uint32_t relativeMask; // Bit i set, if indices[i] is relative to the chunk
+
+            bool operator==(const VertexReference& other) const
+            {
+                return indices[0] == other.indices[0] && indices[1] == other.indices[1]
+                    && indices[2] == other.indices[2] && relativeMask == other.relativeMask;
+            }
+        };
+
+        uint32_t hashReference(const VertexReference& reference)
+        {
+            auto hash = static_cast<uint32_t>(reference.indices[0]) * 0x9E3779B1u
+                + static_cast<uint32_t>(reference.indices[1]) * 0x85EBCA77u
+                + static_cast<uint32_t>(reference.indices[2]) * 0xC2B2AE3Du
+                + reference.relativeMask;
+            hash ^= hash >> 16;
+            hash *= 0x7FEB352Du;
+            hash ^= hash >> 15;
+            return hash;
+        }
+
+        /**
+         * Open addressing (linear probing) map from vertex reference to vertex index. References are kept
+         * in the slots, so that a lookup touches only one place in memory.
+         */
+        class ReferenceMap
+        {
+        public:
+            explicit ReferenceMap(size_t expectedSize)
+            {
+                resize(expectedSize * 2);
+            }
+
+            /**
+             * Finds index of equal reference, or inserts reference with given index.
+             *
+             * @return Index of the reference.
+             */
+            uint32_t findOrInsert(const VertexReference& reference, uint32_t newIndex)
+            {
+                auto slot = hashReference(reference) & _mask;
+                while (_slots[slot].index != EMPTY_SLOT)
+                {
+                    if (_slots[slot].reference == reference) {
+                        return _slots[slot].index;
+                    }
+
+                    slot = (slot + 1) & _mask;
+                }
+
+                _slots[slot].reference = reference;
+                _slots[slot].index = newIndex;
+                if (++_numUsed * 2 > _slots.size()) {
+                    rehash();
+                }
+
+                return newIndex;
+            }
+
+        private:
+            struct Slot
+            {
+                VertexReference reference;
+                uint32_t index; // EMPTY_SLOT for free slots
+            };
+
+            std::vector<Slot> _slots; // All slots of the map
+            size_t _mask = 0; // Capacity - 1 (capacity is power of 2)
+            size_t _numUsed = 0; // Number of used slots
+
+            void resize(size_t minCapacity)
+            {
+                size_t capacity = 16;
+                while (capacity < minCapacity) {
+                    capacity *= 2;
+                }
+
+                Slot emptySlot;
+                emptySlot.index = EMPTY_SLOT;
+                _slots.assign(capacity, emptySlot);
+                _mask = capacity - 1;
+            }
+
+            void rehash()
+            {
+                std::vector<Slot> oldSlots;
+                oldSlots.swap(_slots);
+                resize(oldSlots.size() * 2);
+                for (const auto& oldSlot : oldSlots)
+                {
+                    if (oldSlot.index == EMPTY_SLOT) {
+                        continue;
+                    }
+
+                    auto slot = hashReference(oldSlot.reference) & _mask;
+                    while (_slots[slot].index != EMPTY_SLOT) {
+                        slot = (slot + 1) & _mask;
+                    }
+
+                    _slots[slot] = oldSlot;
+                }
+            }
+        };
+
+        /**
+         * Part of the file parsed by one task, with everything it defines.
+         */
+        struct Chunk
+        {
+            const char* begin; // First character of the chunk
+            const char* end; // Character after the chunk (chunk ends with whole line)
+
+            std::vector<glm::vec3> positions; // Positions defined in the chunk
+            std::vector<glm::vec2> textureCoordinates; // Texture coordinates defined in the chunk
+            std::vector<glm::vec3> normals; // Normals defined in the chunk
+            std::vector<VertexReference> references; // Distinct face vertices of the chunk
+            std::vector<GLuint> indices; // Triangles of the chunk, indexing references
+
+            size_t bases[3] = { 0, 0, 0 }; // Number of positions, texture coordinates and normals in previous chunks
+            std::string error; // Description of the first error (empty, if none)
+        };
+
+        bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        const char* skipSpaces(const char* p, const char* end)
+        {
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+
+            return p;
+        }
+
+        /**
+         * Parses decimal number with optional sign, fraction and exponent (no locale, no allocation).
+         *
+         * @return Position after the number, or p if there's no number.
+         */
+        const char* parseFloat(const char* p, const char* end, float& value)
+        {
+            static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+            const auto start = p;
+            auto isNegative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                isNegative = *p++ == '-';
+            }
+
+            // Digits are gathered as integer, only the first 19 significant ones fit
+            uint64_t mantissa = 0;
+            auto exponent = 0;
+            auto numDigits = 0;
+            auto hasDigits = false;
+            for (; p < end && *p >= '0' && *p <= '9'; p++, hasDigits = true)
+            {
+                if (numDigits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    numDigits += mantissa > 0 ? 1 : 0;
+                }
+                else {
+                    exponent++;
+                }
+            }
+
+            if (p < end && *p == '.')
+            {
+                for (p++; p < end && *p >= '0' && *p <= '9'; p++, hasDigits = true)
+                {
+                    if (numDigits < 19)
+                    {
+                        mantissa = mantissa * 10 + (*p - '0');
+                        numDigits += mantissa > 0 ? 1 : 0;
+                        exponent--;
+                    }
+                }
+            }
+
+            if (!hasDigits) {
+                return start;
+            }
+
+            if (p < end && (*p == 'e' || *p == 'E'))
+            {
+                auto exponentEnd = p + 1;
+                auto isExponentNegative = false;
+                if (exponentEnd < end && (*exponentEnd == '-' || *exponentEnd == '+')) {
+                    isExponentNegative = *exponentEnd++ == '-';
+                }
+
+                if (exponentEnd < end && *exponentEnd >= '0' && *exponentEnd <= '9')
+                {
+                    auto explicitExponent = 0;
+                    for (; exponentEnd < end && *exponentEnd >= '0' && *exponentEnd <= '9'; exponentEnd++) {
+                        explicitExponent = std::min(explicitExponent * 10 + (*exponentEnd - '0'), 1000);
+                    }
+
+                    exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+                    p = exponentEnd;
+                }
+            }
+
+            auto result = static_cast<double>(mantissa);
+            while (exponent > 22)
+            {
+                result *= 1e22;
+                exponent -= 22;
+            }
+            while (exponent < -22)
+            {
+                result /= 1e22;
+                exponent += 22;
+            }
+            result = exponent >= 0 ? result * POWERS_OF_TEN[exponent] : result / POWERS_OF_TEN[-exponent];
+
+            value = static_cast<float>(isNegative ? -result : result);
+            return p;
+        }
+
+        /**
+         * Parses decimal integer with optional sign.
+         *
+         * @return Position after the number, or p if there's no number.
+         */
+        const char* parseInt(const char* p, const char* end, int32_t& value)
+        {
+            const auto start = p;
+            auto isNegative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                isNegative = *p++ == '-';
+            }
+
+            if (p == end || *p < '0' || *p > '9') {
+                return start;
+            }
+
+            int64_t result = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                result = std::min<int64_t>(result * 10 + (*p - '0'), std::numeric_limits<int32_t>::max());
+            }
+
+            value = static_cast<int32_t>(isNegative ? -result : result);
+            return p;
+        }
+
+        /**
+         * Parses given number of floats, which must all be present.
+         */
+        const char* parseFloats(const char* p, const char* end, float* values, int count)
+        {
+            for (auto i = 0; i < count; i++)
+            {
+                const auto numberStart = skipSpaces(p, end);
+                p = parseFloat(numberStart, end, values[i]);
+                if (p == numberStart) {
+                    return nullptr;
+                }
+            }
+
+            return p;
+        }
+
+        /**
+         * Parses one face vertex (v, v/vt, v//vn or v/vt/vn), converting indices to chunk references.
+         *
+         * @param counts  Numbers of positions, texture coordinates and normals defined in the chunk so far
+         */
+        const char* parseFaceVertex(const char* p, const char* end, const size_t counts[3], VertexReference& reference)
+        {
+            reference.indices[0] = reference.indices[1] = reference.indices[2] = MISSING_INDEX;
+            reference.relativeMask = 0;
+            for (auto i = 0; i < 3; i++)
+            {
+                if (i > 0)
+                {
+                    if (p == end || *p != '/') {
+                        break;
+                    }
+                    p++;
+                }
+
+                int32_t index;
+                const auto indexEnd = parseInt(p, end, index);
+                if (indexEnd == p)
+                {
+                    // Only texture coordinate may be left out between slashes (v//vn)
+                    if (i == 1) {
+                        continue;
+                    }
+                    return nullptr;
+                }
+
+                p = indexEnd;
+                if (index > 0) {
+                    reference.indices[i] = index - 1;
+                }
+                else if (index < 0)
+                {
+                    reference.indices[i] = static_cast<int32_t>(counts[i]) + index;
+                    reference.relativeMask |= 1u << i;
+                }
+                else {
+                    return nullptr;
+                }
+            }
+
+            return p;
+        }
+
+        void parseChunk(Chunk& chunk)
+        {
+            ReferenceMap referenceMap((chunk.end - chunk.begin) / 256);
+            std::vector<GLuint> faceVertices;
+            size_t counts[3] = { 0, 0, 0 };
+            const auto end = chunk.end;
+            auto p = chunk.begin;
+            while (p < end)
+            {
+                const auto lineStart = skipSpaces(p, end);
+                auto lineEnd = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+                lineEnd = lineEnd != nullptr ? lineEnd : end;
+                p = lineEnd + 1;
+
+                const auto lineLength = lineEnd - lineStart;
+                if (lineLength < 2) {
+                    continue;
+                }
+
+                auto isValid = true;
+                if (lineStart[0] == 'v' && isSpace(lineStart[1]))
+                {
+                    glm::vec3 position;
+                    isValid = parseFloats(lineStart + 2, lineEnd, &position.x, 3) != nullptr;
+                    chunk.positions.push_back(position);
+                    counts[0]++;
+                }
+                else if (lineStart[0] == 'v' && lineStart[1] == 't' && lineLength > 2 && isSpace(lineStart[2]))
+                {
+                    // Second coordinate is optional for 1D textures
+                    auto textureCoordinate = glm::vec2(0.0f);
+                    const auto afterU = parseFloats(lineStart + 3, lineEnd, &textureCoordinate.x, 1);
+                    isValid = afterU != nullptr;
+                    if (isValid) {
+                        parseFloats(afterU, lineEnd, &textureCoordinate.y, 1);
+                    }
+                    chunk.textureCoordinates.push_back(textureCoordinate);
+                    counts[1]++;
+                }
+                else if (lineStart[0] == 'v' && lineStart[1] == 'n' && lineLength > 2 && isSpace(lineStart[2]))
+                {
+                    glm::vec3 normal;
+                    isValid = parseFloats(lineStart + 3, lineEnd, &normal.x, 3) != nullptr;
+                    chunk.normals.push_back(normal);
+                    counts[2]++;
+                }
+                else if (lineStart[0] == 'f' && isSpace(lineStart[1]))
+                {
+                    faceVertices.clear();
+                    auto q = skipSpaces(lineStart + 2, lineEnd);
+                    while (isValid && q < lineEnd)
+                    {
+                        VertexReference reference;
+                        q = parseFaceVertex(q, lineEnd, counts, reference);
+                        isValid = q != nullptr && (q == lineEnd || isSpace(*q));
+                        if (isValid)
+                        {
+                            const auto newIndex = static_cast<uint32_t>(chunk.references.size());
+                            const auto index = referenceMap.findOrInsert(reference, newIndex);
+                            if (index == newIndex) {
+                                chunk.references.push_back(reference);
+                            }
+                            faceVertices.push_back(index);
+                            q = skipSpaces(q, lineEnd);
+                        }
+                    }
+
+                    // Polygon is triangulated as a fan around its first vertex
+                    isValid = isValid && faceVertices.size() >= 3;
+                    for (size_t i = 2; isValid && i < faceVertices.size(); i++)
+                    {
+                        chunk.indices.push_back(faceVertices[0]);
+                        chunk.indices.push_back(faceVertices[i - 1]);
+                        chunk.indices.push_back(faceVertices[i]);
+                    }
+                }
+
+                if (!isValid)
+                {
+                    chunk.error = "invalid line '" + std::string(lineStart, std::min<size_t>(lineLength, 80)) + "'";
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Runs function for every chunk, on the thread pool if given.
+         */
+        void forEachChunk(std::vector<Chunk>& chunks, ThreadPool* threadPool, const std::function<void(Chunk&)>& function)
+        {
+            if (threadPool == nullptr || chunks.size() == 1)
+            {
+                for (auto& chunk : chunks) {
+                    function(chunk);
+                }
+                return;
+            }
+
+            std::vector<std::future<void>> tasks;
+            for (auto& chunk : chunks)
+            {
+                auto chunkPointer = &chunk;
+                tasks.push_back(threadPool->enqueue([chunkPointer, &function]() { function(*chunkPointer); }));
+            }
+            for (auto& task : tasks) {
+                task.get();
+            }
+        }
+
+        std::vector<Chunk> splitIntoChunks(const char* data, size_t size, size_t numThreads)
+        {
+            const auto numChunks = std::max<size_t>(1, std::min(size / MIN_CHUNK_SIZE, numThreads * CHUNKS_PER_THREAD));
+            std::vector<Chunk> chunks(numChunks);
+            auto chunkBegin = data;
+            const auto dataEnd = data + size;
+            for (size_t i = 0; i < numChunks; i++)
+            {
+                // Chunk ends right after the first line break following its even share
+                auto chunkEnd = i + 1 < numChunks ? std::max(chunkBegin, data + size * (i + 1) / numChunks) : dataEnd;
+                if (chunkEnd < dataEnd)
+                {
+                    const auto lineBreak = static_cast<const char*>(memchr(chunkEnd, '\n', dataEnd - chunkEnd));
+                    chunkEnd = lineBreak != nullptr ? lineBreak + 1 : dataEnd;
+                }
+
+                chunks[i].begin = chunkBegin;
+                chunks[i].end = chunkEnd;
+                chunkBegin = chunkEnd;
+            }
+
+            return chunks;
+        }
+
+        void computeMissingNormals(MeshData& meshData, const std::vector<bool>& isNormalMissing)
+        {
+            // Area weighted face normals are summed in vertices, which have no normal in the file
+            for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3)
+            {
+                const auto a = meshData.indices[i], b = meshData.indices[i + 1], c = meshData.indices[i + 2];
+                const auto faceNormal = glm::cross(meshData.vertices[b].position - meshData.vertices[a].position,
+                    meshData.vertices[c].position - meshData.vertices[a].position);
+                for (const auto vertex : { a, b, c })
+                {
+                    if (isNormalMissing[vertex]) {
+                        meshData.vertices[vertex].normal += faceNormal;
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < meshData.vertices.size(); i++)
+            {
+                auto& normal = meshData.vertices[i].normal;
+                if (isNormalMissing[i] && glm::length(normal) > 0.0f) {
+                    normal = glm::normalize(normal);
+                }
+            }
+        }
+
+    } // unnamed namespace
+
+    bool load(const std::string& filepath, MeshData& meshData, ThreadPool* threadPool)
+    {
+        meshData.vertices.clear();
+        meshData.indices.clear();
+
+        MappedFile file;
+        if (!file.open(filepath))
+        {
+            std::cout << "Failed to open OBJ file " << filepath << std::endl;
+            return false;
+        }
+
+        // Every chunk gets parsed on its own, element counts of previous chunks are applied afterwards
+        const auto data = reinterpret_cast<const char*>(file.getData());
+        auto chunks = splitIntoChunks(data, file.getSize(), threadPool != nullptr ? threadPool->getNumThreads() : 1);
+        forEachChunk(chunks, threadPool, parseChunk);
+
+        size_t totals[3] = { 0, 0, 0 };
+        for (auto& chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                std::cout << "Failed to parse OBJ file " << filepath << ": " << chunk.error << std::endl;
+                return false;
+            }
+
+            const size_t counts[3] = { chunk.positions.size(), chunk.textureCoordinates.size(), chunk.normals.size() };
+            for (auto i = 0; i < 3; i++)
+            {
+                chunk.bases[i] = totals[i];
+                totals[i] += counts[i];
+            }
+        }
+
+        // Resolve relative indices to absolute ones and check all of them
+        forEachChunk(chunks, threadPool, [&totals](Chunk& chunk)
+        {
+            for (auto& reference : chunk.references)
+            {
+                for (auto i = 0; i < 3; i++)
+                {
+                    auto& index = reference.indices[i];
+                    if (index == MISSING_INDEX) {
+                        continue;
+                    }
+
+                    const auto absoluteIndex = (reference.relativeMask & (1u << i)) ? static_cast<int64_t>(chunk.bases[i]) + index : index;
+                    if (absoluteIndex < 0 || absoluteIndex >= static_cast<int64_t>(totals[i]))
+                    {
+                        chunk.error = "index out of range";
+                        return;
+                    }
+                    index = static_cast<int32_t>(absoluteIndex);
+                }
+
+                reference.relativeMask = 0;
+            }
+        });
+
+        for (const auto& chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                std::cout << "Failed to parse OBJ file " << filepath << ": " << chunk.error << std::endl;
+                return false;
+            }
+        }
+
+        // Attributes of all chunks are concatenated in file order
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> textureCoordinates;
+        std::vector<glm::vec3> normals;
+        positions.reserve(totals[0]);
+        textureCoordinates.reserve(totals[1]);
+        normals.reserve(totals[2]);
+        size_t numChunkReferences = 0;
+        size_t numIndices = 0;
+        for (auto& chunk : chunks)
+        {
+            positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+            textureCoordinates.insert(textureCoordinates.end(), chunk.textureCoordinates.begin(), chunk.textureCoordinates.end());
+            normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+            std::vector<glm::vec3>().swap(chunk.positions);
+            std::vector<glm::vec2>().swap(chunk.textureCoordinates);
+            std::vector<glm::vec3>().swap(chunk.normals);
+            numChunkReferences += chunk.references.size();
+            numIndices += chunk.indices.size();
+        }
+
+        // Vertices shared by chunks are merged, giving every chunk reference its final vertex
+        std::vector<VertexReference> vertexReferences;
+        vertexReferences.reserve(numChunkReferences);
+        ReferenceMap vertexMap(numChunkReferences);
+        std::vector<std::vector<GLuint>> chunkVertices(chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            chunkVertices[i].reserve(chunks[i].references.size());
+            for (const auto& reference : chunks[i].references)
+            {
+                const auto newIndex = static_cast<uint32_t>(vertexReferences.size());
+                const auto index = vertexMap.findOrInsert(reference, newIndex);
+                if (index == newIndex) {
+                    vertexReferences.push_back(reference);
+                }
+                chunkVertices[i].push_back(index);
+            }
+        }
+
+        meshData.vertices.resize(vertexReferences.size());
+        std::vector<bool> isNormalMissing(vertexReferences.size(), false);
+        auto hasMissingNormals = false;
+        for (size_t i = 0; i < vertexReferences.size(); i++)
+        {
+            const auto& reference = vertexReferences[i];
+            auto& vertex = meshData.vertices[i];
+            vertex.position = reference.indices[0] != MISSING_INDEX ? positions[reference.indices[0]] : glm::vec3(0.0f);
+            vertex.textureCoordinate = reference.indices[1] != MISSING_INDEX ? textureCoordinates[reference.indices[1]] : glm::vec2(0.0f);
+            vertex.normal = reference.indices[2] != MISSING_INDEX ? normals[reference.indices[2]] : glm::vec3(0.0f);
+            isNormalMissing[i] = reference.indices[2] == MISSING_INDEX;
+            hasMissingNormals = hasMissingNormals || isNormalMissing[i];
+        }
+
+        meshData.indices.reserve(numIndices);
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            for (const auto index : chunks[i].indices) {
+                meshData.indices.push_back(chunkVertices[i][index]);
+            }
+        }
+
+        if (hasMissingNormals) {
+            computeMissingNormals(meshData, isNormalMissing);
+        }
+
+        return true;
+    }
+
+} // namespace obj_loader
+} // namespace static_meshes_3D
@@ -0,0 +1,35 @@
+#pragma once
+
+// STL
+#include <string>
+
+// Project
+#include "meshData.h"
+#include "threadPool.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Wavefront OBJ loader producing indexed mesh with interleaved vertices. File is memory mapped and
+     * split into chunks at line boundaries, which are parsed in parallel. Supports polygons with any
+     * number of vertices (triangulated as fans), negative (relative) indices and faces without texture
+     * coordinates or normals (texture coordinates are zeroed, missing normals are computed smooth).
+     * Only geometry is read - groups, objects, materials and smoothing groups are ignored.
+     */
+    namespace obj_loader {
+
+        /**
+         * Loads OBJ file.
+         *
+         * @param filepath    Path to the OBJ file
+         * @param meshData    Mesh data to be filled (vertices are unique combinations of position,
+         *                    texture coordinate and normal in the file)
+         * @param threadPool  Thread pool parsing the chunks (nullptr parses on the calling thread)
+         *
+         * @return True, if file has been loaded successfully.
+         */
+        bool load(const std::string& filepath, MeshData& meshData, ThreadPool* threadPool = nullptr);
+
+    } // namespace obj_loader
+
+} // namespace static_meshes_3D
@@ -3,6 +3,7 @@
 
 // Project
 #include "plane.h"
+#include "glStateCache.h"
 
 namespace static_meshes_3D {
 
@@ -28,8 +29,8 @@ namespace static_meshes_3D {
     //    glm::vec3(0.0f, -1.0f, 0.0f), // Bottom face
     //};
 
-    Plane::Plane(glm::vec4 color)
-        : StaticMesh3D(true, true, true),
+    Plane::Plane(glm::vec4 color, bool isInitializationDeferred)
+        : StaticMesh3D(true, true, true, isInitializationDeferred),
         _color(color)
     {
         initializeData();
@@ -47,17 +48,29 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
+    void Plane::renderInstances(GLsizei instanceCount) const
+    {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instanceCount);
+    }
+
+    void Plane::getTriangleIndices(std::vector<GLuint>& indices) const
+    {
+        for (GLuint i = 0; i < 6; i++) {
+            indices.push_back(i);
+        }
+    }
+
     void Plane::renderPoints() const
     {
         if (!_isInitialized) {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
         glDrawArrays(GL_POINTS, 0, 6);
     }
 
@@ -67,7 +80,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
 
         if (facesBitmask & CUBE_FRONT_FACE) {
             glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -89,41 +102,17 @@ namespace static_meshes_3D {
         }
     }*/
 
-    void Plane::initializeData()
+    void Plane::generateData()
     {
-        if (_isInitialized) {
-            return;
-        }
-
-        glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
-
         const auto numVertices = 6;
-        const auto vertexByteSize = getVertexByteSize();
-        _vbo.createVBO(vertexByteSize * numVertices);
-        _vbo.bindVBO();
 
-        if (hasPositions())
+        // Texture is stretched over the whole plane, which faces up
+        VertexWriter vertexWriter(*this, numVertices, glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, 0.5f));
+        for (auto i = 0; i < numVertices; i++)
         {
-            _vbo.addRawData(vertices, sizeof(glm::vec3) * numVertices);
+            const auto textureCoordinate = glm::vec2(vertices[i].x + 0.5f, 0.5f - vertices[i].z);
+            vertexWriter.write(vertices[i], textureCoordinate, glm::vec3(0.0f, 1.0f, 0.0f));
         }
-
-        /*if (hasTextureCoordinates())
-        {
-            for (auto i = 0; i < 6; i++)
-            {
-                _vbo.addRawData(textureCoordinates, sizeof(glm::vec2) * 6);
-            }
-        }*/
-
-
-        // Add color for every vertex of cylinder bottom cover
-        _vbo.addData(_color, numVertices);
-
-
-        _vbo.uploadDataToGPU(GL_STATIC_DRAW);
-        setVertexAttributesPointers(numVertices);
-        _isInitialized = true;
     }
 
 } // namespace static_meshes_3D
\ No newline at end of file
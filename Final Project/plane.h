@@ -21,7 +21,7 @@ namespace static_meshes_3D {
     class Plane : public StaticMesh3D
     {
     public:
-        Plane(glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        Plane(glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), bool isInitializationDeferred = false);
 
         void render() const override;
         void renderPoints() const override;
@@ -37,7 +37,9 @@ namespace static_meshes_3D {
         glm::vec4 getColor() const;
 
     private:
-        void initializeData() override;
+        void generateData() override;
+        void renderInstances(GLsizei instanceCount) const override;
+        void getTriangleIndices(std::vector<GLuint>& indices) const override;
         glm::vec4 _color;
     };
 
@@ -0,0 +1,114 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "renderQueue.h"
+#include "glStateCache.h"
+
+namespace static_meshes_3D {
+
+    const float RenderQueue::MAX_SORT_DEPTH = 100.0f;
+
+    RenderQueue::RenderQueue(GeometryArena& arena)
+        : _arena(arena) {}
+
+    void RenderQueue::clear()
+    {
+        _packets.clear();
+    }
+
+    void RenderQueue::submit(const DrawPacket& packet)
+    {
+        _packets.push_back(packet);
+    }
+
+    void RenderQueue::flush(const glm::mat4& view)
+    {
+        _numBatches = 0;
+        if (_packets.empty()) {
+            return;
+        }
+
+        // Sort packets by their state keys
+        _sortItems.clear();
+        for (size_t i = 0; i < _packets.size(); i++) {
+            _sortItems.push_back({ createSortKey(_packets[i], view), i });
+        }
+
+        std::sort(_sortItems.begin(), _sortItems.end(), [](const SortItem& a, const SortItem& b) {
+            return a.key < b.key;
+        });
+
+        // Sorted packet i is drawn with instance i
+        _sortedTransforms.clear();
+        _sortedMaterialLayers.clear();
+        _arena.clearCommands();
+        for (size_t i = 0; i < _sortItems.size(); i++)
+        {
+            const auto& packet = _packets[_sortItems[i].packetIndex];
+            _sortedTransforms.push_back(packet.transform);
+            _sortedMaterialLayers.push_back(packet.materialLayer);
+            _arena.addCommand(packet.meshHandle, static_cast<GLuint>(i));
+        }
+        _instances.setInstances(_sortedTransforms, _sortedMaterialLayers);
+
+        // Submit every run of packets with the same program and texture array in one multi-draw call
+        auto& stateCache = GLStateCache::getInstance();
+        _arena.bind(_instances);
+        stateCache.activeTexture(GL_TEXTURE0);
+        size_t firstCommand = 0;
+        while (firstCommand < _sortItems.size())
+        {
+            const auto& packet = _packets[_sortItems[firstCommand].packetIndex];
+            auto numCommands = size_t(1);
+            while (firstCommand + numCommands < _sortItems.size())
+            {
+                const auto& nextPacket = _packets[_sortItems[firstCommand + numCommands].packetIndex];
+                if (nextPacket.shader != packet.shader || nextPacket.textureArray != packet.textureArray) {
+                    break;
+                }
+                numCommands++;
+            }
+
+            packet.shader->use();
+            if (packet.textureArray != 0) {
+                stateCache.bindTexture(GL_TEXTURE_2D_ARRAY, packet.textureArray);
+            }
+            _arena.submitCommands(firstCommand, numCommands);
+
+            firstCommand += numCommands;
+            _numBatches++;
+        }
+    }
+
+    size_t RenderQueue::getNumPackets() const
+    {
+        return _packets.size();
+    }
+
+    size_t RenderQueue::getNumBatches() const
+    {
+        return _numBatches;
+    }
+
+    void RenderQueue::deleteQueue()
+    {
+        _instances.deleteInstanceBuffer();
+        _packets.clear();
+    }
+
+    uint64_t RenderQueue::createSortKey(const DrawPacket& packet, const glm::mat4& view) const
+    {
+        // Depth of the object origin in front of the camera, quantized to 16 bits (near objects first)
+        const auto viewPosition = view * packet.transform[3];
+        const auto depth = glm::clamp(-viewPosition.z / MAX_SORT_DEPTH, 0.0f, 1.0f);
+        const auto depthKey = static_cast<uint64_t>(depth * 0xFFFF);
+
+        const auto programKey = static_cast<uint64_t>(packet.shader->ID & 0xFFFF);
+        const auto textureKey = static_cast<uint64_t>(packet.textureArray & 0xFFFF);
+        const auto vaoKey = static_cast<uint64_t>(_arena.getVertexArrayID() & 0xFFFF);
+
+        return (programKey << 48) | (textureKey << 32) | (vaoKey << 16) | depthKey;
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,100 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "shader.h"
+#include "geometryArena.h"
+#include "instanceBuffer.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Collects draw packets of one frame and submits them sorted by a 64-bit state key
+     * (program, texture, VAO, depth). Sorting puts packets sharing state next to each other,
+     * so every run of equal program and texture array is drawn with one multi-draw call from the
+     * geometry arena, and packets within a run go front to back for early depth rejection.
+     */
+    class RenderQueue
+    {
+    public:
+        /**
+         * One draw of one mesh.
+         */
+        struct DrawPacket
+        {
+            int meshHandle; // Handle of the mesh in the geometry arena
+            GLuint textureArray; // Material texture array bound to texture unit 0 (0 for none)
+            GLint materialLayer; // Layer of the texture array
+            const Shader* shader; // Shader program used for drawing
+            glm::mat4 transform; // Model matrix
+        };
+
+        /**
+         * Creates queue drawing meshes of given geometry arena.
+         */
+        explicit RenderQueue(GeometryArena& arena);
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        /**
+         * Removes all packets submitted so far.
+         */
+        void clear();
+
+        /**
+         * Adds draw packet to the queue.
+         */
+        void submit(const DrawPacket& packet);
+
+        /**
+         * Sorts all submitted packets and draws them.
+         *
+         * @param view  View matrix of the camera (used for depth part of sort keys)
+         */
+        void flush(const glm::mat4& view);
+
+        /**
+         * Gets number of packets submitted since last clear.
+         */
+        size_t getNumPackets() const;
+
+        /**
+         * Gets number of multi-draw calls issued by last flush.
+         */
+        size_t getNumBatches() const;
+
+        /**
+         * Deletes instance buffer of the queue.
+         */
+        void deleteQueue();
+
+    private:
+        static const float MAX_SORT_DEPTH; // View space depth mapped to the largest depth key
+
+        /**
+         * Packet prepared for sorting.
+         */
+        struct SortItem
+        {
+            uint64_t key; // Sort key (program | texture | VAO | depth, from most to least significant 16 bits)
+            size_t packetIndex; // Index of the packet in submitted packets
+        };
+
+        GeometryArena& _arena; // Arena holding meshes of all packets
+        InstanceBuffer _instances; // Transforms of packets, in sorted order
+        std::vector<DrawPacket> _packets; // Packets submitted since last clear
+        std::vector<SortItem> _sortItems; // Packets sorted by their keys
+        std::vector<glm::mat4> _sortedTransforms; // Transforms in sorted order, uploaded to instance buffer
+        std::vector<GLint> _sortedMaterialLayers; // Material layers in sorted order, uploaded to instance buffer
+        size_t _numBatches = 0; // Multi-draw calls issued by last flush
+
+        uint64_t createSortKey(const DrawPacket& packet, const glm::mat4& view) const;
+    };
+
+} // namespace static_meshes_3D
@@ -0,0 +1,169 @@
+// STL
+#include <cstdint>
+#include <limits>
+
+// Project
+#include "sceneGraph.h"
+
+namespace static_meshes_3D {
+
+    const int SceneGraph::NO_NODE = -1;
+
+    int SceneGraph::addGroup(int parent, const glm::mat4& localTransform)
+    {
+        return addNode(parent, localTransform, NO_NODE, 0, glm::vec3(0.0f), glm::vec3(0.0f), 0.0f);
+    }
+
+    int SceneGraph::addObject(int parent, const glm::mat4& localTransform, int lodChain, int material, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius)
+    {
+        _numObjects++;
+        return addNode(parent, localTransform, lodChain, material, boundsMin, boundsMax, radius);
+    }
+
+    int SceneGraph::addNode(int parent, const glm::mat4& localTransform, int lodChain, int material, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius)
+    {
+        const auto index = static_cast<int>(_nodes.size());
+        SceneNode node;
+        node.parent = parent;
+        node.localTransform = localTransform;
+        node.worldTransform = parent != NO_NODE ? _nodes[parent].worldTransform * localTransform : localTransform;
+        node.lodChain = lodChain;
+        node.material = material;
+        node.lodLevel = 0;
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+        node.radius = radius;
+        node.proxy = BoundingVolumeHierarchy::NULL_NODE;
+        node.isDirty = false;
+        if (lodChain != NO_NODE)
+        {
+            glm::vec3 worldMin, worldMax;
+            getWorldBounds(node, worldMin, worldMax);
+            node.proxy = _hierarchy.insert(worldMin, worldMax, index);
+        }
+
+        _nodes.push_back(node);
+        _bounds.add(boundsMin, boundsMax, radius, node.worldTransform);
+        if (parent != NO_NODE) {
+            _nodes[parent].children.push_back(index);
+        }
+
+        return index;
+    }
+
+    void SceneGraph::setLocalTransform(int node, const glm::mat4& localTransform)
+    {
+        auto& sceneNode = _nodes[node];
+        sceneNode.localTransform = localTransform;
+        if (!sceneNode.isDirty)
+        {
+            sceneNode.isDirty = true;
+            _dirtyNodes.push_back(node);
+        }
+    }
+
+    void SceneGraph::update()
+    {
+        // Subtree of a dirty node may have been updated with its dirty ancestor already, then it's clean
+        for (const auto node : _dirtyNodes)
+        {
+            if (_nodes[node].isDirty) {
+                updateSubtree(node);
+            }
+        }
+
+        _dirtyNodes.clear();
+    }
+
+    void SceneGraph::updateSubtree(int node)
+    {
+        std::vector<int> stack(1, node);
+        while (!stack.empty())
+        {
+            const auto index = stack.back();
+            auto& sceneNode = _nodes[index];
+            stack.pop_back();
+            sceneNode.worldTransform = sceneNode.parent != NO_NODE ? _nodes[sceneNode.parent].worldTransform * sceneNode.localTransform : sceneNode.localTransform;
+            sceneNode.isDirty = false;
+            if (sceneNode.proxy != BoundingVolumeHierarchy::NULL_NODE)
+            {
+                glm::vec3 worldMin, worldMax;
+                getWorldBounds(sceneNode, worldMin, worldMax);
+                _hierarchy.move(sceneNode.proxy, worldMin, worldMax);
+                _bounds.set(index, sceneNode.boundsMin, sceneNode.boundsMax, sceneNode.radius, sceneNode.worldTransform);
+            }
+
+            stack.insert(stack.end(), sceneNode.children.begin(), sceneNode.children.end());
+        }
+    }
+
+    SceneNode& SceneGraph::getNode(int node)
+    {
+        return _nodes[node];
+    }
+
+    const SceneNode& SceneGraph::getNode(int node) const
+    {
+        return _nodes[node];
+    }
+
+    int SceneGraph::getNumNodes() const
+    {
+        return static_cast<int>(_nodes.size());
+    }
+
+    int SceneGraph::getNumObjects() const
+    {
+        return _numObjects;
+    }
+
+    const BoundingVolumeHierarchy& SceneGraph::getHierarchy() const
+    {
+        return _hierarchy;
+    }
+
+    void SceneGraph::clear()
+    {
+        _nodes.clear();
+        _dirtyNodes.clear();
+        _hierarchy.clear();
+        _bounds.clear();
+        _numObjects = 0;
+    }
+
+    void SceneGraph::queryFrustum(const Frustum& frustum, std::vector<int>& nodes) const
+    {
+        std::vector<int> candidates;
+        _hierarchy.queryFrustum(frustum, nodes, candidates);
+
+        CullingBounds candidateBounds;
+        for (const auto node : candidates) {
+            candidateBounds.append(_bounds, node);
+        }
+
+        std::vector<uint8_t> visibility;
+        candidateBounds.cull(frustum, visibility);
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (visibility[i] != 0) {
+                nodes.push_back(candidates[i]);
+            }
+        }
+    }
+
+    int SceneGraph::pick(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+    {
+        return _hierarchy.raycast(origin, direction, std::numeric_limits<float>::max(), distance);
+    }
+
+    void SceneGraph::queryNeighbours(const glm::vec3& center, float radius, std::vector<int>& nodes) const
+    {
+        _hierarchy.querySphere(center, radius, nodes);
+    }
+
+    void SceneGraph::getWorldBounds(const SceneNode& node, glm::vec3& boundsMin, glm::vec3& boundsMax) const
+    {
+        BoundingVolumeHierarchy::transformBox(node.boundsMin, node.boundsMax, node.worldTransform, boundsMin, boundsMax);
+    }
+
+} // namespace static_meshes_3D
@@ -0,0 +1,135 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolumeHierarchy.h"
+#include "frustumCulling.h"
+
+namespace static_meshes_3D {
+
+    /**
+     * Node of the scene graph. Group nodes only transform their children, object nodes also draw
+     * a level of detail chain with a material.
+     */
+    struct SceneNode
+    {
+        int parent; // Parent node (SceneGraph::NO_NODE for root nodes)
+        std::vector<int> children; // Child nodes
+        glm::mat4 localTransform; // Transform relative to the parent
+        glm::mat4 worldTransform; // Transform relative to the world (model matrix of the object)
+        int lodChain; // Index of the LOD chain drawn by the node (SceneGraph::NO_NODE for group nodes)
+        int material; // Material of the object (layer of material texture array)
+        int lodLevel; // Level of detail drawn last frame
+        glm::vec3 boundsMin; // Minimal corner of object bounding box (in model space)
+        glm::vec3 boundsMax; // Maximal corner of object bounding box (in model space)
+        float radius; // Radius of object bounding sphere around center of the box (in model space)
+        int proxy; // Proxy of the object in the bounding volume hierarchy (NULL_NODE for group nodes)
+        bool isDirty; // Flag telling, if world transform must be recomputed
+    };
+
+    /**
+     * Hierarchy of transformed scene objects. World space boxes of all objects are kept in a bounding
+     * volume hierarchy, which is refitted incrementally when transforms change, so that culling,
+     * picking and proximity queries don't walk all objects.
+     */
+    class SceneGraph
+    {
+    public:
+        static const int NO_NODE; // Index of no node (-1)
+
+        /**
+         * Adds group node, which has no geometry of its own.
+         *
+         * @param parent          Parent node (NO_NODE for root node)
+         * @param localTransform  Transform relative to the parent
+         *
+         * @return Index of the node.
+         */
+        int addGroup(int parent, const glm::mat4& localTransform);
+
+        /**
+         * Adds object node.
+         *
+         * @param parent          Parent node (NO_NODE for root node)
+         * @param localTransform  Transform relative to the parent
+         * @param lodChain        Index of the LOD chain drawn by the node
+         * @param material        Material of the object
+         * @param boundsMin       Minimal corner of object bounding box (in model space)
+         * @param boundsMax       Maximal corner of object bounding box (in model space)
+         * @param radius          Radius of bounding sphere around center of the box (in model space)
+         *
+         * @return Index of the node.
+         */
+        int addObject(int parent, const glm::mat4& localTransform, int lodChain, int material, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius);
+
+        /**
+         * Sets transform of the node relative to its parent (applied to whole subtree by next update).
+         */
+        void setLocalTransform(int node, const glm::mat4& localTransform);
+
+        /**
+         * Recomputes world transforms of changed subtrees and refits their objects in the hierarchy.
+         */
+        void update();
+
+        /**
+         * Gets node with given index.
+         */
+        SceneNode& getNode(int node);
+        const SceneNode& getNode(int node) const;
+
+        /**
+         * Gets number of nodes / number of object nodes.
+         */
+        int getNumNodes() const;
+        int getNumObjects() const;
+
+        /**
+         * Gets bounding volume hierarchy of all objects (user data are node indices).
+         */
+        const BoundingVolumeHierarchy& getHierarchy() const;
+
+        /**
+         * Removes all nodes.
+         */
+        void clear();
+
+        /**
+         * Finds object nodes at least partially inside the frustum. Subtrees completely inside are
+         * accepted by the hierarchy, objects of subtrees crossing the frustum are tested in one batch
+         * by their boxes and spheres (CullingBounds).
+         */
+        void queryFrustum(const Frustum& frustum, std::vector<int>& nodes) const;
+
+        /**
+         * Finds object node hit first by the ray (by its world space box).
+         *
+         * @param distance  Gets distance of the hit (in multiples of direction)
+         *
+         * @return Index of the node, or NO_NODE if nothing has been hit.
+         */
+        int pick(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+        /**
+         * Finds object nodes, whose world space boxes are closer than radius to given point.
+         */
+        void queryNeighbours(const glm::vec3& center, float radius, std::vector<int>& nodes) const;
+
+    private:
+        std::vector<SceneNode> _nodes; // All nodes
+        std::vector<int> _dirtyNodes; // Nodes, whose local transform has changed since last update
+        BoundingVolumeHierarchy _hierarchy; // World space boxes of all objects
+        CullingBounds _bounds; // World space boxes and spheres of all nodes (empty for group nodes)
+        int _numObjects = 0; // Number of object nodes
+
+        int addNode(int parent, const glm::mat4& localTransform, int lodChain, int material, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float radius);
+        void updateSubtree(int node);
+        void getWorldBounds(const SceneNode& node, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+    };
+
+} // namespace static_meshes_3D
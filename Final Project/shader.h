@@ -6,7 +6,11 @@
 #include <glm/glm.hpp>
 #include <GL/glew.h>
 
+#include "glStateCache.h"
+
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -96,74 +100,155 @@ public:
 		glDeleteShader(fragment);
 		if (geometryPath != nullptr)
 			glDeleteShader(geometry);
-
+		// 3. cache locations of all active uniforms, so setters don't query them every call
+		reflectUniforms();
+	}
+	// constructor generates compute shader program on the fly
+	// ------------------------------------------------------------------------
+	explicit Shader(const char* computePath)
+	{
+		// 1. retrieve the compute source code from filePath
+		std::string computeCode;
+		std::ifstream cShaderFile;
+		cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		try
+		{
+			cShaderFile.open(computePath);
+			std::stringstream cShaderStream;
+			cShaderStream << cShaderFile.rdbuf();
+			cShaderFile.close();
+			computeCode = cShaderStream.str();
+		}
+		catch (std::ifstream::failure& e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		}
+		const char* cShaderCode = computeCode.c_str();
+		// 2. compile shader
+		unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(compute, 1, &cShaderCode, NULL);
+		glCompileShader(compute);
+		checkCompileErrors(compute, "COMPUTE");
+		// shader Program
+		ID = glCreateProgram();
+		glAttachShader(ID, compute);
+		glLinkProgram(ID);
+		checkCompileErrors(ID, "PROGRAM");
+		glDeleteShader(compute);
+		// 3. cache locations of all active uniforms
+		reflectUniforms();
+	}
+	// activate the shader (through state cache, so using already current program costs nothing)
+	// ------------------------------------------------------------------------
+	void use() const
+	{
+		GLStateCache::getInstance().useProgram(ID);
 	}
-	// activate the shader
+	// location of the uniform (-1 if the program has no such active uniform)
 	// ------------------------------------------------------------------------
-	void use()
+	GLint getUniformLocation(const std::string& name) const
 	{
-		glUseProgram(ID);
+		const auto it = uniformLocations.find(name);
+		return it != uniformLocations.end() ? it->second : -1;
+	}
+	// binds the uniform block of the program to the uniform buffer binding point
+	// ------------------------------------------------------------------------
+	void bindUniformBlock(const std::string& blockName, GLuint bindingPoint) const
+	{
+		const GLuint blockIndex = glGetUniformBlockIndex(ID, blockName.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, blockIndex, bindingPoint);
 	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(getUniformLocation(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(getUniformLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string& name, const glm::vec2& value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform2fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec2(const std::string& name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string& name, const glm::vec3& value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform3fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec3(const std::string& name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string& name, const glm::vec4& value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform4fv(getUniformLocation(name), 1, &value[0]);
 	}
 	void setVec4(const std::string& name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string& name, const glm::mat2& mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string& name, const glm::mat3& mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string& name, const glm::mat4& mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	std::unordered_map<std::string, GLint> uniformLocations;
+
+	// queries all active uniforms of the linked program once
+	// ------------------------------------------------------------------------
+	void reflectUniforms()
+	{
+		GLint numUniforms = 0;
+		GLint maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<GLchar> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+		for (GLint i = 0; i < numUniforms; i++)
+		{
+			GLsizei nameLength = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &nameLength, &size, &type, nameBuffer.data());
+			std::string name(nameBuffer.data(), nameLength);
+			// members of uniform blocks have no location, they are set through uniform buffers
+			const GLint location = glGetUniformLocation(ID, name.c_str());
+			if (location == -1)
+				continue;
+			uniformLocations[name] = location;
+			// arrays are reported as "name[0]", make them reachable by plain name as well
+			const auto bracket = name.find("[0]");
+			if (bracket != std::string::npos && bracket + 3 == name.size())
+				uniformLocations[name.substr(0, bracket)] = location;
+		}
+	}
+
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
@@ -191,124 +276,3 @@ private:
 	}
 };
 #endif
-//#ifndef SHADER_H
-//#define SHADER_H
-//
-//#include <glad/glad.h>
-//
-//#include <string>
-//#include <fstream>
-//#include <sstream>
-//#include <iostream>
-//
-//class Shader
-//{
-//public:
-//	unsigned int ID;
-//	// constructor generates the shader on the fly
-//	// ------------------------------------------------------------------------
-//	Shader(const char* vertexPath, const char* fragmentPath)
-//	{
-//		// 1. retrieve the vertex/fragment source code from filePath
-//		std::string vertexCode;
-//		std::string fragmentCode;
-//		std::ifstream vShaderFile;
-//		std::ifstream fShaderFile;
-//		// ensure ifstream objects can throw exceptions:
-//		vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-//		fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-//		try
-//		{
-//			// open files
-//			vShaderFile.open(vertexPath);
-//			fShaderFile.open(fragmentPath);
-//			std::stringstream vShaderStream, fShaderStream;
-//			// read file's buffer contents into streams
-//			vShaderStream << vShaderFile.rdbuf();
-//			fShaderStream << fShaderFile.rdbuf();
-//			// close file handlers
-//			vShaderFile.close();
-//			fShaderFile.close();
-//			// convert stream into string
-//			vertexCode = vShaderStream.str();
-//			fragmentCode = fShaderStream.str();
-//		}
-//		catch (std::ifstream::failure& e)
-//		{
-//			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-//		}
-//		const char* vShaderCode = vertexCode.c_str();
-//		const char * fShaderCode = fragmentCode.c_str();
-//		// 2. compile shaders
-//		unsigned int vertex, fragment;
-//		// vertex shader
-//		vertex = glCreateShader(GL_VERTEX_SHADER);
-//		glShaderSource(vertex, 1, &vShaderCode, NULL);
-//		glCompileShader(vertex);
-//		checkCompileErrors(vertex, "VERTEX");
-//		// fragment Shader
-//		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-//		glShaderSource(fragment, 1, &fShaderCode, NULL);
-//		glCompileShader(fragment);
-//		checkCompileErrors(fragment, "FRAGMENT");
-//		// shader Program
-//		ID = glCreateProgram();
-//		glAttachShader(ID, vertex);
-//		glAttachShader(ID, fragment);
-//		glLinkProgram(ID);
-//		checkCompileErrors(ID, "PROGRAM");
-//		// delete the shaders as they're linked into our program now and no longer necessary
-//		glDeleteShader(vertex);
-//		glDeleteShader(fragment);
-//	}
-//	// activate the shader
-//	// ------------------------------------------------------------------------
-//	void use()
-//	{
-//		glUseProgram(ID);
-//	}
-//	// utility uniform functions
-//	// ------------------------------------------------------------------------
-//	void setBool(const std::string &name, bool value) const
-//	{
-//		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
-//	}
-//	// ------------------------------------------------------------------------
-//	void setInt(const std::string &name, int value) const
-//	{
-//		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-//	}
-//	// ------------------------------------------------------------------------
-//	void setFloat(const std::string &name, float value) const
-//	{
-//		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-//	}
-//
-//private:
-//	// utility function for checking shader compilation/linking errors.
-//	// ------------------------------------------------------------------------
-//	void checkCompileErrors(unsigned int shader, std::string type)
-//	{
-//		int success;
-//		char infoLog[1024];
-//		if (type != "PROGRAM")
-//		{
-//			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-//			if (!success)
-//			{
-//				glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-//				std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-//			}
-//		}
-//		else
-//		{
-//			glGetProgramiv(shader, GL_LINK_STATUS, &success);
-//			if (!success)
-//			{
-//				glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-//				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-//			}
-//		}
-//	}
-//};
-//#endif
\ No newline at end of file
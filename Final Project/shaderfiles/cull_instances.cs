@@ -0,0 +1,184 @@
+#version 440 core
+
+// One invocation per object, must match GpuCulling::WORK_GROUP_SIZE
+layout (local_size_x = 64) in;
+
+// Layouts match GeometryArena::DrawElementsIndirectCommand, GpuCulling::GpuObject and GpuCulling::GpuLodChain
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct CullObject
+{
+    mat4 model;
+    vec4 boundsMin; // w is radius of bounding sphere around center of the box
+    vec4 boundsMax;
+    uint lodChain;
+    int materialLayer;
+    uint padding0;
+    uint padding1;
+};
+
+struct CullLodChain
+{
+    uint firstCommand;
+    uint numLevels;
+    float fullDetailScreenRadius;
+    float padding;
+};
+
+layout (std430, binding = 0) readonly buffer Objects { CullObject objects[]; };
+layout (std430, binding = 1) readonly buffer LodChains { CullLodChain lodChains[]; };
+layout (std430, binding = 2) buffer Commands { DrawCommand commands[]; };
+// InstanceBuffer::InstanceData - model matrix, normal matrix and material layer as 26 tightly packed floats
+layout (std430, binding = 3) writeonly buffer Instances { float instances[]; };
+layout (std430, binding = 4) buffer LodLevels { uint lodLevels[]; };
+// GpuCulling::Statistics
+layout (std430, binding = 5) buffer Statistics
+{
+    uint numDrawn;
+    uint numOutsideFrustum;
+    uint numOccluded;
+};
+
+uniform vec4 frustumPlanes[6]; // Planes facing inside (xyz is unit normal, w distance)
+uniform vec3 cameraPosition;
+uniform float pixelsPerUnit;
+uniform bool isPerspective;
+uniform int numObjects;
+
+// Occlusion culling against depth pyramid of occluders (DepthPyramid)
+uniform bool isOcclusionCulling;
+uniform mat4 viewProjection;
+uniform sampler2D depthPyramid;
+
+const float HYSTERESIS = 0.25f; // LodChain::HYSTERESIS
+const uint INSTANCE_SIZE = 26u;
+
+// Object is culled, when its box or its sphere is completely behind one of the planes (as CullingBounds does)
+bool isVisible(vec3 center, vec3 extent, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        vec4 plane = frustumPlanes[i];
+        float distance = dot(plane.xyz, center) + plane.w;
+        if (distance < -radius || distance + dot(abs(plane.xyz), extent) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+// Object is occluded, when the nearest point of its box is behind the farthest occluder in the screen area
+// the box covers. Area is looked up at the level, where it spans at most 2x2 texels.
+bool isOccluded(mat4 modelViewProjection, vec3 boundsMin, vec3 boundsMax)
+{
+    vec3 ndcMin = vec3(1.0e30f);
+    vec3 ndcMax = vec3(-1.0e30f);
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+        vec4 clip = modelViewProjection * vec4(corner, 1.0f);
+        // Box reaching in front of the near plane covers area, which can't be bounded
+        if (clip.z < -clip.w)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    ivec2 size = textureSize(depthPyramid, 0);
+    ivec2 texelMin = min(ivec2(clamp(ndcMin.xy * 0.5f + 0.5f, 0.0f, 1.0f) * vec2(size)), size - 1);
+    ivec2 texelMax = min(ivec2(clamp(ndcMax.xy * 0.5f + 0.5f, 0.0f, 1.0f) * vec2(size)), size - 1);
+    int span = max(texelMax.x - texelMin.x, texelMax.y - texelMin.y) + 1;
+    int level = min(span > 1 ? findMSB(span - 1) + 1 : 0, findMSB(max(size.x, size.y)));
+
+    // Level sizes are halved and rounded down, as DepthPyramid creates them. Last texel of a level covers
+    // also texels beyond its level size (levels halved from odd sizes).
+    ivec2 levelSize = max(size >> level, ivec2(1));
+    ivec2 first = min(texelMin >> level, levelSize - 1);
+    ivec2 last = min(texelMax >> level, levelSize - 1);
+    float occluderDepth = max(max(texelFetch(depthPyramid, first, level).r, texelFetch(depthPyramid, ivec2(last.x, first.y), level).r),
+        max(texelFetch(depthPyramid, ivec2(first.x, last.y), level).r, texelFetch(depthPyramid, last, level).r));
+
+    return ndcMin.z * 0.5f + 0.5f > occluderDepth;
+}
+
+// Same selection as LodChain::selectLevel
+uint selectLevel(CullLodChain lodChain, vec3 center, float radius, uint currentLevel)
+{
+    int maxLevel = int(lodChain.numLevels) - 1;
+    if (maxLevel <= 0)
+        return 0u;
+
+    float screenRadius = radius * pixelsPerUnit;
+    if (isPerspective)
+    {
+        float distance = length(center - cameraPosition);
+        if (distance <= radius)
+            return 0u;
+        screenRadius /= distance;
+    }
+
+    float level = screenRadius > 0.0f ? log2(lodChain.fullDetailScreenRadius / screenRadius) : float(maxLevel);
+    int current = clamp(int(currentLevel), 0, maxLevel);
+    if (level >= current - HYSTERESIS && level < current + 1.0f + HYSTERESIS)
+        return uint(current);
+
+    return uint(clamp(int(floor(level)), 0, maxLevel));
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(numObjects))
+        return;
+
+    CullObject object = objects[index];
+
+    // World space box (center and extent) and sphere, scaled by the longest axis
+    vec3 boxCenter = (object.boundsMin.xyz + object.boundsMax.xyz) * 0.5f;
+    vec3 boxExtent = (object.boundsMax.xyz - object.boundsMin.xyz) * 0.5f;
+    mat3 linear = mat3(object.model);
+    vec3 center = vec3(object.model * vec4(boxCenter, 1.0f));
+    vec3 extent = abs(linear[0]) * boxExtent.x + abs(linear[1]) * boxExtent.y + abs(linear[2]) * boxExtent.z;
+    float maxScale = max(length(linear[0]), max(length(linear[1]), length(linear[2])));
+    float radius = object.boundsMin.w * maxScale;
+
+    if (!isVisible(center, extent, radius))
+    {
+        atomicAdd(numOutsideFrustum, 1u);
+        return;
+    }
+
+    if (isOcclusionCulling && isOccluded(viewProjection * object.model, object.boundsMin.xyz, object.boundsMax.xyz))
+    {
+        atomicAdd(numOccluded, 1u);
+        return;
+    }
+    atomicAdd(numDrawn, 1u);
+
+    CullLodChain lodChain = lodChains[object.lodChain];
+    uint level = selectLevel(lodChain, center, radius, lodLevels[index]);
+    lodLevels[index] = level;
+
+    // Visible objects of one level are packed at the start of the instance range of its command
+    uint command = lodChain.firstCommand + level;
+    uint slot = atomicAdd(commands[command].instanceCount, 1u);
+    uint base = (commands[command].baseInstance + slot) * INSTANCE_SIZE;
+
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+            instances[base + column * 4 + row] = object.model[column][row];
+
+    mat3 normalMatrix = transpose(inverse(linear));
+    for (int column = 0; column < 3; column++)
+        for (int row = 0; row < 3; row++)
+            instances[base + 16 + column * 3 + row] = normalMatrix[column][row];
+
+    instances[base + 25] = intBitsToFloat(object.materialLayer);
+}
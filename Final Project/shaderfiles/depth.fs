@@ -0,0 +1,7 @@
+#version 440 core
+
+// Only depth is written, there are no color outputs
+
+void main()
+{
+}
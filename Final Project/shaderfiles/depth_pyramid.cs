@@ -0,0 +1,37 @@
+#version 440 core
+
+// Must match DepthPyramid::WORK_GROUP_SIZE
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// Level 0 is copied from the depth texture, every next level keeps the farthest depth of the texels it covers
+uniform sampler2D depthTexture;
+layout (r32f, binding = 0) uniform readonly image2D sourceLevel;
+layout (r32f, binding = 1) uniform writeonly image2D destinationLevel;
+
+uniform bool isFirstLevel;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 destinationSize = imageSize(destinationLevel);
+    if (any(greaterThanEqual(texel, destinationSize)))
+        return;
+
+    if (isFirstLevel)
+    {
+        imageStore(destinationLevel, texel, vec4(texelFetch(depthTexture, texel, 0).r));
+        return;
+    }
+
+    // Last texel of a level halved from odd size covers three source texels, so that nothing is skipped
+    ivec2 sourceSize = imageSize(sourceLevel);
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1 + ivec2(equal(texel, destinationSize - 1)) * (sourceSize & 1), sourceSize - 1);
+
+    float depth = 0.0f;
+    for (int y = first.y; y <= last.y; y++)
+        for (int x = first.x; x <= last.x; x++)
+            depth = max(depth, imageLoad(sourceLevel, ivec2(x, y)).r);
+
+    imageStore(destinationLevel, texel, vec4(depth));
+}
@@ -3,8 +3,16 @@
 layout (location = 0) in vec3 position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 objectColor;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 viewPosition;
+};
 
 void main()
 {
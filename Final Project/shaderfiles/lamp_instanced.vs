@@ -0,0 +1,22 @@
+#version 440 core
+
+layout (location = 0) in vec3 position;
+layout (location = 3) in mat4 model; // per instance, occupies locations 3-6
+
+// Depth must match depth prepass (depth_instanced.vs) exactly, as it is tested for equality
+invariant gl_Position;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 objectColor;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 viewPosition;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+}
@@ -3,14 +3,21 @@
 in vec3 vertexNormal;
 in vec3 vertexFragmentPos;
 in vec2 vertexTextureCoordinate;
+flat in int vertexMaterialLayer;
 
 out vec4 fragmentColor;
 
-uniform vec3 objectColor;
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 viewPosition;
-uniform sampler2D uTexture;
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 objectColor;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 viewPosition;
+};
+
+uniform sampler2DArray uTextures; // one layer per material
 
 void main()
 {
@@ -33,7 +40,7 @@ void main()
     vec3 specular = specularIntensity * specularComponent * lightColor;
 
 
-    vec4 textureColor = texture(uTexture, vertexTextureCoordinate);
+    vec4 textureColor = texture(uTextures, vec3(vertexTextureCoordinate, vertexMaterialLayer));
 
     vec3 phong = (ambient + diffuse + specular) * textureColor.xyz;
 
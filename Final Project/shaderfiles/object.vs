@@ -7,18 +7,47 @@ layout (location = 2) in vec3 normal;
 out vec3 vertexNormal;
 out vec3 vertexFragmentPos;
 out vec2 vertexTextureCoordinate;
+flat out int vertexMaterialLayer;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform int materialLayer;
+
+// Compressed vertices (VertexFormat::Compressed) - positions are normalized within mesh bounding box
+// and normals are octahedral-encoded in x and y, float vertices keep the defaults
+uniform vec3 positionScale = vec3(1.0f);
+uniform vec3 positionBias = vec3(0.0f);
+uniform bool octahedralNormals = false;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 objectColor;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 viewPosition;
+};
+
+vec3 decodeOctahedralNormal(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0f);
+    normal.xy += vec2(normal.x >= 0.0f ? -fold : fold, normal.y >= 0.0f ? -fold : fold);
+    return normalize(normal);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
+    vec3 objectPosition = positionBias + positionScale * position;
+    vec3 objectNormal = octahedralNormals ? decodeOctahedralNormal(normal.xy) : normal;
+
+    gl_Position = projection * view * model * vec4(objectPosition, 1.0f);
 
-    vertexFragmentPos = vec3(model * vec4(position, 1.0f));
+    vertexFragmentPos = vec3(model * vec4(objectPosition, 1.0f));
 
-    vertexNormal = mat3(transpose(inverse(model))) * normal;
+    vertexNormal = mat3(transpose(inverse(model))) * objectNormal;
 
     vertexTextureCoordinate = textureCoordinate;
+
+    vertexMaterialLayer = materialLayer;
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#version 440 core 
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 textureCoordinate;
+layout (location = 2) in vec3 normal;
+layout (location = 3) in mat4 model; // per instance, occupies locations 3-6
+layout (location = 7) in mat3 normalMatrix; // per instance, occupies locations 7-9
+layout (location = 10) in int materialLayer; // per instance, layer of material texture array
+
+out vec3 vertexNormal;
+out vec3 vertexFragmentPos;
+out vec2 vertexTextureCoordinate;
+flat out int vertexMaterialLayer;
+
+// Depth must match depth prepass (depth_instanced.vs) exactly, as it is tested for equality
+invariant gl_Position;
+
+layout (std140) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec3 objectColor;
+    vec3 lightColor;
+    vec3 lightPos;
+    vec3 viewPosition;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+
+    vertexFragmentPos = vec3(model * vec4(position, 1.0f));
+
+    vertexNormal = normalMatrix * normal;
+
+    vertexTextureCoordinate = textureCoordinate;
+
+    vertexMaterialLayer = materialLayer;
+}
\ No newline at end of file
@@ -8,11 +8,12 @@
 
 // Project
 #include "sphere.h"
+#include "glStateCache.h"
 
 namespace static_meshes_3D {
 
-    Sphere::Sphere(float radius, int numSlices, int numStacks, bool withPositions, bool withTextureCoordinates, bool withNormals)
-        : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
+    Sphere::Sphere(float radius, int numSlices, int numStacks, bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
+        : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals, isInitializationDeferred)
         , _radius(radius)
         , _numSlices(numSlices)
         , _numStacks(numStacks)
@@ -31,10 +32,10 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
 
-        glEnable(GL_PRIMITIVE_RESTART);
-        glPrimitiveRestartIndex(_primitiveRestartIndex);
+        // Body strips are separated by fixed restart index, which stays enabled (elided after first draw)
+        GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 
         // Render north pole
         glDrawElements(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * _northPoleIndexOffset));
@@ -44,9 +45,31 @@ namespace static_meshes_3D {
 
         // Render south pole 
         glDrawElements(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * _southPoleIndexOffset));
+    }
+
+    void Sphere::renderInstances(GLsizei instanceCount) const
+    {
+        // Body strips are separated by fixed restart index, which stays enabled (elided after first draw)
+        GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+        // Render north pole
+        glDrawElementsInstanced(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * _northPoleIndexOffset), instanceCount);
 
-        // Disable primitive restart, we won't need it now
-        glDisable(GL_PRIMITIVE_RESTART);
+        // Render body
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, _numBodyIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * _bodyIndexOffset), instanceCount);
+
+        // Render south pole
+        glDrawElementsInstanced(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * _southPoleIndexOffset), instanceCount);
+    }
+
+    void Sphere::getTriangleIndices(std::vector<GLuint>& indices) const
+    {
+        const auto sphereIndices = readIndices();
+
+        // Poles are already triangles, body is a restarted triangle strip
+        indices.insert(indices.end(), sphereIndices.begin() + _northPoleIndexOffset, sphereIndices.begin() + _northPoleIndexOffset + _numPoleIndices);
+        appendStripTriangles(sphereIndices.data() + _bodyIndexOffset, _numBodyIndices, _primitiveRestartIndex, indices);
+        indices.insert(indices.end(), sphereIndices.begin() + _southPoleIndexOffset, sphereIndices.begin() + _southPoleIndexOffset + _numPoleIndices);
     }
 
     void Sphere::renderPoints() const
@@ -55,7 +78,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
         glDrawArrays(GL_POINTS, 0, _numVertices);
     }
 
@@ -74,12 +97,8 @@ namespace static_meshes_3D {
         return _numStacks;
     }
 
-    void Sphere::initializeData()
+    void Sphere::generateData()
     {
-        if (_isInitialized) {
-            return;
-        }
-
         // Cache count of vertices
         _numVertices = (_numStacks + 1) * (_numSlices + 1);
 
@@ -96,111 +115,57 @@ namespace static_meshes_3D {
         _bodyIndexOffset = _numPoleIndices;
         _southPoleIndexOffset = _bodyIndexOffset + _numBodyIndices;
 
-        // Finally cache total number of indices and primitive restart index
+        // Finally cache total number of indices
         _numIndices = 2 * _numPoleIndices + _numBodyIndices;
-        _primitiveRestartIndex = _numVertices;
-
-        // Generate VAO and VBOs for vertex attributes and indices
-        glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
-        _vbo.createVBO(getVertexByteSize() * _numVertices);
-        _indicesVBO.createVBO(sizeof(GLuint) * _numIndices);
-
-        // Pre-calculate sines / cosines for given number of slices
-        const auto sliceAngleStep = 2.0f * glm::pi<float>() / static_cast<float>(_numSlices);
-        auto currentSliceAngle = 0.0f;
-        std::vector<float> sliceSines, sliceCosines;
-        for (auto i = 0; i <= _numSlices; i++)
-        {
-            sliceSines.push_back(sin(currentSliceAngle));
-            sliceCosines.push_back(cos(currentSliceAngle));
 
-            // Update slice angle
-            currentSliceAngle += sliceAngleStep;
-        }
+        // Pre-calculate sines / cosines for given number of slices and stacks
+        std::vector<float> sliceSines, sliceCosines, stackSines, stackCosines;
+        vertex_kernels::computeAngleTable(0.0f, 2.0f * glm::pi<float>() / static_cast<float>(_numSlices), _numSlices + 1, sliceSines, sliceCosines);
+        vertex_kernels::computeAngleTable(glm::pi<float>() / 2.0f, -glm::pi<float>() / static_cast<float>(_numStacks), _numStacks + 1, stackSines, stackCosines);
 
-        // Pre-calculate sines / cosines for given number of stacks
-        const auto stackAngleStep = -glm::pi<float>() / static_cast<float>(_numStacks);
-        auto currentStackAngle = glm::pi<float>() / 2.0f;
-        std::vector<float> stackSines, stackCosines;
-        for (auto i = 0; i <= _numStacks; i++)
-        {
-            stackSines.push_back(sin(currentStackAngle));
-            stackCosines.push_back(cos(currentStackAngle));
+        // There are many options out there to generate sphere texture coordinates
+        // I have commented out some others here that work, some better, some worse
+        // You can try them all out :)
 
-            // Update stack angle
-            currentStackAngle += stackAngleStep;
-        }
+        // float u = atan2(x, z) / (2.0f * glm::pi<float>());
+        // float v = asin(y) / glm::pi<float>();
 
-        // Generate sphere vertex positions
-        if (hasPositions())
-        {
-            for (auto i = 0; i <= _numStacks; i++)
-            {
-                for (auto j = 0; j <= _numSlices; j++)
-                {
-                    const auto x = _radius * stackCosines[i] * sliceCosines[j];
-                    const auto y = _radius * stackSines[i];
-                    const auto z = _radius * stackCosines[i] * sliceSines[j];
-                    _vbo.addData(glm::vec3(x, y, z));
-                }
-            }
-        }
+        // float u = 0.5f + asin(x) / glm::pi<float>();
+        // float v = 0.5f + asin(y) / glm::pi<float>();
 
-        // Generate sphere texture coordinates
-        if (hasTextureCoordinates())
-        {
-            for (auto i = 0; i <= _numStacks; i++)
-            {
-                for (auto j = 0; j <= _numSlices; j++)
-                {
-                    const auto x = stackCosines[i] * sliceCosines[j];
-                    const auto y = stackSines[i];
-                    const auto z = stackCosines[i] * sliceSines[j];
-
-                    // There are many options out there to generate sphere texture coordinates
-                    // I have commented out some others here that work, some better, some worse
-                    // You can try them all out :)
+        // float u = 0.5f + x * 0.5f;
+        // float v = 0.5f + y * 0.5f;
 
-                    // float u = atan2(x, z) / (2.0f * glm::pi<float>());
-                    // float v = asin(y) / glm::pi<float>();
+        // Texture coordinate U doesn't depend on stack, so it's the same for every row
+        VertexRow row(_numSlices + 1);
+        vertex_kernels::ramp(1.0f, -1.0f / _numSlices, row.textureU.data(), row.size);
 
-                    // float u = 0.5f + asin(x) / glm::pi<float>();
-                    // float v = 0.5f + asin(y) / glm::pi<float>();
-
-                    // float u = 0.5f + x * 0.5f;
-                    // float v = 0.5f + y * 0.5f;
+        // Generate sphere vertices row by row (one row per stack), vertex kernels compute the whole row at once
+        VertexWriter vertexWriter(*this, _numVertices, glm::vec3(-_radius), glm::vec3(_radius));
+        for (auto i = 0; i <= _numStacks; i++)
+        {
+            // Normal is the point on unit sphere, position is just scaled by radius
+            vertex_kernels::affine(sliceCosines.data(), stackCosines[i], 0.0f, row.normalX.data(), row.size);
+            vertex_kernels::fill(stackSines[i], row.normalY.data(), row.size);
+            vertex_kernels::affine(sliceSines.data(), stackCosines[i], 0.0f, row.normalZ.data(), row.size);
 
-                    const auto u = 1.0f - static_cast<float>(j) / _numSlices;
-                    const auto v = 1.0f - static_cast<float>(i) / _numStacks;
-                    _vbo.addData(glm::vec2(u, v));
-                }
-            }
-        }
+            vertex_kernels::affine(sliceCosines.data(), _radius * stackCosines[i], 0.0f, row.positionX.data(), row.size);
+            vertex_kernels::fill(_radius * stackSines[i], row.positionY.data(), row.size);
+            vertex_kernels::affine(sliceSines.data(), _radius * stackCosines[i], 0.0f, row.positionZ.data(), row.size);
 
-        // Generate sphere normals
-        if (hasNormals())
-        {
-            for (auto i = 0; i <= _numStacks; i++)
-            {
-                for (auto j = 0; j <= _numSlices; j++)
-                {
-                    const auto x = stackCosines[i] * sliceCosines[j];
-                    const auto y = stackSines[i];
-                    const auto z = stackCosines[i] * sliceSines[j];
-                    _vbo.addData(glm::vec3(x, y, z));
-                }
-            }
+            vertex_kernels::fill(1.0f - static_cast<float>(i) / _numStacks, row.textureV.data(), row.size);
+            vertexWriter.writeRow(row);
         }
 
         // Now that we have all vertex data, generate indices for north pole (triangles)
+        auto index = _indicesVBO.reserveVertices<GLuint>(_numIndices).begin();
         for (auto i = 0; i < _numSlices; i++)
         {
             GLuint sliceIndex = i;
             GLuint nextSliceIndex = sliceIndex + _numSlices + 1;
-            _indicesVBO.addData(static_cast<GLuint>(sliceIndex));
-            _indicesVBO.addData(static_cast<GLuint>(nextSliceIndex));
-            _indicesVBO.addData(static_cast<GLuint>(nextSliceIndex + 1));
+            *index++ = sliceIndex;
+            *index++ = nextSliceIndex;
+            *index++ = nextSliceIndex + 1;
         }
 
         // Then for body (triangle strip)
@@ -210,15 +175,15 @@ namespace static_meshes_3D {
             // Primitive restart triangle strip from second body stack on
             if (i > 0)
             {
-                _indicesVBO.addData(_primitiveRestartIndex);
+                *index++ = _primitiveRestartIndex;
             }
 
             for (auto j = 0; j <= _numSlices; j++)
             {
                 GLuint sliceIndex = currentVertexIndex + j;
                 GLuint nextSliceIndex = currentVertexIndex + _numSlices + 1 + j;
-                _indicesVBO.addData(sliceIndex);
-                _indicesVBO.addData(nextSliceIndex);
+                *index++ = sliceIndex;
+                *index++ = nextSliceIndex;
             }
 
             currentVertexIndex += _numSlices + 1;
@@ -230,19 +195,10 @@ namespace static_meshes_3D {
         {
             GLuint sliceIndex = beforeLastStackIndexOffset + i;
             GLuint nextSliceIndex = sliceIndex + _numSlices + 1;
-            _indicesVBO.addData(static_cast<GLuint>(sliceIndex));
-            _indicesVBO.addData(static_cast<GLuint>(sliceIndex + 1));
-            _indicesVBO.addData(static_cast<GLuint>(nextSliceIndex));
+            *index++ = sliceIndex;
+            *index++ = sliceIndex + 1;
+            *index++ = nextSliceIndex;
         }
-
-        _vbo.bindVBO();
-        _vbo.uploadDataToGPU(GL_STATIC_DRAW);
-        setVertexAttributesPointers(_numVertices);
-
-        _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
-        _indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
-
-        _isInitialized = true;
     }
 
 } // namespace static_meshes_3D
\ No newline at end of file
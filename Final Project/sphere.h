@@ -11,7 +11,7 @@ namespace static_meshes_3D {
     class Sphere : public StaticMeshIndexed3D
     {
     public:
-        Sphere(float radius, int numSlices, int numStacks, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+        Sphere(float radius, int numSlices, int numStacks, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true, bool isInitializationDeferred = false);
 
         void render() const override;
         void renderPoints() const override;
@@ -43,7 +43,9 @@ namespace static_meshes_3D {
         GLuint _bodyIndexOffset; // Index offset to render body
         GLuint _southPoleIndexOffset; // Index offset to render south pole
 
-        void initializeData() override;
+        void generateData() override;
+        void renderInstances(GLsizei instanceCount) const override;
+        void getTriangleIndices(std::vector<GLuint>& indices) const override;
     };
 
 } // namespace static_meshes_3D
\ No newline at end of file
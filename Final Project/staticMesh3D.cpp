@@ -1,4 +1,8 @@
 #include "common/staticMesh3D.h"
+#include "glStateCache.h"
+
+#include <cmath>
+#include <cstring>
 
 #include <glm/glm.hpp>
 
@@ -8,16 +12,40 @@ const int StaticMesh3D::POSITION_ATTRIBUTE_INDEX           = 0;
 const int StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
 const int StaticMesh3D::NORMAL_ATTRIBUTE_INDEX             = 2;
 
-StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
+VertexLayout StaticMesh3D::_defaultVertexLayout = VertexLayout::Interleaved;
+VertexFormat StaticMesh3D::_defaultVertexFormat = VertexFormat::Float;
+
+StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
 	: _hasPositions(withPositions)
 	, _hasTextureCoordinates(withTextureCoordinates)
-	, _hasNormals(withNormals) {}
+	, _hasNormals(withNormals)
+	, _vertexLayout(_defaultVertexLayout)
+	, _vertexFormat(_defaultVertexFormat)
+	, _isInitializationDeferred(isInitializationDeferred) {}
 
 StaticMesh3D::~StaticMesh3D()
 {
 	deleteMesh();
 }
 
+void StaticMesh3D::renderInstanced(const InstanceBuffer& instanceBuffer, GLsizei instanceCount) const
+{
+	if (!_isInitialized) {
+		return;
+	}
+
+	GLStateCache::getInstance().bindVertexArray(_vao);
+
+	// Attach instance attributes to our VAO only when instance buffer changes
+	if (_instanceBufferID != instanceBuffer.getBufferID())
+	{
+		instanceBuffer.setVertexAttributesPointers();
+		_instanceBufferID = instanceBuffer.getBufferID();
+	}
+
+	renderInstances(instanceCount);
+}
+
 void StaticMesh3D::deleteMesh()
 {
 	if (!_isInitialized) {
@@ -25,11 +53,60 @@ void StaticMesh3D::deleteMesh()
 	}
 
 	glDeleteVertexArrays(1, &_vao);
+	GLStateCache::getInstance().onVertexArrayDeleted(_vao);
 	_vbo.deleteVBO();
+	_instanceBufferID = 0;
 
 	_isInitialized = false;
 }
 
+void StaticMesh3D::generate()
+{
+	if (_isGenerated || _isInitialized) {
+		return;
+	}
+
+	generateData();
+	_isGenerated = true;
+}
+
+void StaticMesh3D::upload()
+{
+	if (_isInitialized) {
+		return;
+	}
+
+	generate();
+	uploadData();
+	_isGenerated = false;
+	_isInitialized = true;
+}
+
+bool StaticMesh3D::isInitialized() const
+{
+	return _isInitialized;
+}
+
+void StaticMesh3D::initializeData()
+{
+	if (_isInitializationDeferred) {
+		return;
+	}
+
+	upload();
+}
+
+void StaticMesh3D::uploadData()
+{
+	glGenVertexArrays(1, &_vao);
+	GLStateCache::getInstance().bindVertexArray(_vao);
+
+	// Buffer object is created only now, its data have been gathered in memory by generateData
+	_vbo.createVBO();
+	_vbo.uploadDataToGPUShared(GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+	setVertexAttributesPointers(_numBufferVertices);
+}
+
 bool StaticMesh3D::hasPositions() const
 {
 	return _hasPositions;
@@ -45,48 +122,317 @@ bool StaticMesh3D::hasNormals() const
 	return _hasNormals;
 }
 
+VertexLayout StaticMesh3D::getVertexLayout() const
+{
+	return _vertexLayout;
+}
+
+void StaticMesh3D::setDefaultVertexLayout(VertexLayout vertexLayout)
+{
+	_defaultVertexLayout = vertexLayout;
+}
+
+VertexLayout StaticMesh3D::getDefaultVertexLayout()
+{
+	return _defaultVertexLayout;
+}
+
+VertexFormat StaticMesh3D::getVertexFormat() const
+{
+	return _vertexFormat;
+}
+
+void StaticMesh3D::setDefaultVertexFormat(VertexFormat vertexFormat)
+{
+	_defaultVertexFormat = vertexFormat;
+}
+
+VertexFormat StaticMesh3D::getDefaultVertexFormat()
+{
+	return _defaultVertexFormat;
+}
+
+const glm::vec3& StaticMesh3D::getBoundsMin() const
+{
+	return _boundsMin;
+}
+
+const glm::vec3& StaticMesh3D::getBoundsMax() const
+{
+	return _boundsMax;
+}
+
+glm::vec3 StaticMesh3D::getBoundingSphereCenter() const
+{
+	return (_boundsMin + _boundsMax) * 0.5f;
+}
+
+float StaticMesh3D::getBoundingSphereRadius() const
+{
+	return _boundingSphereRadius;
+}
+
+glm::vec3 StaticMesh3D::getPositionScale() const
+{
+	return _vertexFormat == VertexFormat::Compressed ? _boundsMax - _boundsMin : glm::vec3(1.0f);
+}
+
+glm::vec3 StaticMesh3D::getPositionBias() const
+{
+	return _vertexFormat == VertexFormat::Compressed ? _boundsMin : glm::vec3(0.0f);
+}
+
+uint32_t StaticMesh3D::getVertexBufferByteSize() const
+{
+	return _vbo.getBufferSize();
+}
+
 int StaticMesh3D::getVertexByteSize() const
 {
+	AttributeLayout attributeLayouts[3];
+	getAttributeLayouts(0, attributeLayouts);
+
 	int result = 0;
-	if (hasPositions()) {
-		result += sizeof(glm::vec3);
+	for (const auto& attributeLayout : attributeLayouts)
+	{
+		if (attributeLayout.isPresent) {
+			result += static_cast<int>(attributeLayout.size);
+		}
 	}
-	if (hasTextureCoordinates()) {
-		result += sizeof(glm::vec2);
+
+	return result;
+}
+
+void StaticMesh3D::getTriangleList(MeshData& meshData) const
+{
+	meshData.vertices.clear();
+	meshData.indices.clear();
+	if (!_isInitialized && !_isGenerated) {
+		return;
 	}
-	if (hasNormals()) {
-		result += sizeof(glm::vec3);
+
+	// Generated data are read straight from memory, uploaded vertex buffer is shared
+	// through the geometry store, so this doesn't read from the GPU either
+	std::vector<unsigned char> uploadedData;
+	auto rawData = static_cast<const unsigned char*>(_vbo.getRawDataPointer());
+	if (!_isGenerated)
+	{
+		uploadedData = _vbo.getUploadedData();
+		rawData = uploadedData.data();
 	}
 
-	return result;
+	AttributeLayout attributeLayouts[3];
+	getAttributeLayouts(_numBufferVertices, attributeLayouts);
+
+	meshData.vertices.resize(_numBufferVertices, MeshVertex{ glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(0.0f) });
+	const auto isCompressed = _vertexFormat == VertexFormat::Compressed;
+	const auto positionScale = getPositionScale();
+	const auto& positionLayout = attributeLayouts[POSITION_ATTRIBUTE_INDEX];
+	if (positionLayout.isPresent)
+	{
+		for (auto i = 0; i < _numBufferVertices; i++)
+		{
+			const auto source = rawData + positionLayout.offset + positionLayout.stride*i;
+			if (isCompressed)
+			{
+				vertex_compression::EncodedPosition encodedPosition;
+				memcpy(&encodedPosition, source, sizeof(encodedPosition));
+				meshData.vertices[i].position = vertex_compression::decodePosition(encodedPosition, _boundsMin, positionScale);
+			}
+			else {
+				memcpy(&meshData.vertices[i].position, source, sizeof(glm::vec3));
+			}
+		}
+	}
+
+	const auto& textureCoordinateLayout = attributeLayouts[TEXTURE_COORDINATE_ATTRIBUTE_INDEX];
+	if (textureCoordinateLayout.isPresent)
+	{
+		for (auto i = 0; i < _numBufferVertices; i++)
+		{
+			const auto source = rawData + textureCoordinateLayout.offset + textureCoordinateLayout.stride*i;
+			if (isCompressed)
+			{
+				uint32_t encodedTextureCoordinate;
+				memcpy(&encodedTextureCoordinate, source, sizeof(encodedTextureCoordinate));
+				meshData.vertices[i].textureCoordinate = vertex_compression::decodeTextureCoordinate(encodedTextureCoordinate);
+			}
+			else {
+				memcpy(&meshData.vertices[i].textureCoordinate, source, sizeof(glm::vec2));
+			}
+		}
+	}
+
+	const auto& normalLayout = attributeLayouts[NORMAL_ATTRIBUTE_INDEX];
+	if (normalLayout.isPresent)
+	{
+		for (auto i = 0; i < _numBufferVertices; i++)
+		{
+			const auto source = rawData + normalLayout.offset + normalLayout.stride*i;
+			if (isCompressed)
+			{
+				uint32_t encodedNormal;
+				memcpy(&encodedNormal, source, sizeof(encodedNormal));
+				meshData.vertices[i].normal = vertex_compression::decodeNormal(encodedNormal);
+			}
+			else {
+				memcpy(&meshData.vertices[i].normal, source, sizeof(glm::vec3));
+			}
+		}
+	}
+
+	getTriangleIndices(meshData.indices);
 }
 
-void StaticMesh3D::setVertexAttributesPointers(int numVertices)
+void StaticMesh3D::appendStripTriangles(const GLuint* stripIndices, size_t numStripIndices, GLuint restartIndex, std::vector<GLuint>& indices)
 {
-	uint64_t offset = 0;
-	if (hasPositions())
+	// Index of the first vertex of current strip, strips are restarted at every restart index
+	size_t stripStart = 0;
+	for (size_t i = 0; i < numStripIndices; i++)
 	{
-		glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+		if (stripIndices[i] == restartIndex)
+		{
+			stripStart = i + 1;
+			continue;
+		}
+
+		const auto positionInStrip = i - stripStart;
+		if (positionInStrip < 2) {
+			continue;
+		}
 
-		offset += sizeof(glm::vec3)*numVertices;
+		const auto a = stripIndices[i - 2];
+		const auto b = stripIndices[i - 1];
+		const auto c = stripIndices[i];
+		if (a == b || b == c || a == c) {
+			continue; // degenerate triangle
+		}
+
+		// Every odd triangle of a strip has opposite winding
+		if (positionInStrip % 2 == 0)
+		{
+			indices.push_back(a);
+			indices.push_back(b);
+		}
+		else
+		{
+			indices.push_back(b);
+			indices.push_back(a);
+		}
+		indices.push_back(c);
 	}
+}
 
-	if (hasTextureCoordinates())
+void StaticMesh3D::appendStripTriangles(GLuint firstVertex, GLuint numVertices, std::vector<GLuint>& indices)
+{
+	std::vector<GLuint> stripIndices(numVertices);
+	for (GLuint i = 0; i < numVertices; i++) {
+		stripIndices[i] = firstVertex + i;
+	}
+
+	appendStripTriangles(stripIndices.data(), stripIndices.size(), static_cast<GLuint>(-1), indices);
+}
+
+void StaticMesh3D::appendFanTriangles(GLuint firstVertex, GLuint numVertices, std::vector<GLuint>& indices)
+{
+	for (GLuint i = 2; i < numVertices; i++)
 	{
-		glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(offset));
+		indices.push_back(firstVertex);
+		indices.push_back(firstVertex + i - 1);
+		indices.push_back(firstVertex + i);
+	}
+}
 
-		offset += sizeof(glm::vec2)*numVertices;
+void StaticMesh3D::getAttributeLayouts(int numVertices, AttributeLayout attributeLayouts[3]) const
+{
+	const bool isPresent[3] = { hasPositions(), hasTextureCoordinates(), hasNormals() };
+	if (_vertexFormat == VertexFormat::Compressed)
+	{
+		// Position has padding component, so that all attributes stay 4-byte aligned
+		attributeLayouts[POSITION_ATTRIBUTE_INDEX] = { isPresent[0], 0, 0, sizeof(vertex_compression::EncodedPosition), 3, GL_UNSIGNED_SHORT, GL_TRUE };
+		attributeLayouts[TEXTURE_COORDINATE_ATTRIBUTE_INDEX] = { isPresent[1], 0, 0, sizeof(uint32_t), 2, GL_HALF_FLOAT, GL_FALSE };
+		attributeLayouts[NORMAL_ATTRIBUTE_INDEX] = { isPresent[2], 0, 0, sizeof(uint32_t), 4, GL_INT_2_10_10_10_REV, GL_TRUE };
 	}
+	else
+	{
+		attributeLayouts[POSITION_ATTRIBUTE_INDEX] = { isPresent[0], 0, 0, sizeof(glm::vec3), 3, GL_FLOAT, GL_FALSE };
+		attributeLayouts[TEXTURE_COORDINATE_ATTRIBUTE_INDEX] = { isPresent[1], 0, 0, sizeof(glm::vec2), 2, GL_FLOAT, GL_FALSE };
+		attributeLayouts[NORMAL_ATTRIBUTE_INDEX] = { isPresent[2], 0, 0, sizeof(glm::vec3), 3, GL_FLOAT, GL_FALSE };
+	}
+
+	size_t vertexByteSize = 0;
+	for (auto i = 0; i < 3; i++)
+	{
+		if (isPresent[i]) {
+			vertexByteSize += attributeLayouts[i].size;
+		}
+	}
+
+	// Interleaved attributes follow each other within a vertex, planar ones within the buffer
+	const auto isInterleaved = _vertexLayout == VertexLayout::Interleaved;
+	size_t offset = 0;
+	for (auto i = 0; i < 3; i++)
+	{
+		attributeLayouts[i].offset = offset;
+		attributeLayouts[i].stride = isInterleaved ? vertexByteSize : attributeLayouts[i].size;
+		if (isPresent[i]) {
+			offset += isInterleaved ? attributeLayouts[i].size : attributeLayouts[i].size * numVertices;
+		}
+	}
+}
 
-	if (hasNormals())
+void StaticMesh3D::setVertexAttributesPointers(int numVertices)
+{
+	_numBufferVertices = numVertices;
+
+	AttributeLayout attributeLayouts[3];
+	getAttributeLayouts(numVertices, attributeLayouts);
+
+	for (auto i = 0; i < 3; i++)
 	{
-		glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
-		glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+		const auto& attributeLayout = attributeLayouts[i];
+		if (!attributeLayout.isPresent) {
+			continue;
+		}
+
+		glEnableVertexAttribArray(i);
+		glVertexAttribPointer(i, attributeLayout.numComponents, attributeLayout.type, attributeLayout.isNormalized,
+			static_cast<GLsizei>(attributeLayout.stride), reinterpret_cast<void*>(attributeLayout.offset));
+	}
+}
+
+StaticMesh3D::VertexWriter::VertexWriter(StaticMesh3D& mesh, int numVertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+	: _isCompressed(mesh._vertexFormat == VertexFormat::Compressed)
+	, _boundsMin(boundsMin)
+	, _mesh(mesh)
+	, _sphereCenter((boundsMin + boundsMax) * 0.5f)
+{
+	mesh._boundsMin = boundsMin;
+	mesh._boundsMax = boundsMax;
+	mesh._numBufferVertices = numVertices;
 
-		offset += sizeof(glm::vec3)*numVertices;
+	// Flat dimensions of the box quantize to zero
+	const auto extent = boundsMax - boundsMin;
+	for (auto i = 0; i < 3; i++) {
+		_inverseScale[i] = extent[i] > 0.0f ? 1.0f / extent[i] : 0.0f;
 	}
+
+	auto data = static_cast<unsigned char*>(mesh._vbo.reserveRawData(mesh.getVertexByteSize() * numVertices));
+
+	AttributeLayout attributeLayouts[3];
+	mesh.getAttributeLayouts(numVertices, attributeLayouts);
+
+	AttributeCursor* cursors[3] = { &_positions, &_textureCoordinates, &_normals };
+	for (auto i = 0; i < 3; i++)
+	{
+		cursors[i]->destination = attributeLayouts[i].isPresent ? data + attributeLayouts[i].offset : nullptr;
+		cursors[i]->stride = attributeLayouts[i].stride;
+	}
+}
+
+StaticMesh3D::VertexWriter::~VertexWriter()
+{
+	_mesh._boundingSphereRadius = std::sqrt(_maxDistanceSquared);
 }
 
-} // namespace static_meshes_3D
\ No newline at end of file
+} // namespace static_meshes_3D
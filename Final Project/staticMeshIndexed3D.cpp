@@ -1,9 +1,13 @@
+#include <cstring>
+
 #include "common/staticMeshIndexed3D.h"
 
 namespace static_meshes_3D {
 
-StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
-	: StaticMesh3D(withPositions, withTextureCoordinates, withNormals) {}
+const GLuint StaticMeshIndexed3D::PRIMITIVE_RESTART_INDEX = 0xFFFFFFFF;
+
+StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
+	: StaticMesh3D(withPositions, withTextureCoordinates, withNormals, isInitializationDeferred) {}
 
 StaticMeshIndexed3D::~StaticMeshIndexed3D()
 {
@@ -21,4 +25,31 @@ void StaticMeshIndexed3D::deleteMesh()
 	}
 }
 
+void StaticMeshIndexed3D::uploadData()
+{
+	StaticMesh3D::uploadData();
+
+	// VAO is still bound, so element buffer binding gets stored in it
+	_indicesVBO.createVBO();
+	_indicesVBO.uploadDataToGPUShared(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+}
+
+std::vector<GLuint> StaticMeshIndexed3D::readIndices() const
+{
+	// Generated indices haven't left the in-memory buffer yet
+	if (_isGenerated)
+	{
+		const auto rawData = static_cast<const GLuint*>(_indicesVBO.getRawDataPointer());
+		return std::vector<GLuint>(rawData, rawData + _indicesVBO.getBufferSize() / sizeof(GLuint));
+	}
+
+	const auto rawData = _indicesVBO.getUploadedData();
+	std::vector<GLuint> indices(rawData.size() / sizeof(GLuint));
+	if (!indices.empty()) {
+		memcpy(indices.data(), rawData.data(), indices.size() * sizeof(GLuint));
+	}
+
+	return indices;
+}
+
 } // namespace static_meshes_3D
\ No newline at end of file
@@ -0,0 +1,105 @@
+// STL
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <vector>
+
+// Project
+#include "textureBaker.h"
+#include "bakedTexture.h"
+#include "imageUtils.h"
+#include "threadPool.h"
+#include "stb_image.h"
+
+using namespace block_compression;
+
+namespace texture_baker {
+
+    bool bakeTexture(const std::string& imagePath, BlockFormat format, int width, int height)
+    {
+        auto pixels = image_utils::loadImage(imagePath, width, height);
+        if (pixels.empty()) {
+            return false;
+        }
+
+        const auto numMipLevels = image_utils::getNumMipLevels(width, height);
+        std::vector<std::vector<uint8_t>> mipLevels;
+        mipLevels.reserve(numMipLevels);
+        for (auto level = 0; level < numMipLevels; level++)
+        {
+            const auto levelWidth = std::max(1, width >> level);
+            const auto levelHeight = std::max(1, height >> level);
+            mipLevels.push_back(compressImage(format, pixels.data(), levelWidth, levelHeight));
+            if (level + 1 < numMipLevels) {
+                pixels = image_utils::downsampleImage(pixels.data(), levelWidth, levelHeight);
+            }
+        }
+
+        return BakedTexture::write(BakedTexture::getBakedPath(imagePath), format, width, height, mipLevels);
+    }
+
+    int run(int argc, char* argv[])
+    {
+        auto format = BlockFormat::BC7;
+        auto width = 1024;
+        auto height = 1024;
+        std::vector<std::string> imagePaths;
+        for (auto i = 0; i < argc; i++)
+        {
+            if (strcmp(argv[i], "bc1") == 0) {
+                format = BlockFormat::BC1;
+            }
+            else if (strcmp(argv[i], "bc3") == 0) {
+                format = BlockFormat::BC3;
+            }
+            else if (strcmp(argv[i], "bc7") == 0) {
+                format = BlockFormat::BC7;
+            }
+            else if (strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+            {
+                width = atoi(argv[++i]);
+                height = atoi(argv[++i]);
+            }
+            else {
+                imagePaths.push_back(argv[i]);
+            }
+        }
+
+        if (imagePaths.empty() || width <= 0 || height <= 0)
+        {
+            std::cout << "Usage: " << BAKE_OPTION << " [bc1|bc3|bc7] [--size <width> <height>] image..." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Same orientation as images decoded at runtime
+        stbi_set_flip_vertically_on_load(true);
+
+        // Images are independent, every one is baked on its own worker
+        static_meshes_3D::ThreadPool threadPool;
+        std::vector<std::future<bool>> results;
+        for (const auto& imagePath : imagePaths)
+        {
+            results.push_back(threadPool.enqueue([imagePath, format, width, height]() {
+                return bakeTexture(imagePath, format, width, height);
+            }));
+        }
+
+        auto exitCode = EXIT_SUCCESS;
+        for (size_t i = 0; i < imagePaths.size(); i++)
+        {
+            if (results[i].get()) {
+                std::cout << "Baked " << BakedTexture::getBakedPath(imagePaths[i]) << std::endl;
+            }
+            else
+            {
+                std::cout << "Failed to bake texture " << imagePaths[i] << std::endl;
+                exitCode = EXIT_FAILURE;
+            }
+        }
+
+        return exitCode;
+    }
+
+} // namespace texture_baker
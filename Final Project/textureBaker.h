@@ -0,0 +1,39 @@
+#pragma once
+
+// STL
+#include <string>
+
+// Project
+#include "blockCompression.h"
+
+/**
+ * Offline baking of material images into block-compressed .ctex files (see BakedTexture).
+ * Images are resampled to layer size of the material library, full mip chain is generated
+ * on the CPU and every level is compressed, so that nothing is decoded at runtime.
+ */
+namespace texture_baker {
+
+    /**
+     * Command line option, which runs the baker instead of the application.
+     */
+    static const char BAKE_OPTION[] = "--bake-textures";
+
+    /**
+     * Bakes one image to BakedTexture::getBakedPath(imagePath).
+     *
+     * @param imagePath  Path to the source image
+     * @param format     Block format to compress to
+     * @param width      Width of baked texture (material library layer width)
+     * @param height     Height of baked texture (material library layer height)
+     */
+    bool bakeTexture(const std::string& imagePath, block_compression::BlockFormat format, int width, int height);
+
+    /**
+     * Runs baker with command line arguments following BAKE_OPTION:
+     * [bc1|bc3|bc7] [--size <width> <height>] image...
+     *
+     * @return Process exit code.
+     */
+    int run(int argc, char* argv[]);
+
+} // namespace texture_baker
@@ -0,0 +1,60 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "threadPool.h"
+
+namespace static_meshes_3D {
+
+    ThreadPool::ThreadPool(size_t numThreads)
+    {
+        if (numThreads == 0) {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (size_t i = 0; i < numThreads; i++) {
+            _workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+
+        _condition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::getNumThreads() const
+    {
+        return _workers.size();
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+
+                // Queued tasks are finished even when stopping
+                if (_tasks.empty()) {
+                    return;
+                }
+
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+
+            task();
+        }
+    }
+
+} // namespace static_meshes_3D
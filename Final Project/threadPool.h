@@ -0,0 +1,71 @@
+#pragma once
+
+// STL
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace static_meshes_3D {
+
+    /**
+     * Fixed set of worker threads executing queued tasks. Every enqueued task returns a future,
+     * through which its result (or exception) is obtained.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * Starts worker threads.
+         *
+         * @param numThreads  Number of worker threads (0 = number of hardware threads)
+         */
+        explicit ThreadPool(size_t numThreads = 0);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Finishes all queued tasks and stops worker threads.
+         */
+        ~ThreadPool();
+
+        /**
+         * Queues task for execution on one of worker threads.
+         *
+         * @return Future holding result of the task.
+         */
+        template<typename Function>
+        auto enqueue(Function&& function) -> std::future<decltype(function())>
+        {
+            using Result = decltype(function());
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+            auto future = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _tasks.emplace([task]() { (*task)(); });
+            }
+
+            _condition.notify_one();
+            return future;
+        }
+
+        /**
+         * Gets number of worker threads.
+         */
+        size_t getNumThreads() const;
+
+    private:
+        std::vector<std::thread> _workers; // Worker threads
+        std::queue<std::function<void()>> _tasks; // Tasks waiting for execution
+        std::mutex _mutex; // Guards tasks and stopping flag
+        std::condition_variable _condition; // Signals new tasks or stopping
+        bool _isStopping = false; // Flag telling, if workers should finish
+
+        void workerLoop();
+    };
+
+} // namespace static_meshes_3D
@@ -1,13 +1,17 @@
+// STL
+#include <vector>
+
 // GLM
 #include <glm/glm.hpp>
 
 // Project
 #include "torus.h"
+#include "glStateCache.h"
 
 namespace static_meshes_3D {
 
-    Torus::Torus(int stacks, int slices, float radius, float tubeRadius, bool withPositions, bool withTextureCoordinates, bool withNormals)
-        : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
+    Torus::Torus(int stacks, int slices, float radius, float tubeRadius, bool withPositions, bool withTextureCoordinates, bool withNormals, bool isInitializationDeferred)
+        : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals, isInitializationDeferred)
         , _mainSegments(stacks)
         , _tubeSegments(slices)
         , _mainRadius(radius)
@@ -16,142 +20,65 @@ namespace static_meshes_3D {
         initializeData();
     }
 
-    void Torus::initializeData()
+    void Torus::generateData()
     {
-        if (_isInitialized) {
-            return;
-        }
-
         // Calculate and cache counts of vertices and indices
         _numVertices = (_mainSegments + 1) * (_tubeSegments + 1);
-        _primitiveRestartIndex = _numVertices;
         _numIndices = (_mainSegments * 2 * (_tubeSegments + 1)) + _mainSegments - 1;
 
-        // Generate VAO and VBOs for vertex attributes and indices
-        glGenVertexArrays(1, &_vao);
-        glBindVertexArray(_vao);
-        _vbo.createVBO(getVertexByteSize() * _numVertices);
-        _indicesVBO.createVBO(sizeof(GLuint) * _numIndices);
-
         // Precalculate steps in radians for main segment and tube segment
         const auto mainSegmentAngleStep = glm::radians(360.0f / static_cast<float>(_mainSegments));
         const auto tubeSegmentAngleStep = glm::radians(360.0f / static_cast<float>(_tubeSegments));
 
-        if (hasPositions())
+        // Pre-calculate sines / cosines of both main and tube segments, they repeat for every vertex
+        std::vector<float> mainSegmentSines, mainSegmentCosines, tubeSegmentSines, tubeSegmentCosines;
+        vertex_kernels::computeAngleTable(0.0f, mainSegmentAngleStep, _mainSegments + 1, mainSegmentSines, mainSegmentCosines);
+        vertex_kernels::computeAngleTable(0.0f, tubeSegmentAngleStep, _tubeSegments + 1, tubeSegmentSines, tubeSegmentCosines);
+
+        // Precalculate steps in texture coordinates for main segment and tube segment
+        // I have decided to map the texture twice around main segments and once around tube segmens
+        const auto mainSegmentTextureStep = 2.0f / static_cast<float>(_mainSegments);
+        const auto tubeSegmentTextureStep = 1.0f / static_cast<float>(_tubeSegments);
+
+        // Texture coordinate U and position / normal Z depend only on tube segment, so they're the same for every row
+        VertexRow row(_tubeSegments + 1);
+        vertex_kernels::ramp(0.0f, tubeSegmentTextureStep, row.textureU.data(), row.size);
+        vertex_kernels::affine(tubeSegmentSines.data(), _tubeRadius, 0.0f, row.positionZ.data(), row.size);
+        vertex_kernels::affine(tubeSegmentSines.data(), 1.0f, 0.0f, row.normalZ.data(), row.size);
+
+        // Generate torus vertices row by row (one row per main segment), vertex kernels compute the whole row at once
+        const auto outerRadius = _mainRadius + _tubeRadius;
+        VertexWriter vertexWriter(*this, _numVertices, glm::vec3(-outerRadius, -outerRadius, -_tubeRadius), glm::vec3(outerRadius, outerRadius, _tubeRadius));
+        for (auto i = 0; i <= _mainSegments; i++)
         {
-            auto currentMainSegmentAngle = 0.0f;
-            for (auto i = 0; i <= _mainSegments; i++)
-            {
-                // Calculate sine and cosine of main segment angle
-                const auto sinMainSegment = sin(currentMainSegmentAngle);
-                const auto cosMainSegment = cos(currentMainSegmentAngle);
-                auto currentTubeSegmentAngle = 0.0f;
-                for (auto j = 0; j <= _tubeSegments; j++)
-                {
-                    // Calculate sine and cosine of tube segment angle
-                    const auto sinTubeSegment = sin(currentTubeSegmentAngle);
-                    const auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-                    // Calculate vertex position on the surface of torus
-                    auto surfacePosition = glm::vec3(
-                        (_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-                        (_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-                        _tubeRadius * sinTubeSegment);
-
-                    _vbo.addRawData(&surfacePosition, sizeof(glm::vec3));
-
-                    // Update current tube angle
-                    currentTubeSegmentAngle += tubeSegmentAngleStep;
-                }
-
-                // Update main segment angle
-                currentMainSegmentAngle += mainSegmentAngleStep;
-            }
-        }
+            // Position on the surface is (mainRadius + tubeRadius * cos(tube)) * (cos(main), sin(main))
+            vertex_kernels::affine(tubeSegmentCosines.data(), _tubeRadius * mainSegmentCosines[i], _mainRadius * mainSegmentCosines[i], row.positionX.data(), row.size);
+            vertex_kernels::affine(tubeSegmentCosines.data(), _tubeRadius * mainSegmentSines[i], _mainRadius * mainSegmentSines[i], row.positionY.data(), row.size);
 
-        if (hasTextureCoordinates())
-        {
-            // Precalculate steps in texture coordinates for main segment and tube segment
-            // I have decided to map the texture twice around main segments and once around tube segmens
-            const auto mainSegmentTextureStep = 2.0f / static_cast<float>(_mainSegments);
-            const auto tubeSegmentTextureStep = 1.0f / static_cast<float>(_tubeSegments);
+            vertex_kernels::affine(tubeSegmentCosines.data(), mainSegmentCosines[i], 0.0f, row.normalX.data(), row.size);
+            vertex_kernels::affine(tubeSegmentCosines.data(), mainSegmentSines[i], 0.0f, row.normalY.data(), row.size);
 
-            auto currentMainSegmentTexCoordV = 0.0f;
-            for (auto i = 0; i <= _mainSegments; i++)
-            {
-                auto currentTubeSegmentTexCoordU = 0.0f;
-                for (auto j = 0; j <= _tubeSegments; j++)
-                {
-                    // Calculate texture coordinate and add it to the buffer
-                    auto textureCoordinate = glm::vec2(currentTubeSegmentTexCoordU, currentMainSegmentTexCoordV);
-                    _vbo.addRawData(&textureCoordinate, sizeof(glm::vec2));
-                    // Update texture coordinate of tube segment
-                    currentTubeSegmentTexCoordU += tubeSegmentTextureStep;
-                }
-
-                // Update texture coordinate of main segment
-                currentMainSegmentTexCoordV += mainSegmentTextureStep;
-            }
-        }
-
-        if (hasNormals())
-        {
-            auto currentMainSegmentAngle = 0.0f;
-            for (auto i = 0; i <= _mainSegments; i++)
-            {
-                // Calculate sine and cosine of main segment angle
-                const auto sinMainSegment = sin(currentMainSegmentAngle);
-                const auto cosMainSegment = cos(currentMainSegmentAngle);
-                auto currentTubeSegmentAngle = 0.0f;
-                for (auto j = 0; j <= _tubeSegments; j++)
-                {
-                    // Calculate sine and cosine of tube segment angle
-                    const auto sinTubeSegment = sin(currentTubeSegmentAngle);
-                    const auto cosTubeSegment = cos(currentTubeSegmentAngle);
-
-                    auto normal = glm::vec3(
-                        cosMainSegment * cosTubeSegment,
-                        sinMainSegment * cosTubeSegment,
-                        sinTubeSegment
-                    );
-                    _vbo.addRawData(&normal, sizeof(glm::vec3));
-
-                    // Update current tube angle
-                    currentTubeSegmentAngle += tubeSegmentAngleStep;
-                }
-
-                // Update main segment angle
-                currentMainSegmentAngle += mainSegmentAngleStep;
-            }
+            vertex_kernels::fill(i * mainSegmentTextureStep, row.textureV.data(), row.size);
+            vertexWriter.writeRow(row);
         }
 
         // Finally, generate indices for rendering
+        auto index = _indicesVBO.reserveVertices<GLuint>(_numIndices).begin();
         GLuint currentVertexOffset = 0;
         for (auto i = 0; i < _mainSegments; i++)
         {
             for (auto j = 0; j <= _tubeSegments; j++)
             {
-                GLuint vertexIndexA = currentVertexOffset;
-                _indicesVBO.addRawData(&vertexIndexA, sizeof(GLuint));
-                GLuint vertexIndexB = currentVertexOffset + _tubeSegments + 1;
-                _indicesVBO.addRawData(&vertexIndexB, sizeof(GLuint));
+                *index++ = currentVertexOffset;
+                *index++ = currentVertexOffset + _tubeSegments + 1;
                 currentVertexOffset++;
             }
 
             // Don't restart primitive, if it's last segment, rendering ends here anyway
             if (i != _mainSegments - 1) {
-                _indicesVBO.addRawData(&_primitiveRestartIndex, sizeof(GLuint));
+                *index++ = _primitiveRestartIndex;
             }
         }
-
-        _vbo.bindVBO();
-        _vbo.uploadDataToGPU(GL_STATIC_DRAW);
-        setVertexAttributesPointers(_numVertices);
-
-        _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
-        _indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
-
-        _isInitialized = true;
     }
 
     void Torus::render() const
@@ -160,16 +87,27 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
-        // Enable primitive restart, because we're rendering several triangle strips (for each main segment)
-        glEnable(GL_PRIMITIVE_RESTART);
-        glPrimitiveRestartIndex(_primitiveRestartIndex);
+        GLStateCache::getInstance().bindVertexArray(_vao);
+        // Strips of main segments are separated by fixed restart index, which stays enabled (elided after first draw)
+        GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 
         // Render torus using precalculated indices
         glDrawElements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0);
+    }
+
+    void Torus::renderInstances(GLsizei instanceCount) const
+    {
+        // Strips of main segments are separated by fixed restart index, which stays enabled (elided after first draw)
+        GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 
-        // Disable primitive restart, we won't need it now
-        glDisable(GL_PRIMITIVE_RESTART);
+        // Render all instances of torus using precalculated indices
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0, instanceCount);
+    }
+
+    void Torus::getTriangleIndices(std::vector<GLuint>& indices) const
+    {
+        const auto torusIndices = readIndices();
+        appendStripTriangles(torusIndices.data(), torusIndices.size(), _primitiveRestartIndex, indices);
     }
 
     void Torus::renderPoints() const
@@ -178,7 +116,7 @@ namespace static_meshes_3D {
             return;
         }
 
-        glBindVertexArray(_vao);
+        GLStateCache::getInstance().bindVertexArray(_vao);
 
         // Render torus points only
         glDrawArrays(GL_POINTS, 0, _numVertices);
@@ -12,7 +12,7 @@ namespace static_meshes_3D {
     {
     public:
         Torus(int mainSegments, int tubeSegments, float mainRadius, float tubeRadius,
-            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+            bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true, bool isInitializationDeferred = false);
 
         void render() const override;
         void renderPoints() const override;
@@ -33,7 +33,9 @@ namespace static_meshes_3D {
         float _mainRadius; // Radius of torus (distance from center of torus to the center of tube)
         float _tubeRadius; // Radius of tube
 
-        void initializeData() override;
+        void generateData() override;
+        void renderInstances(GLsizei instanceCount) const override;
+        void getTriangleIndices(std::vector<GLuint>& indices) const override;
     };
 
 } // namespace static_meshes_3D
\ No newline at end of file
@@ -1,143 +1,157 @@
 #include <vector>
-#include <map>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 
 #include <glm/glm.hpp>
 
 #include "vboindexer.hpp"
 
-#include <string.h> // for memcmp
+namespace {
 
+// Vertices are snapped to a grid and merged, when they fall into the same cell, so that lookup can be hashed.
+// Merged vertices are always closer than the step, but vertices closer than the step are not merged,
+// if a cell boundary lies between them (the linear search used to merge everything within 0.01).
+// indexVBO merges only what differs by float noise, indexVBO_TBN uses 0.01 cells (tangents of merged
+// vertices are averaged).
+const float EXACT_QUANTIZATION_STEP = 1.0f / 16384.0f;
+const float TBN_QUANTIZATION_STEP = 0.01f;
 
-// Returns true iif v1 can be considered equal to v2
-bool is_near(float v1, float v2){
-	return fabs( v1-v2 ) < 0.01f;
-}
+// Grid coordinates must stay below this to convert to integer. Components beyond it (huge, infinite or NaN)
+// are far apart more than the step anyway, so they are stored as float bits above the grid range
+const int64_t MAX_GRID_COORDINATE = 4611686018427387904LL; // 2^62
 
-// Searches through all already-exported vertices
-// for a similar one.
-// Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
-	glm::vec3 & in_vertex, 
-	glm::vec2 & in_uv, 
-	glm::vec3 & in_normal, 
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	unsigned short & result
-){
-	// Lame linear search
-	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
-		if (
-			is_near( in_vertex.x , out_vertices[i].x ) &&
-			is_near( in_vertex.y , out_vertices[i].y ) &&
-			is_near( in_vertex.z , out_vertices[i].z ) &&
-			is_near( in_uv.x     , out_uvs     [i].x ) &&
-			is_near( in_uv.y     , out_uvs     [i].y ) &&
-			is_near( in_normal.x , out_normals [i].x ) &&
-			is_near( in_normal.y , out_normals [i].y ) &&
-			is_near( in_normal.z , out_normals [i].z )
-		){
-			result = i;
-			return true;
+// Hash table slot with no vertex
+const unsigned int EMPTY_SLOT = 0xFFFFFFFFu;
+
+// Position, UV and normal snapped to the grid
+struct QuantizedVertex{
+	int64_t components[8];
+
+	bool operator==(const QuantizedVertex & that) const{
+		for ( int i=0; i<8; i++ ){
+			if ( components[i] != that.components[i] )
+				return false;
 		}
+		return true;
 	}
-	// No other vertex could be used instead.
-	// Looks like we'll have to add it to the VBO.
-	return false;
-}
+};
 
-void indexVBO_slow(
-	std::vector<glm::vec3> & in_vertices,
-	std::vector<glm::vec2> & in_uvs,
-	std::vector<glm::vec3> & in_normals,
+QuantizedVertex quantizeVertex(const glm::vec3 & vertex, const glm::vec2 & uv, const glm::vec3 & normal, float inverseStep){
+	const float values[8] = { vertex.x, vertex.y, vertex.z, uv.x, uv.y, normal.x, normal.y, normal.z };
+	QuantizedVertex result;
+	for ( int i=0; i<8; i++ ){
+		const double scaled = (double)values[i] * inverseStep;
+		if ( !( std::fabs(scaled) < (double)MAX_GRID_COORDINATE ) ){
+			uint32_t bits;
+			memcpy( &bits, &values[i], sizeof(bits) );
+			result.components[i] = MAX_GRID_COORDINATE + 1 + bits;
+			continue;
+		}
+		// Rounding to nearest by truncation (much cheaper than floor)
+		result.components[i] = (int64_t)( scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5 );
+	}
+	return result;
+}
 
-	std::vector<unsigned short> & out_indices,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
+uint32_t hashVertex(const QuantizedVertex & vertex){
+	// FNV-1a over the components, finished with a multiplicative mix for the low bits
+	uint32_t hash = 2166136261u;
+	for ( int i=0; i<8; i++ ){
+		const uint64_t component = (uint64_t)vertex.components[i];
+		hash = ( hash ^ (uint32_t)component ) * 16777619u;
+		hash = ( hash ^ (uint32_t)( component >> 32 ) ) * 16777619u;
+	}
+	hash ^= hash >> 16;
+	hash *= 0x7feb352du;
+	hash ^= hash >> 15;
+	return hash;
+}
 
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+// Open addressing hash table from quantized vertex to its output index (linear probing).
+// Keys are not stored in the table, they are the quantized output vertices.
+class VertexIndexTable{
+public:
+	explicit VertexIndexTable(size_t numInputVertices){
+		// Indexed meshes usually share every vertex among several triangles, table grows if they don't
+		keys.reserve(numInputVertices / 4);
+		resize(numInputVertices / 2);
+	}
 
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
+	// Returns index of equal vertex, or adds the vertex under the next index and returns that
+	unsigned int findOrAdd(const QuantizedVertex & vertex, bool & found){
+		size_t slot = hashVertex(vertex) & mask;
+		while ( slots[slot] != EMPTY_SLOT ){
+			if ( keys[slots[slot]] == vertex ){
+				found = true;
+				return slots[slot];
+			}
+			slot = (slot + 1) & mask;
 		}
+
+		found = false;
+		const unsigned int index = (unsigned int)keys.size();
+		slots[slot] = index;
+		keys.push_back(vertex);
+		if ( keys.size() * 2 > slots.size() ) // keep it at most half full
+			resize(slots.size());
+		return index;
 	}
-}
 
-struct PackedVertex{
-	glm::vec3 position;
-	glm::vec2 uv;
-	glm::vec3 normal;
-	bool operator<(const PackedVertex that) const{
-		return memcmp((void*)this, (void*)&that, sizeof(PackedVertex))>0;
-	};
+private:
+	std::vector<unsigned int> slots;
+	std::vector<QuantizedVertex> keys;
+	size_t mask;
+
+	void resize(size_t minCapacity){
+		size_t capacity = 16;
+		while ( capacity <= minCapacity )
+			capacity *= 2;
+		slots.assign(capacity, EMPTY_SLOT);
+		mask = capacity - 1;
+
+		for ( unsigned int i=0; i<keys.size(); i++ ){
+			size_t slot = hashVertex(keys[i]) & mask;
+			while ( slots[slot] != EMPTY_SLOT )
+				slot = (slot + 1) & mask;
+			slots[slot] = i;
+		}
+	}
 };
 
-bool getSimilarVertexIndex_fast( 
-	PackedVertex & packed, 
-	std::map<PackedVertex,unsigned short> & VertexToOutIndex,
-	unsigned short & result
-){
-	std::map<PackedVertex,unsigned short>::iterator it = VertexToOutIndex.find(packed);
-	if ( it == VertexToOutIndex.end() ){
-		return false;
-	}else{
-		result = it->second;
-		return true;
-	}
-}
+} // unnamed namespace
 
 void indexVBO(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals
 ){
-	std::map<PackedVertex,unsigned short> VertexToOutIndex;
+	// Indices continue after vertices already in the output
+	const unsigned int baseIndex = (unsigned int)out_vertices.size();
+	VertexIndexTable table(in_vertices.size());
+	out_indices.reserve(out_indices.size() + in_vertices.size());
 
 	// For each input vertex
 	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
 
-		PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
-		
-
 		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex_fast( packed, VertexToOutIndex, index);
+		bool found;
+		unsigned int index = baseIndex + table.findOrAdd( quantizeVertex(in_vertices[i], in_uvs[i], in_normals[i], 1.0f / EXACT_QUANTIZATION_STEP), found );
 
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
+		if ( !found ){ // If not, it needs to be added in the output data.
 			out_vertices.push_back( in_vertices[i]);
 			out_uvs     .push_back( in_uvs[i]);
 			out_normals .push_back( in_normals[i]);
-			unsigned short newindex = (unsigned short)out_vertices.size() - 1;
-			out_indices .push_back( newindex );
-			VertexToOutIndex[ packed ] = newindex;
 		}
+		out_indices.push_back( index );
 	}
 }
 
-
-
-
-
-
-
 void indexVBO_TBN(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
@@ -145,23 +159,26 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & in_tangents,
 	std::vector<glm::vec3> & in_bitangents,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals,
 	std::vector<glm::vec3> & out_tangents,
 	std::vector<glm::vec3> & out_bitangents
 ){
+	// Indices continue after vertices already in the output
+	const unsigned int baseIndex = (unsigned int)out_vertices.size();
+	VertexIndexTable table(in_vertices.size());
+	out_indices.reserve(out_indices.size() + in_vertices.size());
+
 	// For each input vertex
 	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
 
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
+		// Try to find a vertex in the same 0.01 cell in out_XXXX
+		bool found;
+		unsigned int index = baseIndex + table.findOrAdd( quantizeVertex(in_vertices[i], in_uvs[i], in_normals[i], 1.0f / TBN_QUANTIZATION_STEP), found );
 
 		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-
 			// Average the tangents and the bitangents
 			out_tangents[index] += in_tangents[i];
 			out_bitangents[index] += in_bitangents[i];
@@ -171,7 +188,7 @@ void indexVBO_TBN(
 			out_normals .push_back( in_normals[i]);
 			out_tangents .push_back( in_tangents[i]);
 			out_bitangents .push_back( in_bitangents[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
 		}
+		out_indices.push_back( index );
 	}
 }
@@ -7,7 +7,7 @@ void indexVBO(
 	std::vector<glm::vec2>& in_uvs,
 	std::vector<glm::vec3>& in_normals,
 
-	std::vector<unsigned short>& out_indices,
+	std::vector<unsigned int>& out_indices,
 	std::vector<glm::vec3>& out_vertices,
 	std::vector<glm::vec2>& out_uvs,
 	std::vector<glm::vec3>& out_normals
@@ -21,7 +21,7 @@ void indexVBO_TBN(
 	std::vector<glm::vec3>& in_tangents,
 	std::vector<glm::vec3>& in_bitangents,
 
-	std::vector<unsigned short>& out_indices,
+	std::vector<unsigned int>& out_indices,
 	std::vector<glm::vec3>& out_vertices,
 	std::vector<glm::vec2>& out_uvs,
 	std::vector<glm::vec3>& out_normals,
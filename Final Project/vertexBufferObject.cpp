@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "common/vertextBufferObject.h"
+#include "geometryStore.h"
 
 
 void VertexBufferObject::createVBO(uint32_t reserveSizeBytes)
@@ -10,7 +13,7 @@ void VertexBufferObject::createVBO(uint32_t reserveSizeBytes)
 		return;
 	}
 
-	glGenBuffers(1, &_bufferID);
+	// Buffer name is generated on first bind, shared uploads don't need one at all
 	_rawData.reserve(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
 
 	_isBufferCreated = true;
@@ -24,27 +27,35 @@ void VertexBufferObject::bindVBO(GLenum bufferType)
 		return;
 	}
 
+	if (_bufferID == 0) {
+		glGenBuffers(1, &_bufferID);
+	}
+
 	_bufferType = bufferType;
 	glBindBuffer(_bufferType, _bufferID);
 }
 
 void VertexBufferObject::addRawData(const void* ptrData, uint32_t dataSize, int repeat)
 {
-	const auto bytesToAdd = dataSize * repeat;
-	if (_bytesAdded + bytesToAdd > _rawData.capacity())
+	auto destination = static_cast<unsigned char*>(reserveRawData(dataSize * repeat));
+	for (int i = 0; i < repeat; i++)
 	{
-		const auto newCapacity = _rawData.capacity() * 2;
-		std::vector<unsigned char> newRawData;
-		newRawData.reserve(newCapacity);
-		memcpy(newRawData.data(), _rawData.data(), _bytesAdded);
-		_rawData = std::move(newRawData);
+		memcpy(destination, ptrData, dataSize);
+		destination += dataSize;
 	}
+}
 
-	for (int i = 0; i < repeat; i++)
-	{
-		memcpy(_rawData.data() + _bytesAdded, ptrData, dataSize);
-		_bytesAdded += dataSize;
+void* VertexBufferObject::reserveRawData(uint32_t dataSizeBytes)
+{
+	// Grow geometrically, but always at least to the required size
+	const auto oldSize = _rawData.size();
+	const auto requiredSize = oldSize + dataSizeBytes;
+	if (requiredSize > _rawData.capacity()) {
+		_rawData.reserve(std::max(requiredSize, _rawData.capacity() * 2));
 	}
+
+	_rawData.resize(requiredSize);
+	return _rawData.data() + oldSize;
 }
 
 void* VertexBufferObject::getRawDataPointer()
@@ -52,6 +63,11 @@ void* VertexBufferObject::getRawDataPointer()
 	return _rawData.data();
 }
 
+const void* VertexBufferObject::getRawDataPointer() const
+{
+	return _rawData.data();
+}
+
 void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
 {
 	if (!_isBufferCreated)
@@ -60,10 +76,61 @@ void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
 		return;
 	}
 
-	glBufferData(_bufferType, _bytesAdded, _rawData.data(), usageHint);
+	glBufferData(_bufferType, _rawData.size(), _rawData.data(), usageHint);
+	_isDataUploaded = true;
+	_uploadedDataSize = static_cast<uint32_t>(_rawData.size());
+	_rawData.clear();
+}
+
+void VertexBufferObject::uploadDataToGPUShared(GLenum bufferType, GLenum usageHint)
+{
+	if (!_isBufferCreated)
+	{
+		std::cout << "This buffer is not created yet! Call createVBO before uploading data to GPU!" << std::endl;
+		return;
+	}
+
+	// Shared buffer gets bound by the geometry store, previous buffer (if any) is replaced by it
+	_bufferType = bufferType;
+	const auto sharedBufferID = static_meshes_3D::GeometryStore::getInstance().acquire(_bufferType, _rawData.data(), _rawData.size(), usageHint);
+	if (_isShared) {
+		static_meshes_3D::GeometryStore::getInstance().release(_bufferID);
+	}
+	else if (_bufferID != 0) {
+		glDeleteBuffers(1, &_bufferID);
+	}
+
+	_bufferID = sharedBufferID;
+	_isShared = true;
+	_isDataUploaded = true;
+	_uploadedDataSize = static_cast<uint32_t>(_rawData.size());
+	_rawData.clear();
+}
+
+void* VertexBufferObject::mapRawDataForWriting(uint32_t dataSizeBytes, GLenum usageHint)
+{
+	if (!_isBufferCreated)
+	{
+		std::cout << "This buffer is not created yet! Call createVBO before mapping it!" << std::endl;
+		return nullptr;
+	}
+
+	if (_isShared)
+	{
+		std::cout << "This buffer is shared through the geometry store! It cannot be written to!" << std::endl;
+		return nullptr;
+	}
+
+	// Allocating new storage orphans the old one, so GPU can keep reading it while we write
+	glBufferData(_bufferType, dataSizeBytes, nullptr, usageHint);
 	_isDataUploaded = true;
-	_uploadedDataSize = _bytesAdded;
-	_bytesAdded = 0;
+	_uploadedDataSize = dataSizeBytes;
+	_rawData.clear();
+	if (dataSizeBytes == 0) {
+		return nullptr;
+	}
+
+	return glMapBufferRange(_bufferType, 0, dataSizeBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
 }
 
 void* VertexBufferObject::mapBufferToMemory(GLenum usageHint)
@@ -91,21 +158,50 @@ void VertexBufferObject::unmapBuffer()
 	glUnmapBuffer(_bufferType);
 }
 
-GLuint VertexBufferObject::getBufferID()
+GLuint VertexBufferObject::getBufferID() const
 {
 	return _bufferID;
 }
 
-uint32_t VertexBufferObject::getBufferSize()
+uint32_t VertexBufferObject::getBufferSize() const
 {
-	return _isDataUploaded ? _uploadedDataSize : _bytesAdded;
+	return _isDataUploaded ? _uploadedDataSize : static_cast<uint32_t>(_rawData.size());
+}
+
+std::vector<unsigned char> VertexBufferObject::getUploadedData() const
+{
+	if (!_isDataUploaded) {
+		return std::vector<unsigned char>();
+	}
+
+	if (_isShared)
+	{
+		const auto storedData = static_meshes_3D::GeometryStore::getInstance().getData(_bufferID);
+		if (storedData != nullptr) {
+			return *storedData;
+		}
+	}
+
+	// Read back through copy read target, so that no VAO state is touched
+	std::vector<unsigned char> data(_uploadedDataSize);
+	glBindBuffer(GL_COPY_READ_BUFFER, _bufferID);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, data.size(), data.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return data;
 }
 
 void VertexBufferObject::deleteVBO()
 {
 	if (_isBufferCreated)
 	{
-		glDeleteBuffers(1, &_bufferID);
+		if (_isShared) {
+			static_meshes_3D::GeometryStore::getInstance().release(_bufferID);
+		}
+		else if (_bufferID != 0) {
+			glDeleteBuffers(1, &_bufferID);
+		}
+		_bufferID = 0;
+		_isShared = false;
 		_isDataUploaded = false;
 		_isBufferCreated = false;
 	}
@@ -0,0 +1,106 @@
+#pragma once
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace static_meshes_3D {
+
+    /**
+     * Encoding and decoding of compressed vertex attributes (see VertexFormat::Compressed).
+     * Positions are 16-bit unsigned normalized within mesh bounding box, texture coordinates
+     * are half floats and normals are octahedral-encoded in x and y of GL_INT_2_10_10_10_REV.
+     */
+    namespace vertex_compression {
+
+        /**
+         * Position quantized to the bounding box (w is padding, so that attribute stays 4-byte aligned).
+         */
+        struct EncodedPosition
+        {
+            uint16_t x, y, z, w;
+        };
+
+        /**
+         * Quantizes position relative to the bounding box.
+         *
+         * @param position      Position inside the bounding box
+         * @param boundsMin     Minimal corner of the bounding box (position bias)
+         * @param inverseScale  Reciprocal of bounding box extent (0 for flat dimensions)
+         */
+        inline EncodedPosition encodePosition(const glm::vec3& position, const glm::vec3& boundsMin, const glm::vec3& inverseScale)
+        {
+            const auto quantize = [](float value) {
+                return static_cast<uint16_t>(std::lround(std::min(1.0f, std::max(0.0f, value)) * 65535.0f));
+            };
+
+            return EncodedPosition{
+                quantize((position.x - boundsMin.x) * inverseScale.x),
+                quantize((position.y - boundsMin.y) * inverseScale.y),
+                quantize((position.z - boundsMin.z) * inverseScale.z),
+                0
+            };
+        }
+
+        inline glm::vec3 decodePosition(const EncodedPosition& encoded, const glm::vec3& boundsMin, const glm::vec3& scale)
+        {
+            return boundsMin + scale * (glm::vec3(encoded.x, encoded.y, encoded.z) / 65535.0f);
+        }
+
+        inline uint32_t encodeTextureCoordinate(const glm::vec2& textureCoordinate)
+        {
+            return glm::packHalf2x16(textureCoordinate);
+        }
+
+        inline glm::vec2 decodeTextureCoordinate(uint32_t encoded)
+        {
+            return glm::unpackHalf2x16(encoded);
+        }
+
+        /**
+         * Encodes unit normal with octahedral mapping - normal is projected onto octahedron,
+         * whose lower half is folded over the upper one, giving two coordinates in [-1, 1].
+         */
+        inline uint32_t encodeNormal(const glm::vec3& normal)
+        {
+            const auto signNotZero = [](float value) { return value >= 0.0f ? 1.0f : -1.0f; };
+
+            const auto projected = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+            auto x = projected.x;
+            auto y = projected.y;
+            if (projected.z < 0.0f)
+            {
+                x = (1.0f - std::abs(projected.y)) * signNotZero(projected.x);
+                y = (1.0f - std::abs(projected.x)) * signNotZero(projected.y);
+            }
+
+            // Signed normalized 10-bit components, z and w stay zero
+            const auto quantize = [](float value) {
+                return static_cast<uint32_t>(std::lround(std::min(1.0f, std::max(-1.0f, value)) * 511.0f)) & 0x3FF;
+            };
+            return quantize(x) | (quantize(y) << 10);
+        }
+
+        inline glm::vec3 decodeNormal(uint32_t encoded)
+        {
+            const auto dequantize = [](uint32_t bits) {
+                const auto value = static_cast<int>(bits & 0x200 ? bits | ~0x3FFu : bits);
+                return std::max(-1.0f, value / 511.0f);
+            };
+
+            auto normal = glm::vec3(dequantize(encoded & 0x3FF), dequantize((encoded >> 10) & 0x3FF), 0.0f);
+            normal.z = 1.0f - std::abs(normal.x) - std::abs(normal.y);
+            const auto fold = std::max(-normal.z, 0.0f);
+            normal.x += normal.x >= 0.0f ? -fold : fold;
+            normal.y += normal.y >= 0.0f ? -fold : fold;
+            return glm::normalize(normal);
+        }
+
+    } // namespace vertex_compression
+
+} // namespace static_meshes_3D
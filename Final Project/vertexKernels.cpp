@@ -0,0 +1,353 @@
+// STL
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// Project
+#include "vertexKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VERTEX_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics of any instruction set, GCC and Clang need them enabled per function
+#if defined(VERTEX_KERNELS_X86) && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace static_meshes_3D {
+namespace vertex_kernels {
+
+    namespace {
+
+        typedef void (*AffineKernel)(const float*, float, float, float*, int);
+        typedef void (*RampKernel)(float, float, float*, int);
+        typedef void (*FillKernel)(float, float*, int);
+        typedef void (*RotateKernel)(const float*, const float*, float, float, float*, float*, int);
+
+        // Angle table is computed in blocks, each rotated from exact sine and cosine of its first angle
+        const int ANGLE_BLOCK_SIZE = 8;
+
+        void affineScalar(const float* input, float scale, float bias, float* output, int count)
+        {
+            for (auto i = 0; i < count; i++) {
+                output[i] = input[i] * scale + bias;
+            }
+        }
+
+        void rampScalar(float start, float step, float* output, int count)
+        {
+            for (auto i = 0; i < count; i++) {
+                output[i] = start + i * step;
+            }
+        }
+
+        void fillScalar(float value, float* output, int count)
+        {
+            for (auto i = 0; i < count; i++) {
+                output[i] = value;
+            }
+        }
+
+        // Computes sines and cosines of angles base + offset[i] by angle sum identities
+        void rotateScalar(const float* offsetSines, const float* offsetCosines, float baseSine, float baseCosine,
+            float* sines, float* cosines, int count)
+        {
+            for (auto i = 0; i < count; i++)
+            {
+                sines[i] = baseSine * offsetCosines[i] + baseCosine * offsetSines[i];
+                cosines[i] = baseCosine * offsetCosines[i] - baseSine * offsetSines[i];
+            }
+        }
+
+#ifdef VERTEX_KERNELS_X86
+        // Vector loops handle whole vectors only, the rest is finished by scalar kernels
+
+        TARGET_SSE2 void affineSSE2(const float* input, float scale, float bias, float* output, int count)
+        {
+            const auto scaleVector = _mm_set1_ps(scale);
+            const auto biasVector = _mm_set1_ps(bias);
+            auto i = 0;
+            for (; i + 4 <= count; i += 4) {
+                _mm_storeu_ps(output + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(input + i), scaleVector), biasVector));
+            }
+            affineScalar(input + i, scale, bias, output + i, count - i);
+        }
+
+        TARGET_SSE2 void rampSSE2(float start, float step, float* output, int count)
+        {
+            const auto stepVector = _mm_set1_ps(step);
+            const auto startVector = _mm_set1_ps(start);
+            const auto indexStep = _mm_set1_ps(4.0f);
+            auto index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+            auto i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(output + i, _mm_add_ps(startVector, _mm_mul_ps(index, stepVector)));
+                index = _mm_add_ps(index, indexStep);
+            }
+            rampScalar(start + i * step, step, output + i, count - i);
+        }
+
+        TARGET_SSE2 void fillSSE2(float value, float* output, int count)
+        {
+            const auto valueVector = _mm_set1_ps(value);
+            auto i = 0;
+            for (; i + 4 <= count; i += 4) {
+                _mm_storeu_ps(output + i, valueVector);
+            }
+            fillScalar(value, output + i, count - i);
+        }
+
+        TARGET_SSE2 void rotateSSE2(const float* offsetSines, const float* offsetCosines, float baseSine, float baseCosine,
+            float* sines, float* cosines, int count)
+        {
+            const auto baseSineVector = _mm_set1_ps(baseSine);
+            const auto baseCosineVector = _mm_set1_ps(baseCosine);
+            auto i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto offsetSine = _mm_loadu_ps(offsetSines + i);
+                const auto offsetCosine = _mm_loadu_ps(offsetCosines + i);
+                _mm_storeu_ps(sines + i, _mm_add_ps(_mm_mul_ps(baseSineVector, offsetCosine), _mm_mul_ps(baseCosineVector, offsetSine)));
+                _mm_storeu_ps(cosines + i, _mm_sub_ps(_mm_mul_ps(baseCosineVector, offsetCosine), _mm_mul_ps(baseSineVector, offsetSine)));
+            }
+            rotateScalar(offsetSines + i, offsetCosines + i, baseSine, baseCosine, sines + i, cosines + i, count - i);
+        }
+
+        TARGET_AVX2 void affineAVX2(const float* input, float scale, float bias, float* output, int count)
+        {
+            const auto scaleVector = _mm256_set1_ps(scale);
+            const auto biasVector = _mm256_set1_ps(bias);
+            auto i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(output + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(input + i), scaleVector), biasVector));
+            }
+            affineScalar(input + i, scale, bias, output + i, count - i);
+        }
+
+        TARGET_AVX2 void rampAVX2(float start, float step, float* output, int count)
+        {
+            const auto stepVector = _mm256_set1_ps(step);
+            const auto startVector = _mm256_set1_ps(start);
+            const auto indexStep = _mm256_set1_ps(8.0f);
+            auto index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            auto i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                _mm256_storeu_ps(output + i, _mm256_add_ps(startVector, _mm256_mul_ps(index, stepVector)));
+                index = _mm256_add_ps(index, indexStep);
+            }
+            rampScalar(start + i * step, step, output + i, count - i);
+        }
+
+        TARGET_AVX2 void fillAVX2(float value, float* output, int count)
+        {
+            const auto valueVector = _mm256_set1_ps(value);
+            auto i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(output + i, valueVector);
+            }
+            fillScalar(value, output + i, count - i);
+        }
+
+        TARGET_AVX2 void rotateAVX2(const float* offsetSines, const float* offsetCosines, float baseSine, float baseCosine,
+            float* sines, float* cosines, int count)
+        {
+            const auto baseSineVector = _mm256_set1_ps(baseSine);
+            const auto baseCosineVector = _mm256_set1_ps(baseCosine);
+            auto i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto offsetSine = _mm256_loadu_ps(offsetSines + i);
+                const auto offsetCosine = _mm256_loadu_ps(offsetCosines + i);
+                _mm256_storeu_ps(sines + i, _mm256_add_ps(_mm256_mul_ps(baseSineVector, offsetCosine), _mm256_mul_ps(baseCosineVector, offsetSine)));
+                _mm256_storeu_ps(cosines + i, _mm256_sub_ps(_mm256_mul_ps(baseCosineVector, offsetCosine), _mm256_mul_ps(baseSineVector, offsetSine)));
+            }
+            rotateScalar(offsetSines + i, offsetCosines + i, baseSine, baseCosine, sines + i, cosines + i, count - i);
+        }
+
+        void cpuid(int leaf, int subleaf, unsigned int registers[4])
+        {
+#ifdef _MSC_VER
+            int values[4];
+            __cpuidex(values, leaf, subleaf);
+            for (auto i = 0; i < 4; i++) {
+                registers[i] = static_cast<unsigned int>(values[i]);
+            }
+#else
+            __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+        }
+
+        bool isAVX2Supported()
+        {
+            unsigned int registers[4];
+            cpuid(0, 0, registers);
+            if (registers[0] < 7) {
+                return false;
+            }
+
+            // CPU must have AVX and OS must save YMM registers on context switch
+            cpuid(1, 0, registers);
+            const auto hasOSXSave = (registers[2] & (1u << 27)) != 0;
+            const auto hasAVX = (registers[2] & (1u << 28)) != 0;
+            if (!hasOSXSave || !hasAVX) {
+                return false;
+            }
+
+#ifdef _MSC_VER
+            const auto enabledStates = _xgetbv(0);
+#else
+            unsigned int eax, edx;
+            __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            const auto enabledStates = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+            if ((enabledStates & 0x6) != 0x6) {
+                return false;
+            }
+
+            cpuid(7, 0, registers);
+            return (registers[1] & (1u << 5)) != 0;
+        }
+#endif
+
+        /**
+         * Kernels of one instruction set.
+         */
+        struct KernelTable
+        {
+            InstructionSet instructionSet;
+            AffineKernel affine;
+            RampKernel ramp;
+            FillKernel fill;
+            RotateKernel rotate;
+        };
+
+        KernelTable createKernelTable(InstructionSet instructionSet)
+        {
+            switch (instructionSet)
+            {
+#ifdef VERTEX_KERNELS_X86
+            case InstructionSet::AVX2:
+                return KernelTable{ InstructionSet::AVX2, affineAVX2, rampAVX2, fillAVX2, rotateAVX2 };
+            case InstructionSet::SSE2:
+                return KernelTable{ InstructionSet::SSE2, affineSSE2, rampSSE2, fillSSE2, rotateSSE2 };
+#endif
+            default:
+                return KernelTable{ InstructionSet::Scalar, affineScalar, rampScalar, fillScalar, rotateScalar };
+            }
+        }
+
+        const KernelTable& getKernelTable(InstructionSet instructionSet)
+        {
+            // Tables never change after creation, so they can be read from any thread
+            static const KernelTable kernelTables[] = {
+                createKernelTable(InstructionSet::Scalar),
+                createKernelTable(InstructionSet::SSE2),
+                createKernelTable(InstructionSet::AVX2)
+            };
+            return kernelTables[static_cast<int>(instructionSet)];
+        }
+
+        std::atomic<const KernelTable*>& getActiveKernelTable()
+        {
+            static std::atomic<const KernelTable*> activeKernelTable(&getKernelTable(getSupportedInstructionSet()));
+            return activeKernelTable;
+        }
+
+        const KernelTable& getKernels()
+        {
+            // Switching instruction set only swaps the pointer, kernels running on workers finish with the old table
+            return *getActiveKernelTable().load(std::memory_order_acquire);
+        }
+
+    } // unnamed namespace
+
+    InstructionSet getSupportedInstructionSet()
+    {
+#ifdef VERTEX_KERNELS_X86
+        // SSE2 is part of x86-64, 32-bit builds are assumed to run on CPUs from this century
+        static const auto supportedInstructionSet = isAVX2Supported() ? InstructionSet::AVX2 : InstructionSet::SSE2;
+        return supportedInstructionSet;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    InstructionSet getInstructionSet()
+    {
+        return getKernels().instructionSet;
+    }
+
+    void setInstructionSet(InstructionSet instructionSet)
+    {
+        if (static_cast<int>(instructionSet) > static_cast<int>(getSupportedInstructionSet())) {
+            instructionSet = getSupportedInstructionSet();
+        }
+
+        getActiveKernelTable().store(&getKernelTable(instructionSet), std::memory_order_release);
+    }
+
+    const char* getInstructionSetName(InstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+        case InstructionSet::SSE2:
+            return "SSE2";
+        case InstructionSet::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+        }
+    }
+
+    void affine(const float* input, float scale, float bias, float* output, int count)
+    {
+        getKernels().affine(input, scale, bias, output, count);
+    }
+
+    void ramp(float start, float step, float* output, int count)
+    {
+        getKernels().ramp(start, step, output, count);
+    }
+
+    void fill(float value, float* output, int count)
+    {
+        getKernels().fill(value, output, count);
+    }
+
+    void computeAngleTable(float startAngle, float angleStep, int count, std::vector<float>& sines, std::vector<float>& cosines)
+    {
+        // Only the first angle of every block is computed from index, so that error doesn't accumulate
+        // along the table, the rest of the block is rotated from it by vector kernel
+        float offsetSines[ANGLE_BLOCK_SIZE], offsetCosines[ANGLE_BLOCK_SIZE];
+        for (auto i = 0; i < ANGLE_BLOCK_SIZE; i++)
+        {
+            offsetSines[i] = std::sin(i * angleStep);
+            offsetCosines[i] = std::cos(i * angleStep);
+        }
+
+        sines.resize(count);
+        cosines.resize(count);
+        const auto& kernels = getKernels();
+        for (auto i = 0; i < count; i += ANGLE_BLOCK_SIZE)
+        {
+            const auto angle = startAngle + i * angleStep;
+            kernels.rotate(offsetSines, offsetCosines, std::sin(angle), std::cos(angle),
+                sines.data() + i, cosines.data() + i, std::min(ANGLE_BLOCK_SIZE, count - i));
+        }
+    }
+
+} // namespace vertex_kernels
+} // namespace static_meshes_3D
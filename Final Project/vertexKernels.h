@@ -0,0 +1,89 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+namespace static_meshes_3D {
+
+    /**
+     * One row of generated vertices with attributes stored as separate arrays (structure of arrays),
+     * so that vertex kernels can compute many vertices at once.
+     */
+    struct VertexRow
+    {
+        explicit VertexRow(int size)
+            : size(size)
+            , positionX(size), positionY(size), positionZ(size)
+            , textureU(size), textureV(size)
+            , normalX(size), normalY(size), normalZ(size) {}
+
+        glm::vec3 getPosition(int index) const { return glm::vec3(positionX[index], positionY[index], positionZ[index]); }
+        glm::vec2 getTextureCoordinate(int index) const { return glm::vec2(textureU[index], textureV[index]); }
+        glm::vec3 getNormal(int index) const { return glm::vec3(normalX[index], normalY[index], normalZ[index]); }
+
+        int size; // Number of vertices in the row
+        std::vector<float> positionX, positionY, positionZ; // Vertex positions
+        std::vector<float> textureU, textureV; // Texture coordinates
+        std::vector<float> normalX, normalY, normalZ; // Vertex normals
+    };
+
+    /**
+     * Vectorised kernels generating rows of vertex attributes. Every kernel has scalar, SSE2 and
+     * AVX2 implementation, the best one supported by the CPU is selected at runtime.
+     */
+    namespace vertex_kernels {
+
+        enum class InstructionSet
+        {
+            Scalar, // Plain C++, works everywhere
+            SSE2, // 4 floats at once
+            AVX2 // 8 floats at once
+        };
+
+        /**
+         * Gets best instruction set supported by the CPU (and OS).
+         */
+        InstructionSet getSupportedInstructionSet();
+
+        /**
+         * Gets instruction set used by the kernels.
+         */
+        InstructionSet getInstructionSet();
+
+        /**
+         * Forces instruction set used by the kernels (limited to the supported one), mainly for benchmarking.
+         * Safe while kernels run on other threads, calls already running finish with the previous kernels.
+         */
+        void setInstructionSet(InstructionSet instructionSet);
+
+        /**
+         * Gets human readable name of the instruction set.
+         */
+        const char* getInstructionSetName(InstructionSet instructionSet);
+
+        /**
+         * Computes output[i] = input[i] * scale + bias.
+         */
+        void affine(const float* input, float scale, float bias, float* output, int count);
+
+        /**
+         * Computes output[i] = start + i * step.
+         */
+        void ramp(float start, float step, float* output, int count);
+
+        /**
+         * Computes output[i] = value.
+         */
+        void fill(float value, float* output, int count);
+
+        /**
+         * Computes sines and cosines of angles start + i * step, for i from 0 to count - 1.
+         */
+        void computeAngleTable(float startAngle, float angleStep, int count, std::vector<float>& sines, std::vector<float>& cosines);
+
+    } // namespace vertex_kernels
+
+} // namespace static_meshes_3D